@@ -0,0 +1,230 @@
+/*
+ * C++ implementation of miss attribution
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include "attribution.h"
+
+namespace {
+
+const size_t INITIAL_PC_SLOTS = 1024;
+
+bool parse_address(const std::string &text, uint64_t &value) {
+    if (text.empty() || text[0] == '-') {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    value = std::strtoull(text.c_str(), &end, 16);
+    return *end == '\0' && errno == 0;
+}
+
+/**
+ * Prints one table row: "  key: A accesses, H hits, M misses (m.mm%), W writebacks".
+ */
+void print_counts(std::ostream &out, const std::string &key, const Attribution_Counts &counts) {
+    out << "  " << key << ": " << counts.accesses << " accesses, " << counts.accesses - counts.misses
+        << " hits, " << counts.misses << " misses ("
+        << (counts.accesses > 0 ? 100.0 * counts.misses / counts.accesses : 0.0) << "%), "
+        << counts.writebacks << " writebacks\n";
+}
+
+/**
+ * Orders by misses, then writebacks, most first.
+ */
+bool more_misses(const Attribution_Counts &a, const Attribution_Counts &b) {
+    if (a.misses != b.misses) {
+        return a.misses > b.misses;
+    }
+    return a.writebacks > b.writebacks;
+}
+
+}
+
+Miss_Attribution::Miss_Attribution()
+    : region_counts(1, Attribution_Counts()), last_region(0), by_pc(false), num_pcs(0), pc_shift(0),
+      region(nullptr), pc(nullptr) {
+}
+
+/**
+ * Reads regions from a file, one "start end name" per line with start and
+ * end (exclusive) in hex, e.g. "0x601040 0x681040 particles" (a symbol
+ * table converted with its sizes will do). Blank lines and lines starting
+ * with # are ignored.
+ *
+ * @return false if the file cannot be read or a line is invalid
+ */
+bool Miss_Attribution::load_regions(const char *path, std::string &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "could not open region map " + std::string(path) + ".";
+        return false;
+    }
+    std::string line;
+    unsigned line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        std::string start, end, name, extra;
+        if (!(fields >> start) || start[0] == '#') {
+            continue;
+        }
+        Region added;
+        std::ostringstream where;
+        where << path << ":" << line_number;
+        if (!(fields >> end >> name) || (fields >> extra) || !parse_address(start, added.start)
+            || !parse_address(end, added.end)) {
+            error = "region map line must be \"start end name\" at " + where.str() + ".";
+            return false;
+        }
+        if (added.end <= added.start) {
+            error = "region map range is empty at " + where.str() + ".";
+            return false;
+        }
+        added.name = name;
+        regions.push_back(added);
+    }
+    std::sort(regions.begin(), regions.end(), [](const Region &a, const Region &b) { return a.start < b.start; });
+    for (size_t i = 1; i < regions.size(); i++) {
+        if (regions[i].start < regions[i - 1].end) {
+            error = "regions " + regions[i - 1].name + " and " + regions[i].name + " overlap.";
+            return false;
+        }
+    }
+    region_counts.assign(regions.size() + 1, Attribution_Counts());
+    last_region = regions.size();
+    return true;
+}
+
+/**
+ * Counts by the pc of each record as well.
+ */
+void Miss_Attribution::enable_pcs() {
+    by_pc = true;
+    pc_slots.assign(INITIAL_PC_SLOTS, Pc_Slot());
+    pc_shift = 64 - __builtin_ctzll(INITIAL_PC_SLOTS);
+    num_pcs = 0;
+}
+
+/**
+ * @return the index of the region holding address, or regions.size() if none does
+ */
+size_t Miss_Attribution::find_region(uint64_t address) const {
+    // the last region starting at or below the address
+    auto it = std::upper_bound(regions.begin(), regions.end(), address,
+                               [](uint64_t a, const Region &r) { return a < r.start; });
+    if (it != regions.begin() && address < (it - 1)->end) {
+        return it - 1 - regions.begin();
+    }
+    return regions.size();
+}
+
+/**
+ * @return the counters of a pc, added if it is new
+ */
+Attribution_Counts &Miss_Attribution::find_pc(uint64_t key) {
+    size_t mask = pc_slots.size() - 1;
+    size_t i = (key * 0x9e3779b97f4a7c15ULL) >> pc_shift; // Fibonacci hashing
+    while (pc_slots[i].counts.accesses != 0) {
+        if (pc_slots[i].pc == key) {
+            return pc_slots[i].counts;
+        }
+        i = (i + 1) & mask;
+    }
+    // a new pc: begin() counts its first access right away, claiming the slot
+    if (2 * (num_pcs + 1) > pc_slots.size()) {
+        grow_pcs();
+        return find_pc(key);
+    }
+    num_pcs++;
+    pc_slots[i].pc = key;
+    return pc_slots[i].counts;
+}
+
+/**
+ * Doubles the pc table and reinserts every pc.
+ */
+void Miss_Attribution::grow_pcs() {
+    std::vector<Pc_Slot> old(pc_slots.size() * 2, Pc_Slot());
+    old.swap(pc_slots);
+    pc_shift--;
+    size_t mask = pc_slots.size() - 1;
+    for (const Pc_Slot &slot : old) {
+        if (slot.counts.accesses == 0) {
+            continue;
+        }
+        size_t i = (slot.pc * 0x9e3779b97f4a7c15ULL) >> pc_shift;
+        while (pc_slots[i].counts.accesses != 0) {
+            i = (i + 1) & mask;
+        }
+        pc_slots[i] = slot;
+    }
+}
+
+/**
+ * Prints the regions and the pcs with the most misses, most first.
+ *
+ * @param out the stream to print to
+ * @param top the number of regions and of pcs to print
+ */
+void Miss_Attribution::print(std::ostream &out, size_t top) const {
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << std::fixed << std::setprecision(2);
+    if (!regions.empty()) {
+        std::vector<size_t> order;
+        for (size_t i = 0; i < region_counts.size(); i++) {
+            if (region_counts[i].accesses > 0 || region_counts[i].writebacks > 0) {
+                order.push_back(i);
+            }
+        }
+        std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+            return more_misses(region_counts[a], region_counts[b]);
+        });
+        if (order.size() > top) {
+            order.resize(top);
+        }
+        out << "Regions by misses: " << order.size() << "\n";
+        for (size_t i : order) {
+            std::ostringstream key;
+            if (i == regions.size()) {
+                key << "(unmapped)";
+            } else {
+                key << regions[i].name << " [0x" << std::hex << regions[i].start << ", 0x" << regions[i].end << ")";
+            }
+            print_counts(out, key.str(), region_counts[i]);
+        }
+    }
+    if (by_pc) {
+        std::vector<const Pc_Slot *> order;
+        for (const Pc_Slot &slot : pc_slots) {
+            if (slot.counts.accesses > 0) {
+                order.push_back(&slot);
+            }
+        }
+        std::sort(order.begin(), order.end(), [](const Pc_Slot *a, const Pc_Slot *b) {
+            if (a->counts.misses != b->counts.misses || a->counts.writebacks != b->counts.writebacks) {
+                return more_misses(a->counts, b->counts);
+            }
+            return a->pc < b->pc;
+        });
+        out << "Distinct pcs: " << order.size() << "\n";
+        if (order.size() > top) {
+            order.resize(top);
+        }
+        out << "Pcs by misses: " << order.size() << "\n";
+        for (const Pc_Slot *slot : order) {
+            std::ostringstream key;
+            key << "0x" << std::hex << slot->pc;
+            print_counts(out, key.str(), slot->counts);
+        }
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
@@ -0,0 +1,151 @@
+/*
+ * h file for miss attribution
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef ATTRIBUTION_H
+#define ATTRIBUTION_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+/*
+ * Accesses, misses and dirty writebacks charged to one region or pc. Hits
+ * are accesses - misses.
+ */
+struct Attribution_Counts {
+    uint64_t accesses, misses, writebacks;
+};
+
+/*
+ * Splits the counters of a Cache_Simulator by address region and by the pc
+ * (third field) of each trace record. The cache reports every access made
+ * through access_batch(), its misses and the dirty blocks it writes back.
+ *
+ * An access and its miss are charged to the region of its address and to its
+ * pc. A writeback is charged to the region of the block written back (the
+ * data structure that was dirtied) and to the pc of the access whose fill
+ * evicted it.
+ *
+ * Regions come from a map file and are looked up by binary search (after
+ * checking the region of the previous access). Pcs are counted in an open
+ * addressing table with linear probing: 32 bytes per pc, with no pointers
+ * and no allocation per access.
+ */
+class Miss_Attribution {
+private:
+    struct Region {
+        uint64_t start, end; // [start, end)
+        std::string name;
+    };
+
+    struct Pc_Slot {
+        uint64_t pc;
+        Attribution_Counts counts; // accesses == 0 marks an empty slot
+    };
+
+    std::vector<Region> regions;                // sorted, not overlapping
+    std::vector<Attribution_Counts> region_counts; // per region, then addresses outside every region
+    size_t last_region;
+    bool by_pc;
+    std::vector<Pc_Slot> pc_slots; // a power of 2 long, at most half full
+    size_t num_pcs;
+    unsigned pc_shift;
+    Attribution_Counts *region, *pc; // of the current access
+
+    size_t find_region(uint64_t address) const;
+    Attribution_Counts &find_pc(uint64_t key);
+    void grow_pcs();
+
+public:
+    Miss_Attribution();
+
+    /**
+     * Reads regions from a file, one "start end name" per line with start and
+     * end (exclusive) in hex, e.g. "0x601040 0x681040 particles" (a symbol
+     * table converted with its sizes will do). Blank lines and lines starting
+     * with # are ignored.
+     *
+     * @return false if the file cannot be read or a line is invalid
+     */
+    bool load_regions(const char *path, std::string &error);
+
+    /**
+     * Counts by the pc of each record as well.
+     */
+    void enable_pcs();
+
+    /**
+     * @return true if accesses are counted by region or by pc
+     */
+    bool enabled() const { return !regions.empty() || by_pc; }
+
+    /**
+     * @return true if accesses are counted by pc, so the trace must keep them
+     */
+    bool counts_pcs() const { return by_pc; }
+
+    /**
+     * Charges an access to its region and pc; the following miss() and
+     * writeback() calls belong to it.
+     */
+    void begin(const Trace_Record &record) {
+        if (!regions.empty()) {
+            // accesses tend to stay in one region for a while
+            if (last_region == regions.size() || record.address < regions[last_region].start
+                || record.address >= regions[last_region].end) {
+                last_region = find_region(record.address);
+            }
+            region = &region_counts[last_region];
+            region->accesses++;
+        }
+        if (by_pc) {
+            pc = &find_pc(record.pc);
+            pc->accesses++;
+        }
+    }
+
+    /**
+     * Charges a miss to the current access.
+     */
+    void miss() {
+        if (region != nullptr) {
+            region->misses++;
+        }
+        if (pc != nullptr) {
+            pc->misses++;
+        }
+    }
+
+    /**
+     * Charges the writeback of a dirty block evicted by the current access.
+     *
+     * @param address the address of the block written back
+     */
+    void writeback(uint64_t address) {
+        if (!regions.empty()) {
+            region_counts[find_region(address)].writebacks++;
+        }
+        if (pc != nullptr) {
+            pc->writebacks++;
+        }
+    }
+
+    /**
+     * Prints the regions and the pcs with the most misses, most first.
+     *
+     * @param out the stream to print to
+     * @param top the number of regions and of pcs to print
+     */
+    void print(std::ostream &out, size_t top) const;
+
+private:
+    Miss_Attribution(const Miss_Attribution &);
+    Miss_Attribution &operator=(const Miss_Attribution &);
+};
+
+#endif //ATTRIBUTION_H
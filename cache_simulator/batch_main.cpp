@@ -0,0 +1,215 @@
+/*
+ * Batch cache simulation: runs many configurations over one trace on a
+ * thread pool
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+#include "cache_config.h"
+#include "cache_simulator.h"
+#include "decompress.h"
+#include "replacement_policy.h"
+#include "trace.h"
+
+namespace {
+
+void usage() {
+    std::cerr << "Usage: csim_batch [-j threads] <config file> [trace]\n"
+              << "  -j  number of worker threads (default: number of cores)\n"
+              << "Each line of the config file is a configuration as given to csim:\n"
+              << "  sets blocks bytes write-allocate write-policy eviction\n"
+              << "Blank lines and lines starting with # are ignored. The trace (text or\n"
+              << "binary) is read from standard input if not given.\n";
+}
+
+/*
+ * The decoded trace, shared read-only by every worker: either a mapped binary
+ * trace that each worker decodes on its own, or a text trace parsed once.
+ */
+struct Shared_Trace {
+    Trace_File file;
+    bool is_binary;
+    std::vector<Trace_Record> records;
+
+    /**
+     * Feeds the whole trace to fn in chunks, decoding into a private buffer.
+     */
+    template <class Fn>
+    void for_each_chunk(Fn fn) const {
+        if (!is_binary) {
+            fn(records.data(), records.size());
+            return;
+        }
+        std::vector<Trace_Record> chunk(4096);
+        uint64_t next = 0;
+        size_t n;
+        while ((n = file.decode(next, chunk.size(), chunk.data())) > 0) {
+            fn(chunk.data(), n);
+            next += n;
+        }
+    }
+};
+
+/*
+ * One configuration of the batch and its result.
+ */
+struct Job {
+    std::string line;
+    Cache_Config config;
+    std::unique_ptr<Cache_Simulator> cache;
+};
+
+/**
+ * Reads the configurations of the batch.
+ *
+ * @return false if the file cannot be read or a line is invalid, otherwise jobs is filled
+ */
+bool read_jobs(const char *path, std::vector<Job> &jobs, std::string &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = std::string("unable to open ") + path;
+        return false;
+    }
+    std::string line;
+    int line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::stringstream ss(line);
+        std::vector<std::string> args;
+        std::string arg;
+        while (ss >> arg) {
+            args.push_back(arg);
+        }
+        if (args.empty() || args[0][0] == '#') {
+            continue;
+        }
+        Job job;
+        job.line = line;
+        if (!parse_cache_config(args, job.config, error)) {
+            error = "line " + std::to_string(line_number) + ": " + error;
+            return false;
+        }
+        jobs.push_back(std::move(job));
+    }
+    return true;
+}
+
+}
+
+/**
+ * Main function of the batch simulator.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of strings containing command line arguments
+ * @return 0 if every configuration was simulated
+ */
+int main(int argc, char *argv[]) {
+    unsigned threads = std::thread::hardware_concurrency();
+    int opt;
+    while ((opt = getopt(argc, argv, "j:")) != -1) {
+        switch (opt) {
+        case 'j':
+            threads = std::atoi(optarg);
+            break;
+        default:
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (argc - optind != 1 && argc - optind != 2) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+
+    std::vector<Job> jobs;
+    std::string error;
+    if (!read_jobs(argv[optind], jobs, error)) {
+        std::cerr << "Error: " << error << "\n";
+        return EXIT_FAILURE;
+    }
+
+    // decode (or map) the trace once
+    Shared_Trace trace;
+    const char *path = argc - optind == 2 ? argv[optind + 1] : nullptr;
+    trace.is_binary = path != nullptr && is_binary_trace(path);
+    if (trace.is_binary) {
+        if (!trace.file.open(path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+    } else {
+        Decompressed_Input input;
+        if (!input.open(path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+        if (!read_text_trace(input.fd(), trace.records, error) || !input.finish(error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // OPT needs the next-use index of the trace, one per block size
+    std::map<unsigned, std::unique_ptr<Next_Use_Index>> next_use;
+    for (Job &job : jobs) {
+        if (job.config.policy == POLICY_OPT && next_use.count(job.config.n_bytes_per_block) == 0) {
+            unsigned offset_bits = 0;
+            while ((1U << offset_bits) < job.config.n_bytes_per_block) {
+                offset_bits++;
+            }
+            Next_Use_Index *index = new Next_Use_Index(offset_bits);
+            next_use[job.config.n_bytes_per_block].reset(index);
+            trace.for_each_chunk([index](const Trace_Record *records, size_t n) { index->add(records, n); });
+        }
+    }
+
+    // every worker takes the next configuration until none is left
+    std::atomic<size_t> next_job(0);
+    auto worker = [&]() {
+        size_t j;
+        while ((j = next_job++) < jobs.size()) {
+            const Cache_Config &config = jobs[j].config;
+            Cache_Simulator *cache = new Cache_Simulator(config.n_sets, config.n_blocks_per_set,
+                                                         config.n_bytes_per_block, config.is_write_allocate,
+                                                         config.is_write_through, config.policy);
+            jobs[j].cache.reset(cache);
+            if (config.policy == POLICY_OPT) {
+                const Next_Use_Index &index = *next_use.at(config.n_bytes_per_block);
+                cache->set_next_use(index.data(), index.size());
+            }
+            trace.for_each_chunk([cache](const Trace_Record *records, size_t n) { cache->access_batch(records, n); });
+        }
+    };
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads && t < jobs.size(); t++) {
+        pool.emplace_back(worker);
+    }
+    for (std::thread &thread : pool) {
+        thread.join();
+    }
+
+    // one stats table per configuration, in the order of the file
+    for (size_t j = 0; j < jobs.size(); j++) {
+        if (j > 0) {
+            std::cout << "\n";
+        }
+        std::cout << "Configuration: " << jobs[j].line << "\n";
+        jobs[j].cache->print_stats();
+    }
+    return 0;
+}
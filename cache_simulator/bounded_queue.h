@@ -0,0 +1,58 @@
+/*
+ * h file for a bounded blocking queue between threads
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/*
+ * A FIFO of at most capacity items. push() blocks while the queue is full and
+ * pop() while it is empty, so a fast producer is held back to the consumer's
+ * pace and memory stays bounded.
+ */
+template <class T>
+class Bounded_Queue {
+private:
+    std::mutex lock;
+    std::condition_variable not_empty, not_full;
+    std::deque<T> items;
+    size_t capacity;
+
+public:
+    explicit Bounded_Queue(size_t capacity) : capacity(capacity > 0 ? capacity : 1) { }
+
+    /**
+     * Appends an item, waiting for room.
+     */
+    void push(T item) {
+        std::unique_lock<std::mutex> guard(lock);
+        not_full.wait(guard, [this] { return items.size() < capacity; });
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+    }
+
+    /**
+     * Removes the oldest item, waiting for one.
+     */
+    T pop() {
+        std::unique_lock<std::mutex> guard(lock);
+        not_empty.wait(guard, [this] { return !items.empty(); });
+        T item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return item;
+    }
+
+private:
+    Bounded_Queue(const Bounded_Queue &);
+    Bounded_Queue &operator=(const Bounded_Queue &);
+};
+
+#endif //BOUNDED_QUEUE_H
@@ -0,0 +1,115 @@
+/*
+ * C++ implementation of cache configuration parsing
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstdlib>
+#include "cache_config.h"
+
+namespace {
+
+/**
+ * Parses a geometry argument like atoi() did, but with the full 32-bit
+ * unsigned range; anything that does not fit (including negative numbers)
+ * becomes 0, which fails the power of 2 checks.
+ */
+unsigned parse_size(const std::string &text) {
+    if (text.empty() || text[0] == '-') {
+        return 0;
+    }
+    unsigned long long value = std::strtoull(text.c_str(), nullptr, 10);
+    return value <= 0xffffffffULL ? (unsigned) value : 0;
+}
+
+}
+
+/*
+ * Helper function that determine if an integer is a positive power of 2
+ *
+ * Parameters:
+ *   x - an integer value to be determined
+ *
+ * Returns:
+ *   boolean value, true if x is a power of 2, false if not
+ *
+ */
+bool is_power_of_2(uint64_t x) {
+    return (x > 0) && ((x & (x - 1)) == 0);
+}
+
+/**
+ * Parses and checks the six configuration arguments.
+ * 
+ * @param args the arguments: sets, blocks per set, bytes per block, write
+ *        allocate policy, write policy and eviction policy
+ * @param config set to the configuration
+ * @param error set to the message (without "Error: ") if the configuration is invalid
+ * @return true if the configuration is valid
+ */
+bool parse_cache_config(const std::vector<std::string> &args, Cache_Config &config, std::string &error) {
+    if (args.size() != 6) {
+        error = "invalid number of arguments";
+        return false;
+    }
+
+    // Store argument values
+    config.n_sets = parse_size(args[0]);
+    config.n_blocks_per_set = parse_size(args[1]);
+    config.n_bytes_per_block = parse_size(args[2]);
+    const std::string &write_allocate = args[3];
+    const std::string &write_through = args[4];
+    const std::string &eviction = args[5];
+
+    config.is_write_allocate = true; // true if write-allocate, false if not
+    config.is_write_through = true; // true if write-through, false if not
+    config.policy = POLICY_LRU;
+
+    // Check the configuration parameters, and set the corresponding error message.
+    // Check if the number of set is a positive power of 2.
+    if (!is_power_of_2(config.n_sets)) {
+        error = "number of sets must be a positive power of 2.";
+        return false;
+    }
+
+    // Check if the number of blocks in each set is a positive power of 2.
+    if (!is_power_of_2(config.n_blocks_per_set)) {
+        error = "number of blocks in each set must be a positive power of 2.";
+        return false;
+    }
+
+    // Check if the block size is a positive power of 2 and at least 4.
+    if (!is_power_of_2(config.n_bytes_per_block) || config.n_bytes_per_block < 4) {
+        error = "block size must be a positive power of 2 and at least 4.";
+        return false;
+    }
+
+    // Check if write allocate policy is valid
+    if (!(write_allocate == "write-allocate" || write_allocate == "no-write-allocate")) {
+        error = "invalid write allocate policy.";
+        return false;
+    } else if (write_allocate == "no-write-allocate") {
+        config.is_write_allocate = false;
+    }
+
+    // Check if write policy is valid
+    if (!(write_through == "write-through" || write_through == "write-back")) {
+        error = "invalid write policy.";
+        return false;
+    } else if (write_through == "write-back") {
+        config.is_write_through = false;
+    }
+
+    // Check if eviction policy is valid (lru, fifo, random, tree-plru, bit-plru,
+    // lfu, srrip, brrip or opt)
+    if (!parse_replacement_policy(eviction, config.policy)) {
+        error = "invalid eviction policy.";
+        return false;
+    }
+
+    // Check if no-write-allocate and write-back were both specified
+    if (!config.is_write_allocate && !config.is_write_through) {
+        error = "invalid combination of write policies.";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+/*
+ * h file for cache configuration parsing
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef CACHE_CONFIG_H
+#define CACHE_CONFIG_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "replacement_policy.h"
+
+/*
+ * The geometry and policies of a single cache, as given on the csim command
+ * line: sets blocks bytes write-allocate write-policy eviction.
+ */
+struct Cache_Config {
+    unsigned n_sets, n_blocks_per_set, n_bytes_per_block;
+    bool is_write_allocate, is_write_through;
+    Replacement_Policy policy;
+};
+
+/*
+ * Helper function that determine if an integer is a positive power of 2
+ *
+ * Parameters:
+ *   x - an integer value to be determined
+ *
+ * Returns:
+ *   boolean value, true if x is a power of 2, false if not
+ *
+ */
+bool is_power_of_2(uint64_t x);
+
+/**
+ * Parses and checks the six configuration arguments.
+ * 
+ * @param args the arguments: sets, blocks per set, bytes per block, write
+ *        allocate policy, write policy and eviction policy
+ * @param config set to the configuration
+ * @param error set to the message (without "Error: ") if the configuration is invalid
+ * @return true if the configuration is valid
+ */
+bool parse_cache_config(const std::vector<std::string> &args, Cache_Config &config, std::string &error);
+
+#endif //CACHE_CONFIG_H
@@ -0,0 +1,348 @@
+/*
+ * C++ implementation of multi-level cache hierarchy
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include "cache_hierarchy.h"
+
+namespace {
+
+bool is_power_of_2(unsigned x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+bool parse_unsigned(const std::string &text, unsigned &value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long parsed = std::strtoul(text.c_str(), nullptr, 10);
+    value = (unsigned) parsed;
+    return parsed == value;
+}
+
+}
+
+/**
+ * Parses a level given as name:sets:ways:block_bytes:latency[:policy[:inclusion]],
+ * e.g. "l2:1024:8:64:12:lru:inclusive". The policy defaults to lru and the
+ * inclusion policy to nine.
+ *
+ * @return false if the specification is malformed, otherwise config is set
+ */
+bool parse_level_config(const std::string &spec, Level_Config &config, std::string &error) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 5 || fields.size() > 7 || fields[0].empty()) {
+        error = "level must be name:sets:ways:block_bytes:latency[:policy[:inclusion]]: " + spec;
+        return false;
+    }
+    config.name = fields[0];
+    if (!parse_unsigned(fields[1], config.sets) || !parse_unsigned(fields[2], config.ways)
+        || !parse_unsigned(fields[3], config.block_bytes) || !parse_unsigned(fields[4], config.latency)) {
+        error = "invalid number in level " + spec;
+        return false;
+    }
+    config.policy = POLICY_LRU;
+    if (fields.size() > 5 && !parse_replacement_policy(fields[5], config.policy)) {
+        error = "invalid eviction policy in level " + spec;
+        return false;
+    }
+    config.inclusion = INCLUSION_NINE;
+    if (fields.size() > 6) {
+        if (fields[6] == "inclusive") {
+            config.inclusion = INCLUSION_INCLUSIVE;
+        } else if (fields[6] == "exclusive") {
+            config.inclusion = INCLUSION_EXCLUSIVE;
+        } else if (fields[6] != "nine") {
+            error = "invalid inclusion policy in level " + spec;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks a hierarchy configuration.
+ *
+ * @return false if it is invalid, otherwise error is untouched
+ */
+bool Cache_Hierarchy::validate(const std::vector<Level_Config> &configs, std::string &error) {
+    if (configs.empty()) {
+        error = "the hierarchy has no levels";
+        return false;
+    }
+    for (size_t i = 0; i < configs.size(); i++) {
+        const Level_Config &config = configs[i];
+        if (!is_power_of_2(config.sets) || !is_power_of_2(config.ways)) {
+            error = "number of sets and blocks in each set of " + config.name + " must be positive powers of 2";
+            return false;
+        }
+        if (!is_power_of_2(config.block_bytes) || config.block_bytes < 4) {
+            error = "block size of " + config.name + " must be a positive power of 2 and at least 4";
+            return false;
+        }
+        if (config.block_bytes != configs[0].block_bytes) {
+            error = "all levels must use the same block size";
+            return false;
+        }
+        if (config.name == "l1i" && (i > 1 || configs.size() < 2 || configs[1 - i].name == "l1i")) {
+            error = "l1i must be listed next to a data L1 at the top of the hierarchy";
+            return false;
+        }
+        bool is_l1 = i == 0 || (i == 1 && (config.name == "l1i" || configs[0].name == "l1i"));
+        if (is_l1 && config.inclusion != INCLUSION_NINE) {
+            error = "inclusion policy of " + config.name + " must be nine, it has no levels above";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Builds the hierarchy.
+ *
+ * @param configs the levels, top to bottom
+ * @param memory_latency cycles for a memory read or write
+ * @param victim_entries the blocks of the victim cache behind each level,
+ *        or 0 for none
+ */
+Cache_Hierarchy::Cache_Hierarchy(const std::vector<Level_Config> &configs, unsigned memory_latency,
+                                 unsigned victim_entries)
+    : memory_latency(memory_latency), offset_bits(0), memory_reads(0), memory_writes(0), num_cycles(0), now(0),
+      tracks_uses(false) {
+    Level *instruction = nullptr;
+    for (const Level_Config &config : configs) {
+        std::unique_ptr<Level> level(new Level());
+        level->config = config;
+        level->cache.reset(new Cache_Simulator(config.sets, config.ways, config.block_bytes,
+                                               true, false, config.policy));
+        if (victim_entries > 0) {
+            level->victims.reset(new Victim_Cache(victim_entries));
+        }
+        level->stats = Cache_Stats();
+        if (config.name == "l1i") {
+            instruction = level.get();
+        } else {
+            data_path.push_back(level.get());
+        }
+        levels.push_back(std::move(level));
+    }
+    // without a split L1 instruction fetches use the data path
+    fetch_path = data_path;
+    if (instruction != nullptr) {
+        fetch_path[0] = instruction;
+    }
+    offset_bits = levels[0]->cache->block_offset_bits();
+}
+
+/**
+ * Runs a batch of decoded trace records through the hierarchy.
+ *
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Cache_Hierarchy::access_batch(const Trace_Record *records, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        const Trace_Record &record = records[i];
+        if (tracks_uses) {
+            last_use[record.address >> offset_bits] = now;
+        }
+        access(record.is_fetch ? fetch_path : data_path, record.address, record.is_store);
+        for (auto &level : levels) {
+            level->cache->inc_timer();
+        }
+        now++;
+    }
+}
+
+/**
+ * Gives every level the next-use index of the trace (see
+ * Cache_Simulator::set_next_use).
+ */
+void Cache_Hierarchy::set_next_use(const uint64_t *next_use, uint64_t length) {
+    for (auto &level : levels) {
+        level->cache->set_next_use(next_use, length);
+    }
+    tracks_uses = true;
+}
+
+/**
+ * Returns the access an OPT level ranks a block by: the latest access to the
+ * block, whose next use is the block's next use even when the block is a
+ * victim moved on behalf of another access. Other levels get UINT64_MAX, the
+ * current access.
+ */
+uint64_t Cache_Hierarchy::use_of(const Level &level, uint64_t address) const {
+    if (!tracks_uses || level.config.policy != POLICY_OPT) {
+        return UINT64_MAX;
+    }
+    auto found = last_use.find(address >> offset_bits);
+    return found == last_use.end() ? UINT64_MAX : found->second;
+}
+
+/**
+ * Looks an access up level by level and fills the levels above the one that
+ * hit. Only the L1 copy of a stored block becomes dirty; lower levels see it
+ * when it is written back.
+ */
+void Cache_Hierarchy::access(const std::vector<Level *> &path, uint64_t address, bool is_store) {
+    size_t hit = path.size();
+    bool victim_hit = false, dirty = false;
+    for (size_t depth = 0; depth < path.size(); depth++) {
+        Level &level = *path[depth];
+        num_cycles += level.config.latency;
+        bool found = level.cache->probe(address, is_store && depth == 0, use_of(level, address));
+        if (is_store) {
+            level.stats.stores++;
+            found ? level.stats.store_hits++ : level.stats.store_misses++;
+        } else {
+            level.stats.loads++;
+            found ? level.stats.load_hits++ : level.stats.load_misses++;
+        }
+        if (!found && level.victims && level.victims->take((address >> offset_bits) << offset_bits, dirty)) {
+            level.stats.victim_hits++;
+            victim_hit = true;
+            found = true;
+        }
+        if (found) {
+            hit = depth;
+            break;
+        }
+    }
+    if (hit == 0 && !victim_hit) {
+        return;
+    }
+    if (hit == path.size()) {
+        num_cycles += memory_latency;
+        memory_reads++;
+    }
+    // an exclusive level gives its copy up to the levels above; any other
+    // level, and always the L1, takes a block back from its victim cache
+    if (hit > 0 && hit < path.size() && path[hit]->config.inclusion == INCLUSION_EXCLUSIVE) {
+        if (!victim_hit) {
+            path[hit]->cache->invalidate(address, dirty);
+        }
+    } else if (victim_hit) {
+        fill(path, hit, address, dirty || (is_store && hit == 0));
+        dirty = false;
+    }
+    // fill bottom up, so that back-invalidations from a lower fill happen
+    // before the upper levels are filled
+    for (size_t depth = hit; depth-- > 0;) {
+        if (depth > 0 && path[depth]->config.inclusion == INCLUSION_EXCLUSIVE) {
+            continue;
+        }
+        fill(path, depth, address, depth == 0 && (is_store || dirty));
+    }
+}
+
+/**
+ * Fills a block into the level at depth of path and handles the victim:
+ * an inclusive level back-invalidates it above, then it is sent down.
+ */
+void Cache_Hierarchy::fill(const std::vector<Level *> &path, size_t depth, uint64_t address, bool dirty) {
+    Level &level = *path[depth];
+    Cache_Block victim;
+    if (!level.cache->insert(address, dirty, victim, use_of(level, address))) {
+        return;
+    }
+    level.stats.evictions++;
+    if (depth > 0 && level.config.inclusion == INCLUSION_INCLUSIVE) {
+        // the levels above are the L1s of both paths and the shared levels
+        // between them and this one; a dirty copy above carries the data
+        for (size_t above = 0; above < depth; above++) {
+            Level *copies[2] = {data_path[above], fetch_path[above]};
+            for (unsigned c = 0; c < (copies[0] == copies[1] ? 1U : 2U); c++) {
+                bool copy_dirty;
+                if (remove_copy(*copies[c], victim.address, copy_dirty)) {
+                    copies[c]->stats.back_invalidations++;
+                    victim.dirty = victim.dirty || copy_dirty;
+                }
+            }
+        }
+    }
+    if (level.victims) {
+        // the victim waits in the victim cache; the block it displaces goes down
+        Cache_Block displaced;
+        if (!level.victims->insert(victim.address, victim.dirty, displaced.address, displaced.dirty)) {
+            return;
+        }
+        victim = displaced;
+    }
+    if (victim.dirty) {
+        level.stats.writebacks++;
+    }
+    write_down(path, depth + 1, victim);
+}
+
+/**
+ * Removes a block from a level and its victim cache, for a back-invalidation.
+ *
+ * @return true if the block was present in either
+ */
+bool Cache_Hierarchy::remove_copy(Level &level, uint64_t address, bool &dirty) {
+    if (level.cache->invalidate(address, dirty)) {
+        return true;
+    }
+    return level.victims && level.victims->take(address, dirty);
+}
+
+/**
+ * Sends a block evicted from the level above depth down the path. Exclusive
+ * levels take every victim, other levels only dirty ones.
+ */
+void Cache_Hierarchy::write_down(const std::vector<Level *> &path, size_t depth, const Cache_Block &block) {
+    if (depth == path.size()) {
+        if (block.dirty) {
+            num_cycles += memory_latency;
+            memory_writes++;
+        }
+        return;
+    }
+    Level &level = *path[depth];
+    if (level.config.inclusion != INCLUSION_EXCLUSIVE && !block.dirty) {
+        return; // a clean copy is simply dropped
+    }
+    num_cycles += level.config.latency;
+    // the level may already hold the block: an inclusive level always does, and
+    // with split L1s an exclusive level can receive a block from both of them
+    if (!level.cache->probe(block.address, block.dirty, use_of(level, block.address))) {
+        bool held_dirty = false;
+        if (level.victims) {
+            level.victims->take(block.address, held_dirty);
+        }
+        fill(path, depth, block.address, block.dirty || held_dirty);
+    }
+}
+
+/**
+ * Prints the counters of every level, memory traffic and total cycles.
+ */
+void Cache_Hierarchy::print_stats() const {
+    for (auto &level : levels) {
+        const std::string &name = level->config.name;
+        const Cache_Stats &stats = level->stats;
+        std::cout << name << " loads: " << stats.loads << "\n";
+        std::cout << name << " stores: " << stats.stores << "\n";
+        std::cout << name << " load hits: " << stats.load_hits << "\n";
+        std::cout << name << " load misses: " << stats.load_misses << "\n";
+        std::cout << name << " store hits: " << stats.store_hits << "\n";
+        std::cout << name << " store misses: " << stats.store_misses << "\n";
+        std::cout << name << " evictions: " << stats.evictions << "\n";
+        std::cout << name << " writebacks: " << stats.writebacks << "\n";
+        std::cout << name << " back invalidations: " << stats.back_invalidations << "\n";
+        if (level->victims) {
+            std::cout << name << " conflict misses saved by victim cache: " << stats.victim_hits << "\n";
+        }
+    }
+    std::cout << "Memory reads: " << memory_reads << "\n";
+    std::cout << "Memory writes: " << memory_writes << "\n";
+    std::cout << "Total cycles: " << num_cycles << "\n";
+}
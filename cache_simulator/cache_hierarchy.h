@@ -0,0 +1,160 @@
+/*
+ * h file for multi-level cache hierarchy
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef CACHE_HIERARCHY_H
+#define CACHE_HIERARCHY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cache_simulator.h"
+#include "replacement_policy.h"
+#include "trace.h"
+
+/*
+ * How a level relates to the levels above it.
+ *
+ *   nine       non-inclusive non-exclusive: misses fill this level, its
+ *              evictions leave the levels above alone
+ *   inclusive  every block above is also here: evicting a block here
+ *              back-invalidates it above
+ *   exclusive  no block is both here and above: misses bypass this level, it
+ *              is filled with the victims of the level above and a hit moves
+ *              the block up
+ */
+enum Inclusion_Policy {
+    INCLUSION_NINE,
+    INCLUSION_INCLUSIVE,
+    INCLUSION_EXCLUSIVE
+};
+
+/*
+ * Configuration of one level. Levels are listed top (closest to the core)
+ * to bottom; a level named "l1i" is an instruction-side L1 next to the first
+ * data level, every other level is shared below it.
+ */
+struct Level_Config {
+    std::string name;
+    unsigned sets, ways, block_bytes;
+    unsigned latency;           // cycles for a lookup in this level
+    Replacement_Policy policy;
+    Inclusion_Policy inclusion; // relation to the levels above, nine for L1s
+};
+
+/*
+ * Per-level counters. Requests are counted with the kind of the access that
+ * caused them, so an L1 store miss is a store at L2 as well.
+ */
+struct Cache_Stats {
+    uint64_t loads, load_hits, load_misses;
+    uint64_t stores, store_hits, store_misses;
+    uint64_t evictions, writebacks, back_invalidations;
+    uint64_t victim_hits; // misses served by the level's victim cache
+};
+
+/**
+ * Parses a level given as name:sets:ways:block_bytes:latency[:policy[:inclusion]],
+ * e.g. "l2:1024:8:64:12:lru:inclusive". The policy defaults to lru and the
+ * inclusion policy to nine.
+ *
+ * @return false if the specification is malformed, otherwise config is set
+ */
+bool parse_level_config(const std::string &spec, Level_Config &config, std::string &error);
+
+/*
+ * A hierarchy of write-back, write-allocate Cache_Simulator levels in front of
+ * memory, simulated in one pass over the trace. An access looks up each level
+ * of its path in turn, paying each level's latency, until it hits (or pays the
+ * memory latency), then fills the levels above the hit bottom up. Dirty
+ * victims are written back into the next level down; writing a block into a
+ * level or memory costs that level's latency.
+ *
+ * All levels must use the same block size.
+ *
+ * Each level may have a victim cache (see victim_cache.h) behind it, taking
+ * the level's victims before they are sent down. A miss that finds its block
+ * there is counted as a miss and a victim hit, pays no further latency and
+ * moves the block back into the level.
+ *
+ * With OPT, a block moved between levels (a victim written down, or a block
+ * an exclusive level gives up) is ranked by its own next use: the hierarchy
+ * remembers the latest access to each block and gives OPT levels that one
+ * instead of the current access.
+ */
+class Cache_Hierarchy {
+private:
+    struct Level {
+        Level_Config config;
+        std::unique_ptr<Cache_Simulator> cache;
+        std::unique_ptr<Victim_Cache> victims; // nullptr without victim caches
+        Cache_Stats stats;
+    };
+
+    std::vector<std::unique_ptr<Level>> levels;
+    std::vector<Level *> data_path, fetch_path; // top to bottom
+    unsigned memory_latency, offset_bits;
+    uint64_t memory_reads, memory_writes, num_cycles;
+    uint64_t now;                                    // index of the current access
+    bool tracks_uses;                                // true once there is a next-use index
+    std::unordered_map<uint64_t, uint64_t> last_use; // block -> latest access, for OPT
+
+    void access(const std::vector<Level *> &path, uint64_t address, bool is_store);
+    void fill(const std::vector<Level *> &path, size_t depth, uint64_t address, bool dirty);
+    void write_down(const std::vector<Level *> &path, size_t depth, const Cache_Block &block);
+    bool remove_copy(Level &level, uint64_t address, bool &dirty);
+    uint64_t use_of(const Level &level, uint64_t address) const;
+
+public:
+    /**
+     * Builds the hierarchy.
+     *
+     * @param configs the levels, top to bottom
+     * @param memory_latency cycles for a memory read or write
+     * @param victim_entries the blocks of the victim cache behind each level,
+     *        or 0 for none
+     */
+    Cache_Hierarchy(const std::vector<Level_Config> &configs, unsigned memory_latency, unsigned victim_entries = 0);
+
+    /**
+     * Checks a hierarchy configuration.
+     *
+     * @return false if it is invalid, otherwise error is untouched
+     */
+    static bool validate(const std::vector<Level_Config> &configs, std::string &error);
+
+    /**
+     * Runs a batch of decoded trace records through the hierarchy.
+     *
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Gives every level the next-use index of the trace (see
+     * Cache_Simulator::set_next_use).
+     */
+    void set_next_use(const uint64_t *next_use, uint64_t length);
+
+    /**
+     * @return log2 of the block size
+     */
+    unsigned block_offset_bits() const { return offset_bits; }
+
+    /**
+     * @return the counters of the level at index i of the configuration
+     */
+    const Cache_Stats &stats(size_t i) const { return levels[i]->stats; }
+
+    /**
+     * Prints the counters of every level, memory traffic and total cycles.
+     */
+    void print_stats() const;
+};
+
+#endif //CACHE_HIERARCHY_H
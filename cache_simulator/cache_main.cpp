@@ -4,137 +4,587 @@
  */
 
 #include <iostream>
+#include "attribution.h"
+#include "cache_config.h"
+#include "cache_hierarchy.h"
 #include "cache_simulator.h"
+#include "coherence.h"
+#include "decompress.h"
+#include "parallel_simulator.h"
+#include "prefetcher.h"
+#include "replacement_policy.h"
+#include "sampling.h"
+#include "stats_output.h"
+#include "tlb.h"
+#include "trace.h"
+#include "trace_stream.h"
+#include <fcntl.h>
+#include <getopt.h>
 #include <string>
+#include <vector>
 
-/*
- * Helper function that determine if an integer is a positive power of 2
- *
- * Parameters:
- *   x - an integer value to be determined
- *
- * Returns:
- *   boolean value, true if x is a power of 2, false if not
- *
- */
-bool is_power_of_2(int x) {
-    return (x > 0) && ((x & (x - 1)) == 0);
+/**
+ * Helper function that reads a text trace with the hand-rolled hex parser,
+ * so each address is decoded exactly once. Each record consists of the
+ * processor command (load or store) and the decoded memory address to be accessed.
+ * 
+ * @param fd the file descriptor to read the trace from (standard input by default)
+ * @param keep_pcs whether to keep the third field of each line
+ * @return a vector of decoded trace records
+*/
+std::vector<Trace_Record> get_input(int fd, bool keep_pcs) {
+    std::vector<Trace_Record> input;
+    std::string error;
+    if (!read_text_trace(fd, input, error, keep_pcs)) {
+        std::cerr << "Error: " << error << "\n";
+        std::exit(EXIT_FAILURE);
+    }
+    return input;
 }
 
 /**
- * Helper function that reads input from standard input and returns
- * a vector of pairs containing the processor command and memory address.
- * Each pair consists of a character representing the processor 
- * command (either 'l' for load or 's' for store) and a string representing 
- * the memory address to be accessed.
+ * Helper function that runs a whole trace through a single cache or a hierarchy.
+ * Binary traces are mapped and decoded a block of records at a time, text traces
+ * are streamed (or read completely first when the next-use index is needed).
+ * Compressed text traces (gzip, zstd, LZ4) are decompressed on the fly.
  * 
- * @return a vector of pairs containing processor commands and memory addresses.
-*/
-std::vector<std::pair<char, std::string>> get_input() {
-    std::vector<std::pair<char, std::string>> input;
-    char processor;
-    std::string address;
-    std::string offset;
+ * @param simulator the Cache_Simulator or Cache_Hierarchy to run
+ * @param trace_path the trace file (text or binary), or nullptr for standard input
+ * @param needs_next_use whether a policy looks ahead (OPT), so the next-use index
+ *        of the trace has to be built before the run
+ * @param keep_pcs whether to keep the third field of text trace lines (binary
+ *        traces have none)
+ */
+template <class Simulator>
+void run_trace(Simulator &simulator, const char *trace_path, bool needs_next_use, bool keep_pcs = false) {
+    Next_Use_Index next_use(simulator.block_offset_bits());
+    if (trace_path != nullptr && is_binary_trace(trace_path)) {
+        Trace_File trace;
+        std::string error;
+        if (!trace.open(trace_path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        std::vector<Trace_Record> chunk(4096);
+        uint64_t next = 0;
+        size_t n;
+        if (needs_next_use) {
+            while ((n = trace.decode(next, chunk.size(), chunk.data())) > 0) {
+                next_use.add(chunk.data(), n);
+                next += n;
+            }
+            simulator.set_next_use(next_use.data(), next_use.size());
+            next = 0;
+        }
+        while ((n = trace.decode(next, chunk.size(), chunk.data())) > 0) {
+            simulator.access_batch(chunk.data(), n);
+            next += n;
+        }
+    } else {
+        // gzip, zstd and LZ4 traces are decompressed on their own thread
+        Decompressed_Input input;
+        std::string error;
+        if (!input.open(trace_path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (!needs_next_use) {
+            // stream: a reader thread parses ahead while the records are simulated
+            Trace_Stream stream(input.fd(), keep_pcs);
+            const Trace_Record *records;
+            size_t n;
+            while (stream.next(records, n)) {
+                simulator.access_batch(records, n);
+            }
+            if (stream.failed(error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+        } else {
+            // the next-use index needs the whole trace before the run, so store
+            // processor status and traces
+            std::vector<Trace_Record> records = get_input(input.fd(), keep_pcs);
+            next_use.add(records.data(), records.size());
+            simulator.set_next_use(next_use.data(), next_use.size());
+            simulator.access_batch(records.data(), records.size());
+        }
+        if (!input.finish(error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+    }
+}
 
-    while (std::cin >> processor && std::cin >> address) {
-        std::cin >> offset; // ignore the third field
-        auto temp = std::make_pair(processor, address);
-        input.emplace_back(temp);
+/**
+ * Runs the trace through a cache hierarchy given with --level options.
+ * 
+ * @param levels the levels, top to bottom
+ * @param memory_latency cycles for a memory access
+ * @param victim_entries the blocks of the victim cache behind each level, or 0
+ * @param nargs the number of arguments left after the options
+ * @param args the arguments left after the options (an optional trace file)
+ * @return 0 if program executed successfully
+ */
+int run_hierarchy(const std::vector<Level_Config> &levels, unsigned memory_latency, unsigned victim_entries,
+                  int nargs, char *args[]) {
+    if (nargs > 1) {
+        std::cerr << "Error: invalid number of arguments";
+        std::exit(EXIT_FAILURE);
     }
-    
-    return input;
+    std::string error;
+    if (!Cache_Hierarchy::validate(levels, error)) {
+        std::cerr << "Error: " << error << ".\n";
+        std::exit(EXIT_FAILURE);
+    }
+    bool needs_next_use = false;
+    for (const Level_Config &level : levels) {
+        needs_next_use = needs_next_use || level.policy == POLICY_OPT;
+    }
+    Cache_Hierarchy hierarchy(levels, memory_latency, victim_entries);
+    run_trace(hierarchy, nargs == 1 ? args[0] : nullptr, needs_next_use);
+    hierarchy.print_stats();
+    return 0;
 }
 
 /**
  * Main function to run the cache simulator.
+ *
+ * Usage:
+ *   csim [--threads n | --prefetch spec | --coherence spec] sets blocks bytes write-allocate write-policy
+ *        eviction [trace]
+ *   csim --tlb spec [--tlb spec ...] [--page-size 4k|2m|1g] [--page-map file] [--walk-latency cycles]
+ *        [--walk-through-cache] [--prefetch spec] sets blocks bytes write-allocate write-policy eviction [trace]
+ *   csim --level spec [--level spec ...] [--memory-latency cycles] [trace]
+ *
+ * A level spec is name:sets:ways:block_bytes:latency[:policy[:inclusion]], see
+ * parse_level_config(). A prefetch spec is next-line[:degree],
+ * stride[:degree[:entries]] or stream[:depth[:streams]], see
+ * parse_prefetcher_config(). A coherence spec is mesi or moesi, optionally
+ * followed by :snoop or :directory; the trace then tags each line with its
+ * core, see parse_coherence_config() and Text_Trace_Parser. A TLB spec is
+ * name:sets:ways:latency[:policy], see parse_tlb_level_config(); the page map
+ * format is described at Page_Map::load().
+ *
+ * Without --threads, --coherence or --level, --attribute-regions file and
+ * --attribute-pcs split the hits, misses and writebacks of the cache by
+ * address region and by the third trace field, printing the --attribute-top
+ * (default 10) with the most misses; see Miss_Attribution.
+ *
+ * For a single cache (also with --threads), --stats-format json|csv prints
+ * the final counters for other programs instead of the text summary. Without
+ * --threads, --sample-interval n --samples file records hit rate, MPKI,
+ * cycles and dirty evictions every n accesses; see Interval_Sampler.
+ *
+ * Without --threads or --coherence, --victim-cache n puts an n-block fully
+ * associative victim cache behind the cache (or behind every --level). With a
+ * write-through cache, --write-buffer n lets an n-block coalescing write
+ * buffer absorb the memory writes of stores; see Write_Buffer.
+ *
+ * For a quick estimate of a long trace, --sample-sets n simulates a random
+ * (fixed-seed) 1/n of the sets, and --sample-time unit:period[:warmup]
+ * measures unit accesses of every period after warmup accesses of warming
+ * (by default a tenth of the gap; only period - unit keeps the cache state
+ * exact, at the cost of simulating every access);
+ * either prints the estimated miss rate with a 95% confidence interval
+ * instead of the summary. See Sampled_Simulator.
  * 
  * @param argc number of command line arguments
  * @param argv array of strings containing command line arguments
  * @return 0 if program executed successfully
  */
 int main(int argc, char *argv[]) {
+    static const struct option long_options[] = {
+        {"level", required_argument, nullptr, 'L'},
+        {"memory-latency", required_argument, nullptr, 'M'},
+        {"threads", required_argument, nullptr, 'T'},
+        {"prefetch", required_argument, nullptr, 'P'},
+        {"coherence", required_argument, nullptr, 'C'},
+        {"tlb", required_argument, nullptr, 'B'},
+        {"page-size", required_argument, nullptr, 'S'},
+        {"page-map", required_argument, nullptr, 'G'},
+        {"walk-latency", required_argument, nullptr, 'W'},
+        {"walk-through-cache", no_argument, nullptr, 'X'},
+        {"attribute-regions", required_argument, nullptr, 'R'},
+        {"attribute-pcs", no_argument, nullptr, 'A'},
+        {"attribute-top", required_argument, nullptr, 'N'},
+        {"stats-format", required_argument, nullptr, 'F'},
+        {"sample-interval", required_argument, nullptr, 'I'},
+        {"samples", required_argument, nullptr, 'O'},
+        {"victim-cache", required_argument, nullptr, 'V'},
+        {"write-buffer", required_argument, nullptr, 'D'},
+        {"sample-sets", required_argument, nullptr, 'Q'},
+        {"sample-time", required_argument, nullptr, 'U'},
+        {nullptr, 0, nullptr, 0}
+    };
+    std::vector<Level_Config> levels;
+    unsigned memory_latency = 100;
+    int threads = 1;
+    Prefetcher_Config prefetch = {PREFETCH_NONE, 0, 0};
+    Coherence_Config coherence;
+    bool is_coherent = false;
+    std::vector<Tlb_Level_Config> tlb_levels;
+    Page_Map pages;
+    unsigned walk_latency = 100;
+    bool walk_through_cache = false, has_page_options = false;
+    Miss_Attribution attribution;
+    int attribute_top = 10;
+    Stats_Format stats_format = STATS_TEXT;
+    uint64_t sample_interval = 0;
+    const char *samples_path = nullptr;
+    int victim_entries = 0, write_buffer_depth = 0;
+    Sampling_Config sampling;
+    bool is_sampled = false;
+    int option;
+    // "+" stops at the first positional argument, so the classic command line
+    // is left untouched
+    while ((option = getopt_long(argc, argv, "+", long_options, nullptr)) != -1) {
+        std::string error;
+        Level_Config level;
+        Tlb_Level_Config tlb_level;
+        unsigned page_bits;
+        switch (option) {
+        case 'L':
+            if (!parse_level_config(optarg, level, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            levels.push_back(level);
+            break;
+        case 'M':
+            memory_latency = std::atoi(optarg);
+            break;
+        case 'T':
+            threads = std::atoi(optarg);
+            if (threads < 1) {
+                std::cerr << "Error: number of threads must be positive.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'P':
+            if (!parse_prefetcher_config(optarg, prefetch, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'C':
+            if (!parse_coherence_config(optarg, coherence, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            is_coherent = true;
+            break;
+        case 'B':
+            if (!parse_tlb_level_config(optarg, tlb_level, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            tlb_levels.push_back(tlb_level);
+            break;
+        case 'S':
+            if (!parse_page_size(optarg, page_bits)) {
+                std::cerr << "Error: page size must be 4k, 2m or 1g.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            pages.set_default(page_bits);
+            has_page_options = true;
+            break;
+        case 'G':
+            if (!pages.load(optarg, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            has_page_options = true;
+            break;
+        case 'W':
+            walk_latency = std::atoi(optarg);
+            has_page_options = true;
+            break;
+        case 'X':
+            walk_through_cache = true;
+            has_page_options = true;
+            break;
+        case 'R':
+            if (!attribution.load_regions(optarg, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'A':
+            attribution.enable_pcs();
+            break;
+        case 'N':
+            attribute_top = std::atoi(optarg);
+            if (attribute_top < 1) {
+                std::cerr << "Error: --attribute-top must be positive.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'F':
+            if (!parse_stats_format(optarg, stats_format)) {
+                std::cerr << "Error: stats format must be text, json or csv.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'I':
+            sample_interval = std::strtoull(optarg, nullptr, 10);
+            if (sample_interval == 0) {
+                std::cerr << "Error: --sample-interval must be positive.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'O':
+            samples_path = optarg;
+            break;
+        case 'V':
+            victim_entries = std::atoi(optarg);
+            if (victim_entries < 1) {
+                std::cerr << "Error: --victim-cache must be positive.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'D':
+            write_buffer_depth = std::atoi(optarg);
+            if (write_buffer_depth < 1) {
+                std::cerr << "Error: --write-buffer must be positive.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            break;
+        case 'Q':
+        case 'U':
+            if (is_sampled) {
+                std::cerr << "Error: only one of --sample-sets and --sample-time may be given.\n";
+                std::exit(EXIT_FAILURE);
+            }
+            if (option == 'Q' ? !parse_set_sampling(optarg, sampling, error)
+                              : !parse_time_sampling(optarg, sampling, error)) {
+                std::cerr << "Error: " << error << "\n";
+                std::exit(EXIT_FAILURE);
+            }
+            is_sampled = true;
+            break;
+        default:
+            std::exit(EXIT_FAILURE);
+        }
+    }
+    const int nargs = argc - optind;
+    char **args = argv + optind;
+    if (has_page_options && tlb_levels.empty()) {
+        std::cerr << "Error: page and walk options need --tlb.\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if ((sample_interval > 0) != (samples_path != nullptr)) {
+        std::cerr << "Error: --sample-interval and --samples go together.\n";
+        std::exit(EXIT_FAILURE);
+    }
+    // machine-readable output and sampling cover a single cache
+    const bool single_cache_output = stats_format != STATS_TEXT || sample_interval > 0;
+    if (single_cache_output && (!levels.empty() || is_coherent || !tlb_levels.empty())) {
+        std::cerr << "Error: --stats-format and sampling do not support --level, --coherence or --tlb.\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if (stats_format != STATS_TEXT && attribution.enabled()) {
+        std::cerr << "Error: attribution tables are only printed with --stats-format text.\n";
+        std::exit(EXIT_FAILURE);
+    }
+    if (!levels.empty()) {
+        if (threads > 1) {
+            std::cerr << "Error: --threads does not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (prefetch.kind != PREFETCH_NONE) {
+            std::cerr << "Error: --prefetch does not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (is_coherent) {
+            std::cerr << "Error: --coherence does not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (!tlb_levels.empty()) {
+            std::cerr << "Error: --tlb does not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (attribution.enabled()) {
+            std::cerr << "Error: attribution does not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (write_buffer_depth > 0) {
+            std::cerr << "Error: --write-buffer does not support hierarchies, whose levels are write-back.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (is_sampled) {
+            std::cerr << "Error: --sample-sets and --sample-time do not support hierarchies.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        return run_hierarchy(levels, memory_latency, victim_entries, nargs, args);
+    }
+
     // Check if number of arguments is valid, if not print corresponding error message.
-    if (argc != 7) {
+    // An optional seventh argument names a trace file (text or binary) to read
+    // instead of standard input.
+    if (nargs != 6 && nargs != 7) {
         std::cerr << "Error: invalid number of arguments";
         std::exit(EXIT_FAILURE);
     }
 
-    // Store argv values
-    const int n_sets = std::atoi(argv[1]);
-    const int n_blocks_per_set = std::atoi(argv[2]);
-    const int n_bytes_per_block = std::atoi(argv[3]);
-    const std::string write_allocate = argv[4];
-    const std::string write_through = argv[5];
-    const std::string eviction = argv[6];
-
-    bool is_write_allocate = true; // true if write-allocate, false if not
-    bool is_write_through = true; // true if write-through, false if not
-    bool is_eviction = true; // true if lru, false if not
-
-    // Check the configuration parameters, and print corresponding error message.
-    // Check if the number of set is a positive power of 2.
-    if (!is_power_of_2(n_sets)) {
-        std::cerr << "Error: number of sets must be a positive power of 2.\n";
+    Cache_Config config;
+    std::string error;
+    if (!parse_cache_config(std::vector<std::string>(args, args + 6), config, error)) {
+        std::cerr << "Error: " << error << "\n";
         std::exit(EXIT_FAILURE);
     }
-
-    // Check if the number of blocks in each set is a positive power of 2.
-    if (!is_power_of_2(n_blocks_per_set)) {
-        std::cerr << "Error: number of blocks in each set must be a positive power of 2.\n";
+    const unsigned n_sets = config.n_sets;
+    const unsigned n_blocks_per_set = config.n_blocks_per_set;
+    const unsigned n_bytes_per_block = config.n_bytes_per_block;
+    const bool is_write_allocate = config.is_write_allocate;
+    const bool is_write_through = config.is_write_through;
+    const Replacement_Policy policy = config.policy;
+    if (prefetch.kind != PREFETCH_NONE && policy == POLICY_OPT) {
+        std::cerr << "Error: --prefetch does not support opt.\n";
         std::exit(EXIT_FAILURE);
     }
-
-    // Check if the block size is a positive power of 2 and at least 4.
-    if (!is_power_of_2(n_bytes_per_block) || n_bytes_per_block < 4) {
-        std::cerr << "Error: block size must be a positive power of 2 and at least 4.\n";
+    if (write_buffer_depth > 0 && !is_write_through) {
+        std::cerr << "Error: --write-buffer needs a write-through cache.\n";
         std::exit(EXIT_FAILURE);
     }
-
-    // Check if the block size is a positive power of 2 and at least 4.
-    if (!(write_allocate == "write-allocate" || write_allocate == "no-write-allocate")) {
-        std::cerr << "Error: invalid write allocate policy.\n";
+    // the victim cache is shared by all sets and the buffer drains in cycle
+    // order, so neither splits over threads or private caches
+    if ((victim_entries > 0 || write_buffer_depth > 0) && (threads > 1 || is_coherent)) {
+        std::cerr << "Error: --victim-cache and --write-buffer do not support --threads or --coherence.\n";
         std::exit(EXIT_FAILURE);
-    } else if (write_allocate == "no-write-allocate") {
-        is_write_allocate = false;
     }
 
-    // Check if write policy is valid
-    if (!(write_through == "write-through" || write_through == "write-back")) {
-        std::cerr << "Error: invalid write policy.\n";
-        std::exit(EXIT_FAILURE);
-    } else if (write_through == "write-back") {
-        is_write_through = false;
+    if (is_sampled) {
+        // simulate a sample of the trace and estimate the full run
+        if (threads > 1 || is_coherent || !tlb_levels.empty() || attribution.enabled() || sample_interval > 0
+            || stats_format != STATS_TEXT) {
+            std::cerr << "Error: --sample-sets and --sample-time do not support --threads, --coherence, --tlb, "
+                         "attribution, --sample-interval or --stats-format.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (policy == POLICY_OPT) {
+            std::cerr << "Error: --sample-sets and --sample-time do not support opt.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        // these models span sets, which set sampling maps to a smaller cache
+        if (sampling.kind == SAMPLE_SETS
+            && (prefetch.kind != PREFETCH_NONE || victim_entries > 0 || write_buffer_depth > 0)) {
+            std::cerr << "Error: --sample-sets does not support --prefetch, --victim-cache or --write-buffer.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (!Sampled_Simulator::validate(config, sampling, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        Sampled_Simulator sampled(config, sampling);
+        sampled.cache().set_prefetcher(prefetch);
+        sampled.cache().set_victim_cache(victim_entries);
+        sampled.cache().set_write_buffer(write_buffer_depth);
+        run_trace(sampled, nargs == 7 ? args[6] : nullptr, false);
+        sampled.print_stats(std::cout);
+        return 0;
     }
 
-    // Check if eviction policy is valid
-    if (!(eviction == "lru" || eviction == "fifo")) {
-        std::cerr << "Error: invalid eviction policy.\n";
-        std::exit(EXIT_FAILURE);
-    } else if (eviction == "fifo") {
-        is_eviction = false;
+    if (is_coherent) {
+        // one private cache of this configuration per core of the trace
+        if (threads > 1 || prefetch.kind != PREFETCH_NONE || !tlb_levels.empty() || attribution.enabled()) {
+            std::cerr << "Error: --coherence does not support --threads, --prefetch, --tlb or attribution.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (!Coherence_Simulator::validate(config, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        Coherence_Simulator coherent(config, coherence);
+        run_trace(coherent, nargs == 7 ? args[6] : nullptr, false);
+        if (coherent.failed()) {
+            std::cerr << "Error: core ids must be below 64.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        coherent.print_stats();
+        return 0;
     }
 
-    // Check if no-write-allocate and write-back were both specified
-    if (!is_write_allocate && !is_write_through) {
-        std::cerr << "Error: invalid combination of write policies.\n";
-        std::exit(EXIT_FAILURE);
+    if (!tlb_levels.empty()) {
+        // translate every access, then run it through one cache
+        if (threads > 1) {
+            std::cerr << "Error: --threads does not support --tlb.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (walk_through_cache && (policy == POLICY_OPT || attribution.enabled())) {
+            std::cerr << "Error: --walk-through-cache does not support opt or attribution.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (!Tlb_Simulator::validate(tlb_levels, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
+        }
+        Cache_Simulator cache(n_sets, n_blocks_per_set, n_bytes_per_block, is_write_allocate, is_write_through,
+                              policy);
+        cache.set_prefetcher(prefetch);
+        cache.set_victim_cache(victim_entries);
+        cache.set_write_buffer(write_buffer_depth);
+        if (attribution.enabled()) {
+            cache.set_attribution(&attribution);
+        }
+        Tlb_Simulator tlb(tlb_levels, pages, cache, walk_through_cache, walk_latency);
+        run_trace(tlb, nargs == 7 ? args[6] : nullptr, policy == POLICY_OPT, attribution.counts_pcs());
+        tlb.print_stats();
+        if (attribution.enabled()) {
+            attribution.print(std::cout, attribute_top);
+        }
+        return 0;
     }
 
-    // store processor status and traces
-    std::vector<std::pair<char, std::string>> input = get_input();
+    if (threads > 1) {
+        // each thread simulates a disjoint range of sets (prefetches would
+        // cross the ranges)
+        if (prefetch.kind != PREFETCH_NONE || attribution.enabled() || sample_interval > 0) {
+            std::cerr << "Error: --threads does not support --prefetch, attribution or sampling.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        if (policy == POLICY_OPT) {
+            std::cerr << "Error: --threads does not support opt.\n";
+            std::exit(EXIT_FAILURE);
+        }
+        Parallel_Simulator parallel(threads, n_sets, n_blocks_per_set, n_bytes_per_block, is_write_allocate,
+                                    is_write_through, policy);
+        run_trace(parallel, nargs == 7 ? args[6] : nullptr, false);
+        const Cache_Simulator &merged = parallel.finish();
+        if (stats_format == STATS_TEXT) {
+            merged.print_stats();
+        } else {
+            write_stats(std::cout, stats_format, config, merged.counters());
+        }
+        return 0;
+    }
 
     // Create cache object
-    Cache_Simulator cache_simlator(n_sets, n_blocks_per_set, n_bytes_per_block, is_write_allocate, is_write_through, is_eviction);
-
-    for (auto &line : input) { // process each line from input
-        if (line.first == 'l') { // 'l' for loading from memory
-            cache_simlator.load(line.second);
-        } else { // 's' for storing to memory
-            cache_simlator.store(line.second);
+    Cache_Simulator cache_simlator(n_sets, n_blocks_per_set, n_bytes_per_block, is_write_allocate, is_write_through, policy);
+    cache_simlator.set_prefetcher(prefetch);
+    cache_simlator.set_victim_cache(victim_entries);
+    cache_simlator.set_write_buffer(write_buffer_depth);
+    if (attribution.enabled()) {
+        cache_simlator.set_attribution(&attribution);
+    }
+    if (sample_interval > 0) {
+        Interval_Sampler sampler(cache_simlator, sample_interval);
+        run_trace(sampler, nargs == 7 ? args[6] : nullptr, policy == POLICY_OPT, attribution.counts_pcs());
+        sampler.finish();
+        if (!sampler.write(samples_path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            std::exit(EXIT_FAILURE);
         }
-        cache_simlator.inc_timer();
+    } else {
+        run_trace(cache_simlator, nargs == 7 ? args[6] : nullptr, policy == POLICY_OPT, attribution.counts_pcs());
     }
     // print summary information for the cache object
-    cache_simlator.print_stats();
+    if (stats_format == STATS_TEXT) {
+        cache_simlator.print_stats();
+    } else {
+        write_stats(std::cout, stats_format, config, cache_simlator.counters());
+    }
+    if (attribution.enabled()) {
+        attribution.print(std::cout, attribute_top);
+    }
     return 0;
 }
\ No newline at end of file
@@ -3,14 +3,76 @@
  * Jiwon Moon, Hajin Jang
  */
 
+#include <algorithm>
 #include <cstdint>
+#include <iomanip>
 #include <iostream>
 #include <vector>
 #include <string>
-#include <cmath>
 #include <sstream>
 #include "cache_simulator.h"
 
+/*
+ * Type-erased handle on a policy. Each virtual call runs a whole access (or a
+ * batch of them) with the concrete policy, so the dispatch is not paid per way.
+ */
+class Cache_Simulator::Replacement_Engine {
+public:
+    virtual ~Replacement_Engine() { }
+    virtual void access(Cache_Simulator &cache, uint64_t address, bool is_store) = 0;
+    virtual void access_batch(Cache_Simulator &cache, const Trace_Record *records, size_t n) = 0;
+    virtual bool probe(Cache_Simulator &cache, uint64_t address, bool is_store, uint64_t use) = 0;
+    virtual bool insert(Cache_Simulator &cache, uint64_t address, bool dirty, Cache_Block &victim, uint64_t use) = 0;
+    virtual uint32_t victim(uint32_t index, uint64_t now) = 0;
+    virtual void set_next_use(const uint64_t *next_use, uint64_t length) = 0;
+};
+
+template <class Policy>
+class Cache_Simulator::Policy_Engine : public Cache_Simulator::Replacement_Engine {
+private:
+    Policy policy;
+
+public:
+    Policy_Engine(uint32_t num_sets, uint32_t num_ways) {
+        policy.init(num_sets, num_ways);
+    }
+
+    void access(Cache_Simulator &cache, uint64_t address, bool is_store) {
+        cache.access(policy, address, is_store);
+    }
+
+    void access_batch(Cache_Simulator &cache, const Trace_Record *records, size_t n) {
+        if (cache.attribution != nullptr) {
+            for (size_t i = 0; i < n; i++) {
+                cache.attribution->begin(records[i]);
+                cache.access(policy, records[i].address, records[i].is_store);
+                cache.timer++;
+            }
+            return;
+        }
+        for (size_t i = 0; i < n; i++) {
+            cache.access(policy, records[i].address, records[i].is_store);
+            cache.timer++;
+        }
+    }
+
+    bool probe(Cache_Simulator &cache, uint64_t address, bool is_store, uint64_t use) {
+        return cache.probe_block(policy, address, is_store, use);
+    }
+
+    bool insert(Cache_Simulator &cache, uint64_t address, bool dirty, Cache_Block &victim, uint64_t use) {
+        return cache.insert_block(policy, address, dirty, victim, use);
+    }
+
+    uint32_t victim(uint32_t index, uint64_t now) {
+        return policy.victim(index, now);
+    }
+
+    void set_next_use(const uint64_t *next_use, uint64_t length) {
+        policy.set_next_use(next_use, length);
+    }
+};
+
 /**
  * Cache_Simulator constructor that instantiates every variable.
  * 
@@ -22,7 +84,23 @@
  * @param evictionType a flag indicating whether LRU or FIFO eviction is used
  */
 Cache_Simulator::Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_set, unsigned int n_bytes_per_block, 
-                                bool is_write_allocate, bool is_write_through, bool eviction_type) {
+                                bool is_write_allocate, bool is_write_through, bool eviction_type)
+    : Cache_Simulator(n_sets, n_blocks_per_set, n_bytes_per_block, is_write_allocate, is_write_through,
+                      eviction_type ? POLICY_LRU : POLICY_FIFO) {
+}
+
+/**
+ * Cache_Simulator constructor with any replacement policy.
+ * 
+ * @param n_sets the number of sets in the cache
+ * @param n_blocks_per_set the number of blocks/slots per set in the cache
+ * @param n_bytes_per_block the number of bytes per block in the cache
+ * @param is_write_allocate a flag indicating whether write allocate is enabled
+ * @param is_write_through a flag indicating whether write through is enabled
+ * @param policy the replacement policy
+ */
+Cache_Simulator::Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_set, unsigned int n_bytes_per_block, 
+                                bool is_write_allocate, bool is_write_through, Replacement_Policy policy) {
     num_sets = n_sets;
     num_slots = n_blocks_per_set;
     num_bytes = n_bytes_per_block;
@@ -33,26 +111,53 @@ Cache_Simulator::Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_
     store_hits = 0;
     store_misses = 0;
     num_cycles = 0;
+    num_writebacks = 0;
     timer = 0;
-    // Create cache structure by instantiating every variable. Vector of sets that 
-    // each set contains vector of slot that each slot (struct) contains informations about
-    // itself (tag, load_ts, access_ts, valid, dirty). 
-    std::vector<std::vector<Slot>> allSets(num_sets);
-    for (std::vector<Slot> sets : allSets) {
-        std::vector<Slot> emptySet(num_slots);
-        sets = emptySet;
-        for (Slot& block : sets) {
-            block.tag = 0;
-            block.load_ts = 0;
-            block.access_ts = 0;
-            block.valid = false;
-            block.dirty = false;
-        }
-    }
-    cache = allSets;
+    num_prefetches = 0;
+    prefetch_fills = 0;
+    useful_prefetches = 0;
+    attribution = nullptr;
+    victim_hits = 0;
+    // Create the flat cache structure: one tag per way, valid and dirty bitmasks
+    // per set, all clear.
+    words_per_set = (num_slots + 63) / 64;
+    tags.assign((size_t) num_sets * num_slots, 0);
+    partial_tags.assign((size_t) num_sets * num_slots, 0);
+    match_tags = select_tag_match(std::min(num_slots, 64U));
+    valid_bits.assign((size_t) num_sets * words_per_set, 0);
+    dirty_bits.assign((size_t) num_sets * words_per_set, 0);
     this->is_write_allocate = is_write_allocate; // false if no-write-allocate
     this->is_write_through = is_write_through; // false if write-back
-    this->eviction_type = eviction_type; // true if lru, false if fifo
+    this->policy = policy;
+    switch (policy) {
+    case POLICY_LRU:       engine.reset(new Policy_Engine<Lru_Policy>(num_sets, num_slots)); break;
+    case POLICY_FIFO:      engine.reset(new Policy_Engine<Fifo_Policy>(num_sets, num_slots)); break;
+    case POLICY_RANDOM:    engine.reset(new Policy_Engine<Random_Policy>(num_sets, num_slots)); break;
+    case POLICY_TREE_PLRU: engine.reset(new Policy_Engine<Tree_Plru_Policy>(num_sets, num_slots)); break;
+    case POLICY_BIT_PLRU:  engine.reset(new Policy_Engine<Bit_Plru_Policy>(num_sets, num_slots)); break;
+    case POLICY_LFU:       engine.reset(new Policy_Engine<Lfu_Policy>(num_sets, num_slots)); break;
+    case POLICY_SRRIP:     engine.reset(new Policy_Engine<Srrip_Policy>(num_sets, num_slots)); break;
+    case POLICY_BRRIP:     engine.reset(new Policy_Engine<Brrip_Policy>(num_sets, num_slots)); break;
+    case POLICY_OPT:       engine.reset(new Policy_Engine<Opt_Policy>(num_sets, num_slots)); break;
+    }
+    // sets and block sizes are powers of 2, so the index and offset widths are
+    // exact and decoding an address is two shifts and a mask
+    offset_bits = 0;
+    while ((1U << offset_bits) < n_bytes_per_block) {
+        offset_bits++;
+    }
+    index_bits = 0;
+    while ((1U << index_bits) < n_sets) {
+        index_bits++;
+    }
+    index_mask = (uint64_t(1) << index_bits) - 1;
+    // both are at most 31 bits, so the tag shift is always below 64
+    tag_shift = index_bits + offset_bits;
+}
+
+
+
+Cache_Simulator::~Cache_Simulator() {
 }
 
 
@@ -60,13 +165,96 @@ Cache_Simulator::Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_
  * Function to print the summary information in given format.
  */
 void Cache_Simulator::print_stats() const {
-    std::cout << "Total loads: " << num_loads << "\n";
-    std::cout << "Total stores: " << num_stores << "\n";
-    std::cout << "Load hits: " << load_hits << "\n";
-    std::cout << "Load misses: " << load_misses << "\n";
-    std::cout << "Store hits: " << store_hits << "\n";
-    std::cout << "Store misses: " << store_misses << "\n";
-    std::cout << "Total cycles: " << num_cycles << "\n";
+    print_stats(std::cout);
+}
+
+/**
+ * Prints the summary information to the given stream.
+ * 
+ * @param out the stream to print to
+ */
+void Cache_Simulator::print_stats(std::ostream &out) const {
+    out << "Total loads: " << num_loads << "\n";
+    out << "Total stores: " << num_stores << "\n";
+    out << "Load hits: " << load_hits << "\n";
+    out << "Load misses: " << load_misses << "\n";
+    out << "Store hits: " << store_hits << "\n";
+    out << "Store misses: " << store_misses << "\n";
+    out << "Total cycles: " << num_cycles << "\n";
+    if (prefetcher) {
+        // coverage: demand misses the prefetcher removed, accuracy: prefetch
+        // fills that were used before being evicted (or the end of the trace)
+        uint64_t misses = load_misses + store_misses;
+        out << "Prefetches issued: " << num_prefetches << "\n";
+        out << "Prefetch fills: " << prefetch_fills << "\n";
+        out << "Useful prefetches: " << useful_prefetches << "\n";
+        out << "Useless prefetches: " << prefetch_fills - useful_prefetches << "\n";
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        out << std::fixed << std::setprecision(2);
+        out << "Prefetch coverage: "
+            << (useful_prefetches + misses > 0 ? 100.0 * useful_prefetches / (useful_prefetches + misses) : 0.0)
+            << "%\n";
+        out << "Prefetch accuracy: "
+            << (prefetch_fills > 0 ? 100.0 * useful_prefetches / prefetch_fills : 0.0) << "%\n";
+        out.flags(flags);
+        out.precision(precision);
+    }
+    if (victims) {
+        out << "Conflict misses saved by victim cache: " << victim_hits << "\n";
+    }
+    if (write_buffer) {
+        out << "Write buffer writes: " << write_buffer->writes() << "\n";
+        out << "Write buffer coalesced writes: " << write_buffer->coalesced() << "\n";
+        out << "Store stalls hidden by write buffer: " << write_buffer->writes() - write_buffer->stalls() << "\n";
+        out << "Write buffer full stalls: " << write_buffer->stalls() << "\n";
+        out << "Write buffer stall cycles: " << write_buffer->stalled_cycles() << "\n";
+    }
+}
+
+/**
+ * @return the counters so far
+ */
+Cache_Counters Cache_Simulator::counters() const {
+    Cache_Counters counters;
+    counters.loads = num_loads;
+    counters.load_hits = load_hits;
+    counters.load_misses = load_misses;
+    counters.stores = num_stores;
+    counters.store_hits = store_hits;
+    counters.store_misses = store_misses;
+    counters.cycles = num_cycles;
+    counters.writebacks = num_writebacks;
+    counters.prefetches = num_prefetches;
+    counters.prefetch_fills = prefetch_fills;
+    counters.useful_prefetches = useful_prefetches;
+    counters.victim_hits = victim_hits;
+    counters.buffered_writes = write_buffer ? write_buffer->writes() : 0;
+    counters.coalesced_writes = write_buffer ? write_buffer->coalesced() : 0;
+    counters.write_stalls = write_buffer ? write_buffer->stalls() : 0;
+    counters.write_stall_cycles = write_buffer ? write_buffer->stalled_cycles() : 0;
+    return counters;
+}
+
+/**
+ * Adds the counters of another simulator of the same geometry to this one,
+ * e.g. one that simulated a disjoint part of the sets.
+ * 
+ * @param other the simulator whose counters are added
+ */
+void Cache_Simulator::merge_stats(const Cache_Simulator &other) {
+    num_loads += other.num_loads;
+    load_hits += other.load_hits;
+    load_misses += other.load_misses;
+    num_stores += other.num_stores;
+    store_hits += other.store_hits;
+    store_misses += other.store_misses;
+    num_cycles += other.num_cycles;
+    num_writebacks += other.num_writebacks;
+    num_prefetches += other.num_prefetches;
+    prefetch_fills += other.prefetch_fills;
+    useful_prefetches += other.useful_prefetches;
+    victim_hits += other.victim_hits;
 }
 
 /**
@@ -76,14 +264,18 @@ void Cache_Simulator::print_stats() const {
  * @return true if the memory address is found in the cache, false otherwise
  */
 bool Cache_Simulator::check_cache_hit(std::string address) {
-    uint32_t tag = get_tag(address); // extract tag from address
-    uint32_t index = get_index(address); // extract index from address
-    for (auto &slot : cache[index]) { // loop through all slots in the cache set
-        if (slot.tag == tag && slot.valid) { // check if the tag matches and the slot is valid
-            return true; // cache hit
-        }
-    }
-    return false; // cache miss
+    return check_cache_hit(stoull(address, nullptr, 16));
+}
+
+/**
+ * Check if the given (decoded) memory address is present in the cache.
+ * 
+ * @param address the memory address to check
+ * @return true if the memory address is found in the cache, false otherwise
+ */
+bool Cache_Simulator::check_cache_hit(uint64_t address) {
+    // a hit is a valid way in the address's set with a matching tag
+    return find_way(get_tag(address), get_index(address)) >= 0;
 }
 
 /**
@@ -93,62 +285,42 @@ bool Cache_Simulator::check_cache_hit(std::string address) {
  * @return void
  */
 void Cache_Simulator::load(std::string address) {
-    num_loads++; // increment number of loads
-    // get tag and index from address
-    uint32_t tag = get_tag(address);
-    uint32_t index = get_index(address);
-    if (check_cache_hit(address)) { // check if cache hit
-        // update access timestamp and increment load hits
-        cache[index].at(find_tag(tag, index)).access_ts = timer;
-        load_hits++;
-        num_cycles++; // increment cycles for cache hit
-    } else {
-        remove(address); // evict block from cache
-        Slot slot;
-        slot.tag = tag; // set tag and timestamps
-        slot.load_ts = timer;
-        slot.access_ts = timer;
-        slot.valid = true; // mark as valid
-        slot.dirty = false; // mark as not dirty
-        cache.at(index).push_back(slot); // add new block to cache
-        load_misses++; // increment load misses
-        num_cycles += 100 * num_bytes / 4; // increment cycles for cache miss
-    }
+    load(stoull(address, nullptr, 16));
+}
+
+/**
+ * Load data from a decoded memory address into the cache.
+ * 
+ * @param address the memory address to load data from
+ */
+void Cache_Simulator::load(uint64_t address) {
+    engine->access(*this, address, false);
 }
 
 
 /**
  * Removes the block associated with the given memory address from the cache if the cache is full. 
- * Uses a specific eviction policy (either Least Recently Used or Least Recently Loaded) to determine 
- * which block to evict. If the removed block is dirty and the cache is not write-through, adds additional 
+ * Uses the replacement policy to determine which block to evict. If the removed block is dirty and the cache is not write-through, adds additional 
  * cycles to simulate writing the block back to memory. 
  * 
  * @param address the memory address of the block to remove from the cache
  */
 void Cache_Simulator::remove(std::string address) {
-    uint32_t temp_tag;   // stores the tag of the block to be removed
+    remove(stoull(address, nullptr, 16));
+}
+
+/**
+ * Evicts a block from the set the given decoded address maps to, if the set is full.
+ * 
+ * @param address the memory address of the block to remove from the cache
+ */
+void Cache_Simulator::remove(uint64_t address) {
     uint32_t index = get_index(address);   // gets the index of the block to be removed
-    uint32_t min_ts = 4294967295;   // sets the minimum timestamp to the maximum possible value
-    if (cache.at(index).size() < (unsigned) num_slots) {   // if the cache is not full, do nothing
+    // if the set still has an invalid way, nothing has to be evicted
+    if (free_way(index) >= 0) {
         return;
     }
-    // find the block with the smallest timestamp
-    for (auto &slot : cache.at(index)) {
-        if (eviction_type && slot.access_ts < min_ts) {   // for LRU eviction
-            min_ts = slot.access_ts;
-            temp_tag = slot.tag;
-        } else if (!eviction_type && slot.load_ts < min_ts) {   // for FIFO eviction
-            min_ts = slot.load_ts;
-            temp_tag = slot.tag;
-        }
-    }
-    // if the cache uses write-back policy and the block being removed is dirty, 
-    // add additional cycles to write back to main memory
-    if (!is_write_through && cache.at(index).at(find_tag(temp_tag, index)).dirty) {
-        num_cycles += (100 * (num_bytes / 4));
-    }
-    // remove the block from the cache
-    cache.at(index).erase(cache.at(index).begin() + find_tag(temp_tag, index));
+    evict(index, engine->victim(index, timer));
 }
 
 
@@ -160,38 +332,16 @@ void Cache_Simulator::remove(std::string address) {
  * @param address the memory address to store the value at
  */
 void Cache_Simulator::store(std::string address) {
-    num_stores++;
-    uint32_t tag = get_tag(address);
-    uint32_t index = get_index(address);
-    if(check_cache_hit(address)) { // if address is in cache
-        store_hits++;
-        cache[index].at(find_tag(tag, index)).access_ts = timer; // update access timestamp
-        cache[index].at(find_tag(tag, index)).dirty = true; // set dirty bit
-        if (is_write_through) { 
-            num_cycles += 101; 
-        } else {
-            num_cycles++; 
-        }
-    } else { // if address is not in cache
-        store_misses++;
-        if (is_write_allocate) { // if write-allocate
-            remove(address); // remove victim block from cache
-            Slot slot;
-            slot.tag = tag;
-            slot.load_ts = timer;
-            slot.access_ts = timer;
-            slot.valid = true;
-            slot.dirty = false;
-            cache.at(index).push_back(slot); // insert new block into cache
-            cache[index].at(find_tag(tag, index)).dirty = true; // set dirty bit
-            num_cycles += 100 * (num_bytes / 4) + 1 ; // add cycles for cache miss and load
-        }
-        if (is_write_through) { 
-            num_cycles += 101;
-        } else {
-            num_cycles++;
-        }
-    }
+    store(stoull(address, nullptr, 16));
+}
+
+/**
+ * Stores a value at the specified decoded memory address in the cache.
+ * 
+ * @param address the memory address to store the value at
+ */
+void Cache_Simulator::store(uint64_t address) {
+    engine->access(*this, address, true);
 }
 
 
@@ -201,11 +351,19 @@ void Cache_Simulator::store(std::string address) {
  * @param address The address to extract the tag from.
  * @return The tag bits of the given address.
  */
-uint32_t Cache_Simulator::get_tag(std::string address) {
-    uint32_t tag = stol(address, nullptr, 16);
-    uint32_t indexBits = log2(num_sets);
-    uint32_t offsetBits = log2(num_bytes);
-    return tag >> (indexBits + offsetBits);
+uint64_t Cache_Simulator::get_tag(std::string address) {
+    return get_tag(stoull(address, nullptr, 16));
+}
+
+
+/**
+ * Extracts the tag bits from the given decoded address.
+ * 
+ * @param address The address to extract the tag from.
+ * @return The tag bits of the given address.
+ */
+uint64_t Cache_Simulator::get_tag(uint64_t address) const {
+    return address >> tag_shift;
 }
 
 
@@ -216,13 +374,18 @@ uint32_t Cache_Simulator::get_tag(std::string address) {
  * @return The index of the cache block that the memory address maps to.
  */
 uint32_t Cache_Simulator::get_index(std::string trace) {
-    uint32_t address = stol(trace, nullptr, 16);
-    uint32_t indexBits = log2(num_sets);
-    uint32_t offsetBits = log2(num_bytes);
-    uint32_t tagBits = 32U - (indexBits + offsetBits);
-    // 64 bit to capture potential larger shifts
-    uint64_t index = address << tagBits;
-    return index >> (tagBits + offsetBits); // will drop to 32 bit
+    return get_index(stoull(trace, nullptr, 16));
+}
+
+
+/**
+ * Calculates the index of the set that the given decoded address maps to.
+ *
+ * @param address The memory address to map to an index.
+ * @return The index of the cache block that the memory address maps to.
+ */
+uint32_t Cache_Simulator::get_index(uint64_t address) const {
+    return (address >> offset_bits) & index_mask;
 }
 
 
@@ -241,17 +404,369 @@ void Cache_Simulator::inc_timer() {
  * @param index the index to search in
  * @return the index of the slot if found, and 0 otherwise
 */
-uint32_t Cache_Simulator::find_tag(uint32_t tag, uint32_t index) {
-    std::vector<Slot> set = cache.at(index);
-    // iterate through set to find index of tag
-    for (int i = 0; i < (int) set.size(); i++) {
-        int counter = 0;
-        for (auto t : set) {
-            if (t.tag == tag) {
-                return counter;
+uint32_t Cache_Simulator::find_tag(uint64_t tag, uint32_t index) {
+    int way = find_way(tag, index);
+    return way >= 0 ? way : 0;
+}
+
+
+/**
+ * Finds the way of the given set that holds a valid block with the given tag.
+ *
+ * @return the way, or -1 on a miss
+ */
+int Cache_Simulator::find_way(uint64_t tag, uint32_t index) const {
+    const uint64_t *set_tags = &tags[(size_t) index * num_slots];
+    const uint16_t *set_partial_tags = &partial_tags[(size_t) index * num_slots];
+    const uint64_t *valid = &valid_bits[index * words_per_set];
+    // match up to 64 partial tags at a time into a mask of candidate ways, then
+    // confirm the candidates (almost always at most one) against the full tag
+    for (unsigned w = 0; w < words_per_set; w++) {
+        unsigned base = w * 64;
+        unsigned n = std::min(64U, num_slots - base);
+        uint64_t match = match_tags(set_partial_tags + base, n, (uint16_t) tag) & valid[w];
+        while (match != 0) {
+            unsigned way = base + __builtin_ctzll(match);
+            if (set_tags[way] == tag) {
+                return way;
+            }
+            match &= match - 1;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Finds an invalid way of the given set.
+ *
+ * @return the way, or -1 if the set is full
+ */
+int Cache_Simulator::free_way(uint32_t index) const {
+    const uint64_t *valid = &valid_bits[index * words_per_set];
+    for (unsigned w = 0; w < words_per_set; w++) {
+        if (~valid[w] != 0) {
+            unsigned way = w * 64 + __builtin_ctzll(~valid[w]);
+            return way < num_slots ? (int) way : -1;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * Invalidates a way, writing it back first if it is dirty. With a victim
+ * cache the block moves there instead, and the block it displaces is written
+ * back if dirty.
+ */
+void Cache_Simulator::evict(uint32_t index, uint32_t way) {
+    if (victims) {
+        uint64_t displaced;
+        bool displaced_dirty;
+        uint64_t address = (tags[(size_t) index * num_slots + way] << tag_shift) | ((uint64_t) index << offset_bits);
+        if (victims->insert(address, !is_write_through && test_bit(dirty_bits, index, way), displaced, displaced_dirty)
+            && displaced_dirty) {
+            write_back(displaced);
+        }
+    } else if (!is_write_through && test_bit(dirty_bits, index, way)) {
+        // if the cache uses write-back policy and the block being removed is dirty, 
+        // add additional cycles to write back to main memory
+        write_back((tags[(size_t) index * num_slots + way] << tag_shift) | ((uint64_t) index << offset_bits));
+    }
+    if (prefetcher) {
+        set_bit(prefetched_bits, index, way, false);
+    }
+    set_bit(valid_bits, index, way, false);
+    set_bit(dirty_bits, index, way, false);
+}
+
+
+/**
+ * Writes a dirty block back to memory.
+ */
+void Cache_Simulator::write_back(uint64_t address) {
+    num_cycles += 100 * uint64_t(num_bytes / 4);
+    num_writebacks++;
+    if (attribution != nullptr) {
+        attribution->writeback(address);
+    }
+}
+
+
+/**
+ * Fills the given tag into an invalid way, valid and not dirty.
+ */
+void Cache_Simulator::fill(uint64_t tag, uint32_t index, uint32_t way) {
+    tags[(size_t) index * num_slots + way] = tag;
+    partial_tags[(size_t) index * num_slots + way] = (uint16_t) tag;
+    set_bit(valid_bits, index, way, true);
+    set_bit(dirty_bits, index, way, false);
+}
+
+
+/**
+ * Performs one load or store with the given policy.
+ */
+template <class Policy>
+void Cache_Simulator::access(Policy &policy, uint64_t address, bool is_store) {
+    uint64_t tag = get_tag(address);
+    uint32_t index = get_index(address);
+    int way = find_way(tag, index);
+    if (is_store) {
+        num_stores++;
+    } else {
+        num_loads++;
+    }
+    if (way >= 0) { // cache hit
+        policy.on_hit(index, way, timer);
+        if (is_store) {
+            store_hits++;
+            set_bit(dirty_bits, index, way, true);
+            num_cycles += is_write_through ? write_through_cycles(address) : 1;
+        } else {
+            load_hits++;
+            num_cycles++;
+        }
+        if (prefetcher) {
+            // the first demand hit on a prefetched block makes the prefetch useful
+            bool prefetched_hit = test_bit(prefetched_bits, index, way);
+            if (prefetched_hit) {
+                set_bit(prefetched_bits, index, way, false);
+                useful_prefetches++;
+            }
+            prefetch(policy, address, false, prefetched_hit);
+        }
+        return;
+    }
+    if (attribution != nullptr) {
+        attribution->miss();
+    }
+    bool victim_dirty;
+    if (victims && victims->take((address >> offset_bits) << offset_bits, victim_dirty)) {
+        // swap the block back from the victim cache, whatever the write policy
+        is_store ? store_misses++ : load_misses++;
+        victim_hits++;
+        int filled = free_way(index);
+        if (filled < 0) {
+            filled = policy.victim(index, timer);
+            evict(index, filled);
+        }
+        fill(tag, index, filled);
+        set_bit(dirty_bits, index, filled, victim_dirty || is_store);
+        policy.on_fill(index, filled, timer);
+        num_cycles += VICTIM_HIT_CYCLES;
+        if (is_store) {
+            num_cycles += 1 + (is_write_through ? write_through_cycles(address) : 1);
+        }
+        if (prefetcher) {
+            prefetch(policy, address, true, false);
+        }
+        return;
+    }
+    if (is_store) {
+        store_misses++;
+        if (!is_write_allocate) { // the store goes straight to memory
+            num_cycles += is_write_through ? write_through_cycles(address) : 1;
+            if (prefetcher) {
+                prefetch(policy, address, true, false);
             }
-            counter++;
+            return;
         }
+    } else {
+        load_misses++;
+    }
+    // allocate: take an invalid way, or evict the policy's victim of a full set
+    int filled = free_way(index);
+    if (filled < 0) {
+        filled = policy.victim(index, timer);
+        evict(index, filled);
+    }
+    fill(tag, index, filled);
+    policy.on_fill(index, filled, timer);
+    num_cycles += 100 * uint64_t(num_bytes / 4); // load the block from memory
+    if (is_store) {
+        set_bit(dirty_bits, index, filled, true);
+        num_cycles += 1 + (is_write_through ? write_through_cycles(address) : 1);
     }
-    return 0;
-}
\ No newline at end of file
+    if (prefetcher) {
+        prefetch(policy, address, true, false);
+    }
+}
+
+
+/**
+ * Lets the prefetcher observe a demand access and fills the blocks it names.
+ * A prefetch fill evicts like a demand fill but costs no cycles itself.
+ */
+template <class Policy>
+void Cache_Simulator::prefetch(Policy &policy, uint64_t address, bool miss, bool prefetched_hit) {
+    prefetch_blocks.clear();
+    prefetcher->observe(address >> offset_bits, miss, prefetched_hit, prefetch_blocks);
+    for (uint64_t block : prefetch_blocks) {
+        uint64_t block_address = block << offset_bits;
+        uint64_t tag = get_tag(block_address);
+        uint32_t index = get_index(block_address);
+        num_prefetches++;
+        if (find_way(tag, index) >= 0 || (victims && victims->contains(block_address))) {
+            continue; // already cached
+        }
+        int way = free_way(index);
+        if (way < 0) {
+            way = policy.victim(index, timer);
+            evict(index, way);
+        }
+        fill(tag, index, way);
+        policy.on_fill(index, way, timer);
+        set_bit(prefetched_bits, index, way, true);
+        prefetch_fills++;
+    }
+}
+
+
+/**
+ * Attaches a prefetcher. Not supported with OPT, whose next-use index
+ * only describes demand accesses.
+ * 
+ * @param config the prefetcher, or PREFETCH_NONE to detach it
+ */
+void Cache_Simulator::set_prefetcher(const Prefetcher_Config &config) {
+    prefetcher = Prefetcher::create(config, offset_bits);
+    prefetched_bits.assign(prefetcher ? valid_bits.size() : 0, 0);
+}
+
+
+/**
+ * Attaches a fully associative victim cache.
+ * 
+ * @param entries the number of blocks it holds, or 0 to detach it
+ */
+void Cache_Simulator::set_victim_cache(unsigned entries) {
+    victims.reset(entries > 0 ? new Victim_Cache(entries) : nullptr);
+}
+
+
+/**
+ * Attaches a coalescing write buffer. Only write-through stores use it.
+ * 
+ * @param depth the number of blocks it holds, or 0 to detach it
+ */
+void Cache_Simulator::set_write_buffer(unsigned depth) {
+    write_buffer.reset(depth > 0 ? new Write_Buffer(depth) : nullptr);
+}
+
+
+/**
+ * Runs a batch of decoded trace records through the cache, incrementing
+ * the timer after each one.
+ * 
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Cache_Simulator::access_batch(const Trace_Record *records, size_t n) {
+    engine->access_batch(*this, records, n);
+}
+
+
+/**
+ * Gives the replacement policy the next-use index of the trace. Only OPT
+ * uses it; entry i must describe the access made at timer value i.
+ * 
+ * @param next_use the next-use index (see Next_Use_Index)
+ * @param length the number of entries
+ */
+void Cache_Simulator::set_next_use(const uint64_t *next_use, uint64_t length) {
+    engine->set_next_use(next_use, length);
+}
+
+
+/**
+ * Looks up the block holding an address on behalf of a cache hierarchy.
+ * A hit updates the replacement state and, for a store, marks the block
+ * dirty. The statistics counters are not touched.
+ * 
+ * @param address the memory address to look up
+ * @param is_store true if the access writes the block
+ * @param use the index of the block's latest access in the trace, which the
+ *        replacement policy is given in place of the timer (so OPT keys a
+ *        victim moved between levels by its own next use), or UINT64_MAX
+ *        for the current access
+ * @return true on a hit
+ */
+bool Cache_Simulator::probe(uint64_t address, bool is_store, uint64_t use) {
+    return engine->probe(*this, address, is_store, use == UINT64_MAX ? timer : use);
+}
+
+
+/**
+ * Fills the block holding an address (which must not be present) on behalf
+ * of a cache hierarchy, evicting the replacement policy's victim if the set
+ * is full. The statistics counters are not touched.
+ * 
+ * @param address the memory address whose block is filled
+ * @param dirty whether the filled block is dirty
+ * @param victim set to the evicted block, if any
+ * @param use the index of the block's latest access in the trace, which the
+ *        replacement policy is given in place of the timer (so OPT keys a
+ *        victim moved between levels by its own next use), or UINT64_MAX
+ *        for the current access
+ * @return true if a valid block was evicted
+ */
+bool Cache_Simulator::insert(uint64_t address, bool dirty, Cache_Block &victim, uint64_t use) {
+    return engine->insert(*this, address, dirty, victim, use == UINT64_MAX ? timer : use);
+}
+
+
+/**
+ * Invalidates the block holding an address, if present.
+ * 
+ * @param address the memory address whose block is invalidated
+ * @param dirty set to whether the invalidated block was dirty
+ * @return true if the block was present
+ */
+bool Cache_Simulator::invalidate(uint64_t address, bool &dirty) {
+    uint32_t index = get_index(address);
+    int way = find_way(get_tag(address), index);
+    if (way < 0) {
+        return false;
+    }
+    dirty = test_bit(dirty_bits, index, way);
+    set_bit(valid_bits, index, way, false);
+    set_bit(dirty_bits, index, way, false);
+    return true;
+}
+
+
+template <class Policy>
+bool Cache_Simulator::probe_block(Policy &policy, uint64_t address, bool is_store, uint64_t use) {
+    uint32_t index = get_index(address);
+    int way = find_way(get_tag(address), index);
+    if (way < 0) {
+        return false;
+    }
+    policy.on_hit(index, way, use);
+    if (is_store) {
+        set_bit(dirty_bits, index, way, true);
+    }
+    return true;
+}
+
+
+template <class Policy>
+bool Cache_Simulator::insert_block(Policy &policy, uint64_t address, bool dirty, Cache_Block &victim, uint64_t use) {
+    uint64_t tag = get_tag(address);
+    uint32_t index = get_index(address);
+    bool evicted = false;
+    int way = free_way(index);
+    if (way < 0) {
+        way = policy.victim(index, timer);
+        // rebuild the victim's block address from its tag and set
+        victim.address = (tags[(size_t) index * num_slots + way] << tag_shift)
+                         | ((uint64_t) index << offset_bits);
+        victim.dirty = test_bit(dirty_bits, index, way);
+        evicted = true;
+    }
+    fill(tag, index, way);
+    set_bit(dirty_bits, index, way, dirty);
+    policy.on_fill(index, way, use);
+    return evicted;
+}
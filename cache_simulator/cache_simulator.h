@@ -6,25 +6,101 @@
 #ifndef CACHE_SIMULATOR
 #define CACHE_SIMULATOR
 
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <ostream>
 #include <string>
 #include <utility>
 #include <vector>
+#include "attribution.h"
+#include "prefetcher.h"
+#include "replacement_policy.h"
+#include "tag_match.h"
+#include "trace.h"
+#include "victim_cache.h"
+#include "write_buffer.h"
 
-struct Slot {
-    uint32_t tag;
-    uint32_t load_ts;
-    uint32_t access_ts;
-    bool valid;
+/*
+ * A block evicted from a cache by Cache_Simulator::insert().
+ */
+struct Cache_Block {
+    uint64_t address; // address of the first byte of the block
     bool dirty;
 };
 
+/*
+ * A snapshot of the counters of a Cache_Simulator.
+ */
+struct Cache_Counters {
+    uint64_t loads, load_hits, load_misses, stores, store_hits, store_misses, cycles;
+    uint64_t writebacks; // dirty evictions
+    uint64_t prefetches, prefetch_fills, useful_prefetches;
+    uint64_t victim_hits;                                   // misses served by the victim cache
+    uint64_t buffered_writes, coalesced_writes, write_stalls, write_stall_cycles; // write buffer
+};
+
+/*
+ * The cache is stored as flat structure-of-arrays: way w of set s lives at
+ * s * num_slots + w in the tag array, and the valid/dirty bits of a set are
+ * words_per_set consecutive 64-bit words (bit w % 64 of word w / 64). A hit
+ * lookup is a compare over one contiguous run of tags, and neither a fill nor
+ * an eviction moves any memory.
+ *
+ * Each way also has a 16-bit partial tag (the low bits of its tag) in a
+ * separate array. Lookups match the partial tags with a SIMD kernel picked at
+ * run time and only confirm candidate ways against the full tag.
+ *
+ * Replacement is delegated to a policy (see replacement_policy.h). The access
+ * path is a member template instantiated once per policy, so policy calls are
+ * inlined; the policy is picked at run time once per call (or per batch of
+ * records with access_batch()), not once per way.
+ *
+ * An optional prefetcher (see prefetcher.h) observes every demand access.
+ * Prefetched ways carry a bit until their first demand hit, so useful and
+ * useless prefetches are counted separately from the demand counters.
+ *
+ * An optional Miss_Attribution (see attribution.h) is told about every
+ * access of access_batch(), its miss and the writebacks it causes.
+ *
+ * An optional victim cache (see victim_cache.h) takes every evicted block. A
+ * miss that finds its block there is still counted as a miss, but swaps the
+ * block back for VICTIM_HIT_CYCLES instead of loading it from memory. With
+ * write-through, an optional write buffer (see write_buffer.h) takes the
+ * memory write of each store, which then costs only the cycles it stalls.
+ */
 class Cache_Simulator {
+public:
+    static const uint64_t VICTIM_HIT_CYCLES = 1;
+
 private:
-    int num_sets, num_slots, num_bytes, num_loads, load_hits, load_misses, num_stores,
-        store_hits, store_misses, num_cycles, timer;
-    std::vector<std::vector<Slot>> cache;
-    bool is_write_allocate, is_write_through, eviction_type;
+    unsigned num_sets, num_slots, num_bytes;
+    // 64-bit, so long traces and large blocks (100 cycles per word) cannot overflow
+    uint64_t num_loads, load_hits, load_misses, num_stores, store_hits, store_misses, num_cycles, timer;
+    uint64_t num_writebacks;
+    unsigned words_per_set;
+    std::vector<uint64_t> tags;
+    std::vector<uint16_t> partial_tags;
+    Tag_Match_Fn match_tags;
+    std::vector<uint64_t> valid_bits;
+    std::vector<uint64_t> dirty_bits;
+    bool is_write_allocate, is_write_through;
+    Replacement_Policy policy;
+    class Replacement_Engine;
+    template <class Policy> class Policy_Engine;
+    std::unique_ptr<Replacement_Engine> engine;
+    std::unique_ptr<Prefetcher> prefetcher;
+    std::vector<uint64_t> prefetched_bits; // per way, like valid_bits: filled by a prefetch, not used yet
+    std::vector<uint64_t> prefetch_blocks; // scratch list of blocks named by the prefetcher
+    uint64_t num_prefetches, prefetch_fills, useful_prefetches;
+    Miss_Attribution *attribution; // not owned, nullptr unless attached
+    std::unique_ptr<Victim_Cache> victims;
+    uint64_t victim_hits;
+    std::unique_ptr<Write_Buffer> write_buffer;
+    // address decoding, precomputed from the geometry in the constructor; the
+    // tag is every address bit above the index, 64 - tag_shift bits wide
+    unsigned offset_bits, index_bits, tag_shift;
+    uint64_t index_mask;
 
 public:
     /**
@@ -39,12 +115,42 @@ public:
      */
     Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_set, unsigned int n_bytes_per_block, 
                     bool is_write_allocate, bool is_write_through, bool eviction_type);
+
+    /**
+     * Cache_Simulator constructor with any replacement policy.
+     * 
+     * @param n_sets the number of sets in the cache
+     * @param n_blocks_per_set the number of blocks/slots per set in the cache
+     * @param n_bytes_per_block the number of bytes per block in the cache
+     * @param is_write_allocate a flag indicating whether write allocate is enabled
+     * @param is_write_through a flag indicating whether write through is enabled
+     * @param policy the replacement policy
+     */
+    Cache_Simulator(unsigned int n_sets, unsigned int n_blocks_per_set, unsigned int n_bytes_per_block, 
+                    bool is_write_allocate, bool is_write_through, Replacement_Policy policy);
+
+    ~Cache_Simulator();
     
     /**
      * Function to print the summary information in given format.
      */
     void print_stats() const;
 
+    /**
+     * Prints the summary information to the given stream.
+     * 
+     * @param out the stream to print to
+     */
+    void print_stats(std::ostream &out) const;
+
+    /**
+     * Adds the counters of another simulator of the same geometry to this one,
+     * e.g. one that simulated a disjoint part of the sets.
+     * 
+     * @param other the simulator whose counters are added
+     */
+    void merge_stats(const Cache_Simulator &other);
+
     /**
      * Check if the given memory address is present in the cache.
      * 
@@ -53,6 +159,14 @@ public:
      */
     bool check_cache_hit(std::string address);
 
+    /**
+     * Check if the given (decoded) memory address is present in the cache.
+     * 
+     * @param address the memory address to check
+     * @return true if the memory address is found in the cache, false otherwise
+     */
+    bool check_cache_hit(uint64_t address);
+
     /**
      * Load data from memory into the cache.
      * 
@@ -61,16 +175,29 @@ public:
      */
     void load(std::string address);
 
+    /**
+     * Load data from a decoded memory address into the cache.
+     * 
+     * @param address the memory address to load data from
+     */
+    void load(uint64_t address);
+
     /**
      * Removes the block associated with the given memory address from the cache if the cache is full. 
-     * Uses a specific eviction policy (either Least Recently Used or Least Recently Loaded) to determine 
-     * which block to evict. If the removed block is dirty and the cache is not write-through, adds additional 
+     * Uses the replacement policy to determine which block to evict. If the removed block is dirty and the cache is not write-through, adds additional 
      * cycles to simulate writing the block back to memory. 
      * 
      * @param address the memory address of the block to remove from the cache
      */
     void remove(std::string address);
 
+    /**
+     * Evicts a block from the set the given decoded address maps to, if the set is full.
+     * 
+     * @param address the memory address of the block to remove from the cache
+     */
+    void remove(uint64_t address);
+
     /**
      * Stores a value at the specified memory address in the cache. Updates the cache statistics
      * accordingly, including the number of store hits and misses, and the number of cycles taken to
@@ -80,13 +207,28 @@ public:
      */
     void store(std::string address);
 
+    /**
+     * Stores a value at the specified decoded memory address in the cache.
+     * 
+     * @param address the memory address to store the value at
+     */
+    void store(uint64_t address);
+
     /**
      * This function extracts the tag bits from the given address.
      * 
      * @param address The address to extract the tag from.
      * @return The tag bits of the given address.
      */
-    uint32_t get_tag(std::string address);
+    uint64_t get_tag(std::string address);
+
+    /**
+     * Extracts the tag bits from the given decoded address.
+     * 
+     * @param address The address to extract the tag from.
+     * @return The tag bits of the given address.
+     */
+    uint64_t get_tag(uint64_t address) const;
 
     /**
      * Calculates and returns the index of the cache block that the given memory address maps to.
@@ -96,19 +238,204 @@ public:
      */
     uint32_t get_index(std::string trace);
 
+    /**
+     * Calculates the index of the set that the given decoded address maps to.
+     *
+     * @param address The memory address to map to an index.
+     * @return The index of the cache block that the memory address maps to.
+     */
+    uint32_t get_index(uint64_t address) const;
+
     /**
      * Searches for the index of the slot in the cache that has the given tag in the given index.
      * 
      * @param tag the tag to search for
      * @param index the index to search in
-     * @return the index of the slot if found, and 0 otherwise
+     * @return the way of the slot if found, and 0 otherwise
     */
-    uint32_t find_tag(uint32_t trace, uint32_t index);
+    uint32_t find_tag(uint64_t tag, uint32_t index);
 
     /**
      * Increments the timer of the cache simulator by 1.
      */
     void inc_timer();
+
+    /**
+     * Runs a batch of decoded trace records through the cache, incrementing
+     * the timer after each one.
+     * 
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Gives the replacement policy the next-use index of the trace. Only OPT
+     * uses it; entry i must describe the access made at timer value i.
+     * 
+     * @param next_use the next-use index (see Next_Use_Index)
+     * @param length the number of entries
+     */
+    void set_next_use(const uint64_t *next_use, uint64_t length);
+
+    /**
+     * Attaches a prefetcher. Not supported with OPT, whose next-use index
+     * only describes demand accesses.
+     * 
+     * @param config the prefetcher, or PREFETCH_NONE to detach it
+     */
+    void set_prefetcher(const Prefetcher_Config &config);
+
+    /**
+     * Attaches a miss attribution, which must outlive the simulator.
+     * 
+     * @param attribution the attribution, or nullptr to detach it
+     */
+    void set_attribution(Miss_Attribution *attribution) { this->attribution = attribution; }
+
+    /**
+     * Attaches a fully associative victim cache.
+     * 
+     * @param entries the number of blocks it holds, or 0 to detach it
+     */
+    void set_victim_cache(unsigned entries);
+
+    /**
+     * Attaches a coalescing write buffer. Only write-through stores use it.
+     * 
+     * @param depth the number of blocks it holds, or 0 to detach it
+     */
+    void set_write_buffer(unsigned depth);
+
+    /**
+     * @return log2 of the block size
+     */
+    unsigned block_offset_bits() const { return offset_bits; }
+
+    /**
+     * @return the width of a tag in bits
+     */
+    unsigned tag_bits() const { return 64 - tag_shift; }
+
+    /**
+     * @return the cycles counted so far
+     */
+    uint64_t total_cycles() const { return num_cycles; }
+
+    /**
+     * @return the load and store misses so far
+     */
+    uint64_t total_misses() const { return load_misses + store_misses; }
+
+    /**
+     * @return the counters so far
+     */
+    Cache_Counters counters() const;
+
+    /**
+     * Looks up the block holding an address on behalf of a cache hierarchy.
+     * A hit updates the replacement state and, for a store, marks the block
+     * dirty. The statistics counters are not touched.
+     * 
+     * @param address the memory address to look up
+     * @param is_store true if the access writes the block
+     * @param use the index of the block's latest access in the trace, which the
+     *        replacement policy is given in place of the timer (so OPT keys a
+     *        victim moved between levels by its own next use), or UINT64_MAX
+     *        for the current access
+     * @return true on a hit
+     */
+    bool probe(uint64_t address, bool is_store, uint64_t use = UINT64_MAX);
+
+    /**
+     * Fills the block holding an address (which must not be present) on behalf
+     * of a cache hierarchy, evicting the replacement policy's victim if the set
+     * is full. The statistics counters are not touched.
+     * 
+     * @param address the memory address whose block is filled
+     * @param dirty whether the filled block is dirty
+     * @param victim set to the evicted block, if any
+     * @param use the index of the block's latest access in the trace, which the
+     *        replacement policy is given in place of the timer (so OPT keys a
+     *        victim moved between levels by its own next use), or UINT64_MAX
+     *        for the current access
+     * @return true if a valid block was evicted
+     */
+    bool insert(uint64_t address, bool dirty, Cache_Block &victim, uint64_t use = UINT64_MAX);
+
+    /**
+     * Invalidates the block holding an address, if present.
+     * 
+     * @param address the memory address whose block is invalidated
+     * @param dirty set to whether the invalidated block was dirty
+     * @return true if the block was present
+     */
+    bool invalidate(uint64_t address, bool &dirty);
+
+private:
+    /**
+     * Performs one load or store with the given policy.
+     */
+    template <class Policy>
+    void access(Policy &policy, uint64_t address, bool is_store);
+
+    /**
+     * Lets the prefetcher observe a demand access and fills the blocks it names.
+     */
+    template <class Policy>
+    void prefetch(Policy &policy, uint64_t address, bool miss, bool prefetched_hit);
+
+    template <class Policy>
+    bool probe_block(Policy &policy, uint64_t address, bool is_store, uint64_t use);
+
+    template <class Policy>
+    bool insert_block(Policy &policy, uint64_t address, bool dirty, Cache_Block &victim, uint64_t use);
+
+    /**
+     * Finds the way of the given set that holds a valid block with the given tag.
+     *
+     * @return the way, or -1 on a miss
+     */
+    int find_way(uint64_t tag, uint32_t index) const;
+
+    /**
+     * Finds an invalid way of the given set.
+     *
+     * @return the way, or -1 if the set is full
+     */
+    int free_way(uint32_t index) const;
+
+    /**
+     * Invalidates a way, writing it back first if it is dirty.
+     */
+    void evict(uint32_t index, uint32_t way);
+
+    /**
+     * Fills the given tag into an invalid way, valid and not dirty.
+     */
+    void fill(uint64_t tag, uint32_t index, uint32_t way);
+
+    /**
+     * Writes a dirty block back to memory.
+     */
+    void write_back(uint64_t address);
+
+    /**
+     * @return the cycles of a store writing through to memory
+     */
+    uint64_t write_through_cycles(uint64_t address) {
+        return write_buffer ? 1 + write_buffer->write(address >> offset_bits, num_cycles) : 101;
+    }
+
+    bool test_bit(const std::vector<uint64_t> &bits, uint32_t index, uint32_t way) const {
+        return (bits[index * words_per_set + way / 64] >> (way % 64)) & 1;
+    }
+
+    void set_bit(std::vector<uint64_t> &bits, uint32_t index, uint32_t way, bool value) {
+        uint64_t &word = bits[index * words_per_set + way / 64];
+        uint64_t mask = uint64_t(1) << (way % 64);
+        word = value ? (word | mask) : (word & ~mask);
+    }
 };
 
 #endif //CACHE_SIMULATOR
\ No newline at end of file
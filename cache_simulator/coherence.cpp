@@ -0,0 +1,315 @@
+/*
+ * C++ implementation of multi-core cache coherence simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "coherence.h"
+
+/**
+ * Parses a coherence spec: mesi or moesi, optionally followed by :snoop
+ * (the default) or :directory, e.g. "moesi:directory".
+ *
+ * @return false if the spec is malformed, otherwise config is set
+ */
+bool parse_coherence_config(const std::string &spec, Coherence_Config &config, std::string &error) {
+    std::string protocol = spec, interconnect = "snoop";
+    size_t colon = spec.find(':');
+    if (colon != std::string::npos) {
+        protocol = spec.substr(0, colon);
+        interconnect = spec.substr(colon + 1);
+    }
+    if (protocol == "mesi") {
+        config.protocol = PROTOCOL_MESI;
+    } else if (protocol == "moesi") {
+        config.protocol = PROTOCOL_MOESI;
+    } else {
+        error = "invalid coherence protocol " + protocol + ".";
+        return false;
+    }
+    if (interconnect == "snoop") {
+        config.interconnect = INTERCONNECT_SNOOP;
+    } else if (interconnect == "directory") {
+        config.interconnect = INTERCONNECT_DIRECTORY;
+    } else {
+        error = "invalid coherence interconnect " + interconnect + ".";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @param cache_config the geometry and policy of every private cache
+ *        (write-allocate, write-back, not OPT)
+ * @param config the protocol and interconnect
+ */
+Coherence_Simulator::Coherence_Simulator(const Cache_Config &cache_config, const Coherence_Config &config)
+    : cache_config(cache_config), config(config), offset_bits(0), upgrades(0), invalidations(0), transfers(0),
+      memory_reads(0), memory_writes(0), bus_transactions(0), directory_messages(0), traffic_cycles(0),
+      num_cycles(0), too_many_cores(false) {
+    while ((1U << offset_bits) < cache_config.n_bytes_per_block) {
+        offset_bits++;
+    }
+    memory_cycles = 100 * uint64_t(cache_config.n_bytes_per_block / 4);
+}
+
+/**
+ * Checks that a cache configuration can be kept coherent.
+ *
+ * @return false if it is not, otherwise error is untouched
+ */
+bool Coherence_Simulator::validate(const Cache_Config &cache_config, std::string &error) {
+    if (!cache_config.is_write_allocate || cache_config.is_write_through) {
+        error = "coherence needs write-allocate write-back caches.";
+        return false;
+    }
+    if (cache_config.policy == POLICY_OPT) {
+        error = "coherence does not support opt.";
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Runs a batch of decoded trace records, each on the cache of its core.
+ *
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Coherence_Simulator::access_batch(const Trace_Record *records, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        unsigned core = records[i].core;
+        if (core >= MAX_CORES) {
+            too_many_cores = true;
+            continue;
+        }
+        while (cores.size() <= core) {
+            std::unique_ptr<Core> added(new Core());
+            added->cache.reset(new Cache_Simulator(cache_config.n_sets, cache_config.n_blocks_per_set,
+                                                   cache_config.n_bytes_per_block, true, false,
+                                                   cache_config.policy));
+            cores.push_back(std::move(added));
+        }
+        access(core, records[i].address, records[i].is_store);
+    }
+}
+
+/**
+ * Sends a coherence request (BusRd, BusRdX or BusUpgr) to the other cores.
+ */
+void Coherence_Simulator::request() {
+    if (config.interconnect == INTERCONNECT_SNOOP) {
+        bus_transactions++;
+        traffic_cycles += BUS_CYCLES;
+    } else {
+        directory_messages++;
+        traffic_cycles += DIRECTORY_CYCLES;
+    }
+}
+
+/**
+ * Moves a block from the cache of its owner to the requesting cache.
+ */
+void Coherence_Simulator::transfer() {
+    transfers++;
+    traffic_cycles += cache_config.n_bytes_per_block / 4;
+    if (config.interconnect == INTERCONNECT_DIRECTORY) {
+        // forwarded by the directory to the owner, which replies to the requester
+        directory_messages += 2;
+        traffic_cycles += 2 * HOP_CYCLES;
+    }
+}
+
+/**
+ * Invalidates every copy of a block but the writer's.
+ *
+ * @param word the bit of the written word, to tell false from true sharing
+ */
+void Coherence_Simulator::invalidate_sharers(uint64_t block, Line_State &line, unsigned writer, uint64_t word) {
+    uint64_t others = line.sharers & ~(uint64_t(1) << writer);
+    while (others != 0) {
+        unsigned core = __builtin_ctzll(others);
+        others &= others - 1;
+        bool dirty;
+        cores[core]->cache->invalidate(block << offset_bits, dirty);
+        cores[core]->invalidations++;
+        invalidations++;
+        Hot_Line &hot = hot_lines[block];
+        hot.invalidations++;
+        auto used = touched.find(block << 6 | core);
+        if (used == touched.end() || (used->second & word) == 0) {
+            hot.false_sharing++;
+        }
+        if (used != touched.end()) {
+            touched.erase(used);
+        }
+        if (config.interconnect == INTERCONNECT_DIRECTORY) {
+            // invalidation and acknowledgement
+            directory_messages += 2;
+            traffic_cycles += 2 * HOP_CYCLES;
+        }
+    }
+    line.sharers &= uint64_t(1) << writer;
+}
+
+/**
+ * Removes a core's copy of a block that its cache evicted, writing it back if
+ * the core owned it.
+ */
+void Coherence_Simulator::evict(unsigned core, uint64_t block) {
+    auto it = lines.find(block);
+    if (it == lines.end()) {
+        return;
+    }
+    Line_State &line = it->second;
+    line.sharers &= ~(uint64_t(1) << core);
+    if (line.owner == (int) core) {
+        line.owner = -1;
+        memory_writes++;
+        num_cycles += memory_cycles;
+        request(); // the writeback
+    }
+    if (line.sharers == 0) {
+        lines.erase(it);
+    }
+    touched.erase(block << 6 | core);
+}
+
+/**
+ * Performs one load or store of a core.
+ */
+void Coherence_Simulator::access(unsigned c, uint64_t address, bool is_store) {
+    Core &core = *cores[c];
+    const uint64_t block = address >> offset_bits;
+    const uint64_t core_bit = uint64_t(1) << c;
+    const uint64_t word = uint64_t(1) << (((address & (cache_config.n_bytes_per_block - 1)) >> 2) & 63);
+    (is_store ? core.stores : core.loads)++;
+
+    if (core.cache->probe(address, false)) {
+        Line_State &line = lines[block];
+        num_cycles++;
+        touched[block << 6 | c] |= word;
+        if (!is_store) {
+            core.load_hits++;
+            return;
+        }
+        core.store_hits++;
+        if (line.exclusive) {
+            line.owner = c; // E to M is silent
+            return;
+        }
+        // S or O: invalidate the other copies before writing
+        core.upgrades++;
+        upgrades++;
+        request();
+        invalidate_sharers(block, line, c, word);
+        line.owner = c;
+        line.exclusive = true;
+        return;
+    }
+
+    (is_store ? core.store_misses : core.load_misses)++;
+    Line_State &line = lines.insert(std::make_pair(block, Line_State{0, -1, false})).first->second;
+    request();
+    if (line.owner >= 0) {
+        transfer(); // the owner supplies the dirty block
+    } else {
+        memory_reads++;
+        num_cycles += memory_cycles;
+    }
+    if (is_store) {
+        // read for ownership: the dirty data (if any) moves with the ownership
+        invalidate_sharers(block, line, c, word);
+        line.owner = c;
+        line.exclusive = true;
+    } else {
+        if (line.owner >= 0 && config.protocol == PROTOCOL_MESI) {
+            // M becomes S: the owner writes the block back as it supplies it
+            line.owner = -1;
+            memory_writes++;
+            num_cycles += memory_cycles;
+        }
+        // M becomes O under MOESI, E becomes S; the reader gets E if alone
+        line.exclusive = line.sharers == 0;
+    }
+    line.sharers |= core_bit;
+    touched[block << 6 | c] = word;
+
+    Cache_Block victim;
+    if (core.cache->insert(address, false, victim)) {
+        evict(c, victim.address >> offset_bits);
+    }
+}
+
+/**
+ * Prints per-core counters, coherence traffic, total cycles and the
+ * blocks with the most false sharing.
+ */
+void Coherence_Simulator::print_stats() const {
+    std::cout << "Protocol: " << (config.protocol == PROTOCOL_MESI ? "MESI" : "MOESI")
+              << (config.interconnect == INTERCONNECT_SNOOP ? ", snooping bus" : ", directory") << "\n";
+    std::cout << "Cores: " << cores.size() << "\n";
+    uint64_t loads = 0, stores = 0, load_hits = 0, load_misses = 0, store_hits = 0, store_misses = 0;
+    for (size_t c = 0; c < cores.size(); c++) {
+        const Core &core = *cores[c];
+        std::cout << "core" << c << " loads: " << core.loads << "\n";
+        std::cout << "core" << c << " stores: " << core.stores << "\n";
+        std::cout << "core" << c << " load hits: " << core.load_hits << "\n";
+        std::cout << "core" << c << " load misses: " << core.load_misses << "\n";
+        std::cout << "core" << c << " store hits: " << core.store_hits << "\n";
+        std::cout << "core" << c << " store misses: " << core.store_misses << "\n";
+        std::cout << "core" << c << " upgrades: " << core.upgrades << "\n";
+        std::cout << "core" << c << " invalidations: " << core.invalidations << "\n";
+        loads += core.loads;
+        stores += core.stores;
+        load_hits += core.load_hits;
+        load_misses += core.load_misses;
+        store_hits += core.store_hits;
+        store_misses += core.store_misses;
+    }
+    std::cout << "Total loads: " << loads << "\n";
+    std::cout << "Total stores: " << stores << "\n";
+    std::cout << "Load hits: " << load_hits << "\n";
+    std::cout << "Load misses: " << load_misses << "\n";
+    std::cout << "Store hits: " << store_hits << "\n";
+    std::cout << "Store misses: " << store_misses << "\n";
+    std::cout << "Upgrades: " << upgrades << "\n";
+    std::cout << "Invalidations: " << invalidations << "\n";
+    std::cout << "Cache-to-cache transfers: " << transfers << "\n";
+    std::cout << "Memory reads: " << memory_reads << "\n";
+    std::cout << "Memory writes: " << memory_writes << "\n";
+    if (config.interconnect == INTERCONNECT_SNOOP) {
+        std::cout << "Bus transactions: " << bus_transactions << "\n";
+    } else {
+        std::cout << "Directory messages: " << directory_messages << "\n";
+    }
+    std::cout << "Coherence traffic cycles: " << traffic_cycles << "\n";
+    std::cout << "Total cycles: " << num_cycles + traffic_cycles << "\n";
+
+    // the ten blocks with the most false-sharing invalidations
+    std::vector<std::pair<uint64_t, Hot_Line>> hot;
+    for (const auto &entry : hot_lines) {
+        if (entry.second.false_sharing > 0) {
+            hot.push_back(entry);
+        }
+    }
+    std::sort(hot.begin(), hot.end(), [](const std::pair<uint64_t, Hot_Line> &a,
+                                         const std::pair<uint64_t, Hot_Line> &b) {
+        if (a.second.false_sharing != b.second.false_sharing) {
+            return a.second.false_sharing > b.second.false_sharing;
+        }
+        return a.first < b.first;
+    });
+    if (hot.size() > 10) {
+        hot.resize(10);
+    }
+    std::cout << "False sharing hot lines: " << hot.size() << "\n";
+    for (const auto &entry : hot) {
+        std::ostringstream address;
+        address << std::hex << (entry.first << offset_bits);
+        std::cout << "  0x" << address.str() << ": " << entry.second.invalidations << " invalidations, "
+                  << entry.second.false_sharing << " false sharing\n";
+    }
+}
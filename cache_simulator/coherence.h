@@ -0,0 +1,165 @@
+/*
+ * h file for multi-core cache coherence simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef COHERENCE_H
+#define COHERENCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "cache_config.h"
+#include "cache_simulator.h"
+#include "trace.h"
+
+/*
+ * Invalidation-based protocols. MOESI adds the Owned state: a core that
+ * holds a dirty block and is asked for it by a reader keeps the dirty copy
+ * and supplies it from its cache, instead of writing it back first as MESI
+ * does.
+ */
+enum Coherence_Protocol {
+    PROTOCOL_MESI,
+    PROTOCOL_MOESI
+};
+
+/*
+ * How coherence requests reach the other cores.
+ *
+ *   snoop      one broadcast bus transaction per request, snooped by every
+ *              other core
+ *   directory  a request to the directory, then point-to-point messages to
+ *              the owner and to every sharer that is invalidated (plus acks)
+ */
+enum Coherence_Interconnect {
+    INTERCONNECT_SNOOP,
+    INTERCONNECT_DIRECTORY
+};
+
+struct Coherence_Config {
+    Coherence_Protocol protocol;
+    Coherence_Interconnect interconnect;
+};
+
+/**
+ * Parses a coherence spec: mesi or moesi, optionally followed by :snoop
+ * (the default) or :directory, e.g. "moesi:directory".
+ *
+ * @return false if the spec is malformed, otherwise config is set
+ */
+bool parse_coherence_config(const std::string &spec, Coherence_Config &config, std::string &error);
+
+/*
+ * Private, write-back write-allocate L1s (one Cache_Simulator each, created
+ * as core ids appear in the trace, at most 64) kept coherent over memory.
+ * The caches only hold tags and replacement state; the coherence state of
+ * every cached block lives in one table: the cores holding a copy, the core
+ * holding the dirty copy (M or O) and whether the single holder may write
+ * without asking (E or M). Evictions are seen by the simulator, so the sharer
+ * sets are exact, and a clean eviction is silent.
+ *
+ * Costs: a hit is 1 cycle and a memory read or write 100 cycles per 4-byte
+ * word, as in Cache_Simulator. Coherence traffic is counted separately: a bus
+ * transaction costs BUS_CYCLES, a directory lookup DIRECTORY_CYCLES and a
+ * point-to-point message HOP_CYCLES; a cache-to-cache transfer adds one cycle
+ * per word.
+ *
+ * An invalidation is counted as false sharing when the invalidated core never
+ * accessed the word being written since it filled the block.
+ */
+class Coherence_Simulator {
+private:
+    static const unsigned MAX_CORES = 64;
+    static const unsigned BUS_CYCLES = 10;
+    static const unsigned DIRECTORY_CYCLES = 20;
+    static const unsigned HOP_CYCLES = 10;
+
+    struct Line_State {
+        uint64_t sharers; // bit c set if core c holds a copy
+        int owner;        // core holding the dirty (M or O) copy, or -1
+        bool exclusive;   // the only sharer holds it in E or M
+    };
+
+    struct Core {
+        std::unique_ptr<Cache_Simulator> cache;
+        uint64_t loads, stores, load_hits, load_misses, store_hits, store_misses;
+        uint64_t upgrades, invalidations; // invalidations received
+    };
+
+    struct Hot_Line {
+        uint64_t invalidations, false_sharing;
+    };
+
+    Cache_Config cache_config;
+    Coherence_Config config;
+    unsigned offset_bits;
+    uint64_t memory_cycles; // one block to or from memory
+    std::vector<std::unique_ptr<Core>> cores;
+    std::unordered_map<uint64_t, Line_State> lines;   // by block
+    std::unordered_map<uint64_t, uint64_t> touched;   // (block << 6 | core) -> words used since the fill
+    std::unordered_map<uint64_t, Hot_Line> hot_lines; // by block, blocks that saw invalidations
+    uint64_t upgrades, invalidations, transfers, memory_reads, memory_writes;
+    uint64_t bus_transactions, directory_messages, traffic_cycles, num_cycles;
+    bool too_many_cores;
+
+    void access(unsigned core, uint64_t address, bool is_store);
+    void request();
+    void transfer();
+    void invalidate_sharers(uint64_t block, Line_State &line, unsigned writer, uint64_t word);
+    void evict(unsigned core, uint64_t block);
+
+public:
+    /**
+     * @param cache_config the geometry and policy of every private cache
+     *        (write-allocate, write-back, not OPT)
+     * @param config the protocol and interconnect
+     */
+    Coherence_Simulator(const Cache_Config &cache_config, const Coherence_Config &config);
+
+    /**
+     * Checks that a cache configuration can be kept coherent.
+     *
+     * @return false if it is not, otherwise error is untouched
+     */
+    static bool validate(const Cache_Config &cache_config, std::string &error);
+
+    /**
+     * Runs a batch of decoded trace records, each on the cache of its core.
+     *
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Not supported (OPT is rejected); present so the simulator can be driven
+     * like a Cache_Simulator.
+     */
+    void set_next_use(const uint64_t *, uint64_t) { }
+
+    /**
+     * @return log2 of the block size
+     */
+    unsigned block_offset_bits() const { return offset_bits; }
+
+    /**
+     * @return true if the trace named a core beyond the 64 supported
+     */
+    bool failed() const { return too_many_cores; }
+
+    /**
+     * Prints per-core counters, coherence traffic, total cycles and the
+     * blocks with the most false sharing.
+     */
+    void print_stats() const;
+
+private:
+    Coherence_Simulator(const Coherence_Simulator &);
+    Coherence_Simulator &operator=(const Coherence_Simulator &);
+};
+
+#endif //COHERENCE_H
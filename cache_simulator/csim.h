@@ -0,0 +1,95 @@
+/*
+ * h file for the C interface of the cache simulator (libcsim)
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef CSIM_H
+#define CSIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(__GNUC__)
+#define CSIM_API __attribute__((visibility("default")))
+#else
+#define CSIM_API
+#endif
+
+/*
+ * Bumped whenever a function or struct below changes incompatibly; the
+ * library reports the version it was built with from csim_api_version().
+ */
+#define CSIM_API_VERSION 1
+
+/* Access kinds in the ops array of csim_access_batch() */
+#define CSIM_LOAD 0
+#define CSIM_STORE 1
+#define CSIM_FETCH 2 /* an instruction fetch, simulated as a load */
+
+/*
+ * A cache is not thread-safe: different caches may be used from different
+ * threads, but one csim_cache must not be used from two threads at once.
+ */
+typedef struct csim_cache csim_cache;
+
+/*
+ * A cache, as given on the csim command line.
+ */
+typedef struct csim_config {
+    uint32_t sets, blocks_per_set, bytes_per_block;
+    int write_allocate, write_through; /* 0 or 1 */
+    const char *policy;                /* lru, fifo, random, ... (not opt) */
+} csim_config;
+
+/*
+ * The counters of a cache, as in csim's summary.
+ */
+typedef struct csim_stats {
+    uint64_t loads, load_hits, load_misses;
+    uint64_t stores, store_hits, store_misses;
+    uint64_t cycles, dirty_evictions;
+} csim_stats;
+
+/**
+ * @return CSIM_API_VERSION of the library
+ */
+CSIM_API int csim_api_version(void);
+
+/**
+ * Creates a cache.
+ *
+ * @param config the configuration
+ * @param error if not NULL, set to a NUL-terminated message when the configuration is invalid
+ * @param error_size the size of error
+ * @return the cache, or NULL if the configuration is invalid
+ */
+CSIM_API csim_cache *csim_create(const csim_config *config, char *error, size_t error_size);
+
+/**
+ * Runs n accesses through the cache, in order.
+ *
+ * @param addresses the byte addresses
+ * @param ops CSIM_LOAD, CSIM_STORE or CSIM_FETCH for each access
+ * @param n the number of accesses
+ */
+CSIM_API void csim_access_batch(csim_cache *cache, const uint64_t *addresses, const uint8_t *ops, size_t n);
+
+/**
+ * Reads the counters of the cache so far.
+ */
+CSIM_API void csim_get_stats(const csim_cache *cache, csim_stats *stats);
+
+/**
+ * Destroys a cache. NULL is ignored.
+ */
+CSIM_API void csim_destroy(csim_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* CSIM_H */
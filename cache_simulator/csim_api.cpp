@@ -0,0 +1,131 @@
+/*
+ * C++ implementation of the C interface of the cache simulator (libcsim)
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstring>
+#include <new>
+#include <string>
+#include <vector>
+#include "cache_config.h"
+#include "cache_simulator.h"
+#include "csim.h"
+
+/*
+ * The handle behind csim_cache: C callers only ever see the pointer.
+ */
+struct csim_cache {
+    Cache_Simulator simulator;
+
+    csim_cache(const Cache_Config &config)
+        : simulator(config.n_sets, config.n_blocks_per_set, config.n_bytes_per_block, config.is_write_allocate,
+                    config.is_write_through, config.policy) { }
+};
+
+namespace {
+
+// records decoded per call of Cache_Simulator::access_batch()
+const size_t CHUNK_RECORDS = 1024;
+
+void set_error(char *error, size_t error_size, const std::string &message) {
+    if (error != nullptr && error_size > 0) {
+        std::strncpy(error, message.c_str(), error_size - 1);
+        error[error_size - 1] = '\0';
+    }
+}
+
+}
+
+/**
+ * @return CSIM_API_VERSION of the library
+ */
+int csim_api_version(void) {
+    return CSIM_API_VERSION;
+}
+
+/**
+ * Creates a cache. The configuration is checked exactly as csim checks its
+ * command line.
+ *
+ * @param config the configuration
+ * @param error if not NULL, set to a NUL-terminated message when the configuration is invalid
+ * @param error_size the size of error
+ * @return the cache, or NULL if the configuration is invalid
+ */
+csim_cache *csim_create(const csim_config *config, char *error, size_t error_size) {
+    // no exception may cross the C interface
+    try {
+        if (config == nullptr || config->policy == nullptr) {
+            set_error(error, error_size, "no configuration.");
+            return nullptr;
+        }
+        std::vector<std::string> args = {
+            std::to_string(config->sets), std::to_string(config->blocks_per_set),
+            std::to_string(config->bytes_per_block),
+            config->write_allocate ? "write-allocate" : "no-write-allocate",
+            config->write_through ? "write-through" : "write-back", config->policy
+        };
+        Cache_Config parsed;
+        std::string message;
+        if (!parse_cache_config(args, parsed, message)) {
+            set_error(error, error_size, message);
+            return nullptr;
+        }
+        if (parsed.policy == POLICY_OPT) {
+            // OPT needs the whole trace before the first access
+            set_error(error, error_size, "opt is not supported.");
+            return nullptr;
+        }
+        return new csim_cache(parsed);
+    } catch (const std::bad_alloc &) {
+        set_error(error, error_size, "out of memory.");
+        return nullptr;
+    }
+}
+
+/**
+ * Runs n accesses through the cache, in order.
+ *
+ * @param addresses the byte addresses
+ * @param ops CSIM_LOAD, CSIM_STORE or CSIM_FETCH for each access
+ * @param n the number of accesses
+ */
+void csim_access_batch(csim_cache *cache, const uint64_t *addresses, const uint8_t *ops, size_t n) {
+    Trace_Record chunk[CHUNK_RECORDS];
+    while (n > 0) {
+        size_t take = n < CHUNK_RECORDS ? n : CHUNK_RECORDS;
+        for (size_t i = 0; i < take; i++) {
+            chunk[i].address = addresses[i];
+            chunk[i].is_store = ops[i] == CSIM_STORE;
+            chunk[i].is_fetch = ops[i] == CSIM_FETCH;
+            chunk[i].core = 0;
+            chunk[i].pc = 0;
+        }
+        cache->simulator.access_batch(chunk, take);
+        addresses += take;
+        ops += take;
+        n -= take;
+    }
+}
+
+/**
+ * Reads the counters of the cache so far.
+ */
+void csim_get_stats(const csim_cache *cache, csim_stats *stats) {
+    Cache_Counters counters = cache->simulator.counters();
+    stats->loads = counters.loads;
+    stats->load_hits = counters.load_hits;
+    stats->load_misses = counters.load_misses;
+    stats->stores = counters.stores;
+    stats->store_hits = counters.store_hits;
+    stats->store_misses = counters.store_misses;
+    stats->cycles = counters.cycles;
+    stats->dirty_evictions = counters.writebacks;
+}
+
+/**
+ * Destroys a cache. NULL is ignored.
+ */
+void csim_destroy(csim_cache *cache) {
+    delete cache;
+}
@@ -0,0 +1,323 @@
+/*
+ * C++ implementation of compressed trace input
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+#include "decompress.h"
+
+#ifdef CSIM_HAVE_ZLIB
+#include <zlib.h>
+#endif
+#ifdef CSIM_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef CSIM_HAVE_LZ4
+#include <lz4frame.h>
+#endif
+
+namespace {
+
+const size_t CHUNK_BYTES = 1 << 17;
+
+/**
+ * Quotes a path for the shell.
+ */
+std::string shell_quote(const std::string &text) {
+    std::string quoted = "'";
+    for (char c : text) {
+        if (c == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += c;
+        }
+    }
+    return quoted + "'";
+}
+
+/**
+ * @return true if the decompressor for the format was compiled in
+ */
+bool has_library(Trace_Compression compression) {
+    switch (compression) {
+#ifdef CSIM_HAVE_ZLIB
+    case COMPRESSION_GZIP:
+        return true;
+#endif
+#ifdef CSIM_HAVE_ZSTD
+    case COMPRESSION_ZSTD:
+        return true;
+#endif
+#ifdef CSIM_HAVE_LZ4
+    case COMPRESSION_LZ4:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *tool_for(Trace_Compression compression) {
+    switch (compression) {
+    case COMPRESSION_GZIP:
+        return "gzip";
+    case COMPRESSION_ZSTD:
+        return "zstd";
+    case COMPRESSION_LZ4:
+        return "lz4";
+    default:
+        return "";
+    }
+}
+
+}
+
+/**
+ * Detects the compression of a file from its first bytes.
+ *
+ * @return COMPRESSION_NONE for an uncompressed (or unreadable) file
+ */
+Trace_Compression detect_compression(const std::string &path) {
+    unsigned char magic[4] = {0, 0, 0, 0};
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return COMPRESSION_NONE;
+    }
+    size_t n = fread(magic, 1, sizeof(magic), file);
+    fclose(file);
+    if (n >= 2 && magic[0] == 0x1f && magic[1] == 0x8b) {
+        return COMPRESSION_GZIP;
+    }
+    if (n == 4 && magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd) {
+        return COMPRESSION_ZSTD;
+    }
+    if (n == 4 && magic[0] == 0x04 && magic[1] == 0x22 && magic[2] == 0x4d && magic[3] == 0x18) {
+        return COMPRESSION_LZ4;
+    }
+    return COMPRESSION_NONE;
+}
+
+Decompressed_Input::Decompressed_Input()
+    : read_fd(-1), write_fd(-1), source_fd(-1), tool(nullptr), compression(COMPRESSION_NONE) {
+}
+
+Decompressed_Input::~Decompressed_Input() {
+    std::string error;
+    finish(error);
+}
+
+/**
+ * Opens a trace file, decompressing it if needed.
+ *
+ * @param path the trace file, or nullptr for (uncompressed) standard input
+ * @param error set if the file cannot be opened
+ * @return true on success
+ */
+bool Decompressed_Input::open(const char *path, std::string &error) {
+    if (path == nullptr) {
+        read_fd = 0;
+        return true;
+    }
+    compression = detect_compression(path);
+    if (compression != COMPRESSION_NONE && !has_library(compression)) {
+        // fall back to the command line tool, which runs as its own process
+        tool_name = tool_for(compression);
+        std::string command = tool_name + " -dc -- " + shell_quote(path);
+        tool = popen(command.c_str(), "r");
+        if (tool == nullptr) {
+            error = "unable to run " + tool_name + " to decompress " + path;
+            return false;
+        }
+        read_fd = fileno(tool);
+        return true;
+    }
+    source_fd = ::open(path, O_RDONLY);
+    if (source_fd < 0) {
+        error = std::string("unable to open trace file ") + path;
+        return false;
+    }
+    if (compression == COMPRESSION_NONE) {
+        read_fd = source_fd;
+        source_fd = -1;
+        return true;
+    }
+    int fds[2];
+    if (pipe(fds) != 0) {
+        error = std::string("unable to create a pipe: ") + strerror(errno);
+        return false;
+    }
+    read_fd = fds[0];
+    write_fd = fds[1];
+    worker = std::thread(&Decompressed_Input::run_worker, this);
+    return true;
+}
+
+/**
+ * Writes decompressed data into the pipe.
+ *
+ * @return false if the reading side went away
+ */
+bool Decompressed_Input::write_all(const char *data, size_t n) {
+    while (n > 0) {
+        ssize_t written = write(write_fd, data, n);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data += written;
+        n -= written;
+    }
+    return true;
+}
+
+/**
+ * Decompresses the source file into the pipe, then closes the write end so
+ * the reader sees EOF.
+ */
+void Decompressed_Input::run_worker() {
+    // a reader that stops early makes write() fail with EPIPE instead of
+    // killing the process
+    sigset_t pipe_signal;
+    sigemptyset(&pipe_signal);
+    sigaddset(&pipe_signal, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipe_signal, nullptr);
+
+    std::vector<char> in(CHUNK_BYTES), out(CHUNK_BYTES);
+    bool complete = false;
+    switch (compression) {
+#ifdef CSIM_HAVE_ZLIB
+    case COMPRESSION_GZIP: {
+        gzFile gz = gzdopen(source_fd, "rb");
+        source_fd = -1; // owned by gz now
+        if (gz == nullptr) {
+            worker_error = "unable to start gzip decompression";
+            break;
+        }
+        gzbuffer(gz, CHUNK_BYTES);
+        int n;
+        bool ok = true;
+        while (ok && (n = gzread(gz, out.data(), out.size())) > 0) {
+            ok = write_all(out.data(), n);
+        }
+        // a truncated file ends the reads early without a negative count
+        int code;
+        const char *message = gzerror(gz, &code);
+        if (ok && (n < 0 || code != Z_OK)) {
+            worker_error = std::string("gzip: ") + message;
+        }
+        complete = ok && n == 0 && code == Z_OK;
+        gzclose(gz);
+        break;
+    }
+#endif
+#ifdef CSIM_HAVE_ZSTD
+    case COMPRESSION_ZSTD: {
+        ZSTD_DCtx *context = ZSTD_createDCtx();
+        size_t pending = 0; // nonzero while a frame is incomplete
+        bool ok = context != nullptr;
+        ssize_t n;
+        while (ok && (n = read(source_fd, in.data(), in.size())) > 0) {
+            ZSTD_inBuffer input = {in.data(), (size_t) n, 0};
+            while (ok && input.pos < input.size) {
+                ZSTD_outBuffer output = {out.data(), out.size(), 0};
+                pending = ZSTD_decompressStream(context, &output, &input);
+                if (ZSTD_isError(pending)) {
+                    worker_error = std::string("zstd: ") + ZSTD_getErrorName(pending);
+                    ok = false;
+                } else {
+                    ok = write_all(out.data(), output.pos);
+                }
+            }
+        }
+        if (ok && pending != 0) {
+            worker_error = "zstd: truncated input";
+        }
+        complete = ok && pending == 0 && n == 0;
+        ZSTD_freeDCtx(context);
+        break;
+    }
+#endif
+#ifdef CSIM_HAVE_LZ4
+    case COMPRESSION_LZ4: {
+        LZ4F_dctx *context;
+        bool ok = !LZ4F_isError(LZ4F_createDecompressionContext(&context, LZ4F_VERSION));
+        size_t hint = 1; // 0 once a frame is complete
+        ssize_t n;
+        while (ok && (n = read(source_fd, in.data(), in.size())) > 0) {
+            const char *src = in.data();
+            size_t left = n;
+            while (ok && left > 0) {
+                size_t src_size = left, dst_size = out.size();
+                hint = LZ4F_decompress(context, out.data(), &dst_size, src, &src_size, nullptr);
+                if (LZ4F_isError(hint)) {
+                    worker_error = std::string("lz4: ") + LZ4F_getErrorName(hint);
+                    ok = false;
+                } else {
+                    ok = write_all(out.data(), dst_size);
+                    src += src_size;
+                    left -= src_size;
+                }
+            }
+        }
+        if (ok && hint != 0) {
+            worker_error = "lz4: truncated input";
+        }
+        complete = ok && hint == 0 && n == 0;
+        LZ4F_freeDecompressionContext(context);
+        break;
+    }
+#endif
+    default:
+        break;
+    }
+    if (!complete && worker_error.empty()) {
+        worker_error = "decompression stopped early";
+    }
+    if (source_fd >= 0) {
+        close(source_fd);
+        source_fd = -1;
+    }
+    close(write_fd);
+    write_fd = -1;
+}
+
+/**
+ * Closes the input and waits for the decompressor.
+ *
+ * @param error set if decompression failed
+ * @return true if the whole file was decompressed
+ */
+bool Decompressed_Input::finish(std::string &error) {
+    bool ok = true;
+    if (tool != nullptr) {
+        int status = pclose(tool);
+        tool = nullptr;
+        read_fd = -1;
+        if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            error = tool_name + " could not decompress the trace (is it installed?)";
+            ok = false;
+        }
+        return ok;
+    }
+    if (read_fd > 0) {
+        close(read_fd);
+    }
+    read_fd = -1;
+    if (worker.joinable()) {
+        worker.join();
+        if (!worker_error.empty()) {
+            error = worker_error;
+            ok = false;
+        }
+    }
+    return ok;
+}
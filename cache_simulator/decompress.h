@@ -0,0 +1,85 @@
+/*
+ * h file for compressed trace input
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <cstdio>
+#include <string>
+#include <thread>
+
+/*
+ * Compression formats recognized by their magic bytes.
+ */
+enum Trace_Compression {
+    COMPRESSION_NONE,
+    COMPRESSION_GZIP,
+    COMPRESSION_ZSTD,
+    COMPRESSION_LZ4
+};
+
+/**
+ * Detects the compression of a file from its first bytes.
+ *
+ * @return COMPRESSION_NONE for an uncompressed (or unreadable) file
+ */
+Trace_Compression detect_compression(const std::string &path);
+
+/*
+ * An input file descriptor that yields the decompressed contents of a trace
+ * file, so the text parser reads gzip, zstd and LZ4 traces without a copy on
+ * disk. The file is decompressed on a background thread into a pipe whose
+ * read end is handed out, which keeps decompression, parsing and simulation
+ * on separate cores.
+ *
+ * zlib, libzstd and liblz4 are used when the build found them (CSIM_HAVE_ZLIB,
+ * CSIM_HAVE_ZSTD, CSIM_HAVE_LZ4); otherwise the format's command line tool
+ * (gzip, zstd or lz4 -dc) runs as a child process instead. Uncompressed files
+ * are opened directly.
+ */
+class Decompressed_Input {
+private:
+    int read_fd, write_fd, source_fd;
+    FILE *tool;                 // the command line decompressor, if used
+    Trace_Compression compression;
+    std::string tool_name;
+    std::thread worker;
+    std::string worker_error;   // set by the worker before it closes the pipe
+
+    void run_worker();
+    bool write_all(const char *data, size_t n);
+
+public:
+    Decompressed_Input();
+    ~Decompressed_Input();
+
+    /**
+     * Opens a trace file, decompressing it if needed.
+     *
+     * @param path the trace file, or nullptr for (uncompressed) standard input
+     * @param error set if the file cannot be opened
+     * @return true on success
+     */
+    bool open(const char *path, std::string &error);
+
+    /**
+     * @return the file descriptor to read the decompressed trace from
+     */
+    int fd() const { return read_fd; }
+
+    /**
+     * Closes the input and waits for the decompressor.
+     *
+     * @param error set if decompression failed
+     * @return true if the whole file was decompressed
+     */
+    bool finish(std::string &error);
+
+private:
+    Decompressed_Input(const Decompressed_Input &);
+    Decompressed_Input &operator=(const Decompressed_Input &);
+};
+
+#endif //DECOMPRESS_H
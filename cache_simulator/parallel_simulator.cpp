@@ -0,0 +1,120 @@
+/*
+ * C++ implementation of set-partitioned parallel cache simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include "parallel_simulator.h"
+
+namespace {
+
+// records a worker gathers before its bucket is handed over
+const size_t BATCH_RECORDS = 16384;
+
+}
+
+/**
+ * Starts the worker threads.
+ *
+ * @param threads the number of worker threads (at most the number of sets)
+ * @param n_sets the number of sets in the cache
+ * @param n_blocks_per_set the number of blocks/slots per set in the cache
+ * @param n_bytes_per_block the number of bytes per block in the cache
+ * @param is_write_allocate a flag indicating whether write allocate is enabled
+ * @param is_write_through a flag indicating whether write through is enabled
+ * @param policy the replacement policy, not POLICY_OPT
+ */
+Parallel_Simulator::Parallel_Simulator(unsigned threads, unsigned n_sets, unsigned n_blocks_per_set,
+                                       unsigned n_bytes_per_block, bool is_write_allocate, bool is_write_through,
+                                       Replacement_Policy policy)
+    : index_bits(0), finished(false) {
+    while ((1U << index_bits) < n_sets) {
+        index_bits++;
+    }
+    if (threads > n_sets) {
+        threads = n_sets;
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    for (unsigned t = 0; t < threads; t++) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->cache.reset(new Cache_Simulator(n_sets, n_blocks_per_set, n_bytes_per_block,
+                                                is_write_allocate, is_write_through, policy));
+        worker->bucket.reserve(BATCH_RECORDS);
+        workers.push_back(std::move(worker));
+    }
+    for (auto &worker : workers) {
+        worker->thread = std::thread(run_worker, worker.get());
+    }
+}
+
+Parallel_Simulator::~Parallel_Simulator() {
+    finish();
+}
+
+/**
+ * Runs queued batches until the empty batch that marks the end.
+ */
+void Parallel_Simulator::run_worker(Worker *worker) {
+    while (true) {
+        std::vector<Trace_Record> batch = worker->batches.pop();
+        if (batch.empty()) {
+            return;
+        }
+        worker->cache->access_batch(batch.data(), batch.size());
+    }
+}
+
+/**
+ * Buckets a batch of decoded trace records by owning thread and queues
+ * them. Blocks while the workers are behind.
+ */
+void Parallel_Simulator::access_batch(const Trace_Record *records, size_t n) {
+    const Cache_Simulator &geometry = *workers[0]->cache;
+    const uint64_t num_workers = workers.size();
+    for (size_t i = 0; i < n; i++) {
+        // thread t owns sets [t * sets / threads, (t + 1) * sets / threads)
+        uint64_t owner = (geometry.get_index(records[i].address) * num_workers) >> index_bits;
+        Worker &worker = *workers[owner];
+        worker.bucket.push_back(records[i]);
+        if (worker.bucket.size() == BATCH_RECORDS) {
+            worker.batches.push(std::move(worker.bucket));
+            worker.bucket = std::vector<Trace_Record>();
+            worker.bucket.reserve(BATCH_RECORDS);
+        }
+    }
+}
+
+/**
+ * Hands every partially filled bucket over.
+ */
+void Parallel_Simulator::flush() {
+    for (auto &worker : workers) {
+        if (!worker->bucket.empty()) {
+            worker->batches.push(std::move(worker->bucket));
+            worker->bucket = std::vector<Trace_Record>();
+        }
+    }
+}
+
+/**
+ * Waits for the workers to drain their queues and merges their counters.
+ *
+ * @return a simulator holding the counters of the whole run
+ */
+const Cache_Simulator &Parallel_Simulator::finish() {
+    if (!finished) {
+        flush();
+        for (auto &worker : workers) {
+            worker->batches.push(std::vector<Trace_Record>());
+        }
+        for (auto &worker : workers) {
+            worker->thread.join();
+        }
+        for (size_t t = 1; t < workers.size(); t++) {
+            workers[0]->cache->merge_stats(*workers[t]->cache);
+        }
+        finished = true;
+    }
+    return *workers[0]->cache;
+}
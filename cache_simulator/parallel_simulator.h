@@ -0,0 +1,95 @@
+/*
+ * h file for set-partitioned parallel cache simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef PARALLEL_SIMULATOR_H
+#define PARALLEL_SIMULATOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "cache_simulator.h"
+#include "replacement_policy.h"
+#include "trace.h"
+
+/*
+ * Accesses to different sets never interact, so the sets are split into
+ * contiguous ranges, one per worker thread. The caller's thread buckets each
+ * chunk of the trace by owner and hands the buckets over through bounded
+ * queues; every worker runs its records, in trace order, through a private
+ * Cache_Simulator of the full geometry (only its own sets are ever touched,
+ * so per-set replacement state evolves exactly as in a serial run). The
+ * counters are merged at the end, so the results are identical to the serial
+ * simulation.
+ *
+ * OPT is not supported: its next-use index is numbered by global trace
+ * position.
+ */
+class Parallel_Simulator {
+private:
+    struct Worker {
+        std::unique_ptr<Cache_Simulator> cache;
+        Bounded_Queue<std::vector<Trace_Record>> batches;
+        std::vector<Trace_Record> bucket; // records gathered for the next batch
+        std::thread thread;
+
+        Worker() : batches(4) { }
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    unsigned index_bits;
+    bool finished;
+
+    static void run_worker(Worker *worker);
+    void flush();
+
+public:
+    /**
+     * Starts the worker threads.
+     *
+     * @param threads the number of worker threads (at most the number of sets)
+     * @param n_sets the number of sets in the cache
+     * @param n_blocks_per_set the number of blocks/slots per set in the cache
+     * @param n_bytes_per_block the number of bytes per block in the cache
+     * @param is_write_allocate a flag indicating whether write allocate is enabled
+     * @param is_write_through a flag indicating whether write through is enabled
+     * @param policy the replacement policy, not POLICY_OPT
+     */
+    Parallel_Simulator(unsigned threads, unsigned n_sets, unsigned n_blocks_per_set, unsigned n_bytes_per_block,
+                       bool is_write_allocate, bool is_write_through, Replacement_Policy policy);
+    ~Parallel_Simulator();
+
+    /**
+     * Buckets a batch of decoded trace records by owning thread and queues
+     * them. Blocks while the workers are behind.
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Not supported (see above); present so the simulator can be driven like
+     * a Cache_Simulator.
+     */
+    void set_next_use(const uint64_t *, uint64_t) { }
+
+    /**
+     * @return log2 of the block size
+     */
+    unsigned block_offset_bits() const { return workers[0]->cache->block_offset_bits(); }
+
+    /**
+     * Waits for the workers to drain their queues and merges their counters.
+     *
+     * @return a simulator holding the counters of the whole run
+     */
+    const Cache_Simulator &finish();
+
+private:
+    Parallel_Simulator(const Parallel_Simulator &);
+    Parallel_Simulator &operator=(const Parallel_Simulator &);
+};
+
+#endif //PARALLEL_SIMULATOR_H
@@ -0,0 +1,186 @@
+/*
+ * C++ implementation of hardware prefetcher models
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstdlib>
+#include <sstream>
+#include "prefetcher.h"
+
+/**
+ * Parses a prefetcher spec: none, next-line[:degree], stride[:degree[:entries]]
+ * or stream[:depth[:streams]].
+ *
+ * @param spec the spec
+ * @param config set to the prefetcher
+ * @param error set to the message (without "Error: ") if the spec is invalid
+ * @return true if the spec is valid
+ */
+bool parse_prefetcher_config(const std::string &spec, Prefetcher_Config &config, std::string &error) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    error = "invalid prefetcher " + spec + ".";
+    if (fields.empty() || fields.size() > 3) {
+        return false;
+    }
+    if (fields[0] == "none" && fields.size() == 1) {
+        config.kind = PREFETCH_NONE;
+        config.degree = config.entries = 0;
+        return true;
+    } else if (fields[0] == "next-line" && fields.size() <= 2) {
+        config.kind = PREFETCH_NEXT_LINE;
+        config.degree = 1;
+        config.entries = 0;
+    } else if (fields[0] == "stride") {
+        config.kind = PREFETCH_STRIDE;
+        config.degree = 2;
+        config.entries = 16;
+    } else if (fields[0] == "stream") {
+        config.kind = PREFETCH_STREAM;
+        config.degree = 4;
+        config.entries = 4;
+    } else {
+        return false;
+    }
+    for (size_t i = 1; i < fields.size(); i++) {
+        char *end;
+        unsigned long value = std::strtoul(fields[i].c_str(), &end, 10);
+        if (fields[i].empty() || *end != '\0' || value == 0 || value > 1024) {
+            return false;
+        }
+        (i == 1 ? config.degree : config.entries) = value;
+    }
+    return true;
+}
+
+/**
+ * Creates the prefetcher of a configuration.
+ *
+ * @return the prefetcher, or nullptr for PREFETCH_NONE
+ */
+std::unique_ptr<Prefetcher> Prefetcher::create(const Prefetcher_Config &config, unsigned offset_bits) {
+    switch (config.kind) {
+    case PREFETCH_NEXT_LINE:
+        return std::unique_ptr<Prefetcher>(new Next_Line_Prefetcher(offset_bits, config.degree));
+    case PREFETCH_STRIDE:
+        return std::unique_ptr<Prefetcher>(new Stride_Prefetcher(offset_bits, config.degree, config.entries));
+    case PREFETCH_STREAM:
+        return std::unique_ptr<Prefetcher>(new Stream_Prefetcher(offset_bits, config.degree, config.entries));
+    default:
+        return nullptr;
+    }
+}
+
+/**
+ * Appends block + delta to the prefetches unless it leaves the address space.
+ */
+void Prefetcher::push(uint64_t block, int64_t delta, std::vector<uint64_t> &prefetches) const {
+    if (delta > 0 ? (uint64_t) delta > max_block - block : (uint64_t) -delta > block) {
+        return;
+    }
+    prefetches.push_back(block + delta);
+}
+
+void Next_Line_Prefetcher::observe(uint64_t block, bool miss, bool prefetched_hit,
+                                   std::vector<uint64_t> &prefetches) {
+    if (!miss && !prefetched_hit) {
+        return;
+    }
+    for (unsigned i = 1; i <= degree; i++) {
+        push(block, i, prefetches);
+    }
+}
+
+Stride_Prefetcher::Stride_Prefetcher(unsigned offset_bits, unsigned degree, unsigned entries)
+    : Prefetcher(offset_bits), degree(degree), table(entries), now(0) {
+    page_shift = offset_bits < 12 ? 12 - offset_bits : 0;
+    for (Entry &entry : table) {
+        entry.valid = false;
+    }
+}
+
+void Stride_Prefetcher::observe(uint64_t block, bool miss, bool prefetched_hit,
+                                std::vector<uint64_t> &prefetches) {
+    (void) miss;
+    (void) prefetched_hit;
+    now++;
+    uint64_t page = block >> page_shift;
+    Entry *entry = nullptr;
+    Entry *oldest = &table[0];
+    for (Entry &e : table) {
+        if (e.valid && e.page == page) {
+            entry = &e;
+            break;
+        }
+        if (!e.valid || (oldest->valid && e.last_use < oldest->last_use)) {
+            oldest = &e;
+        }
+    }
+    if (entry == nullptr) {
+        // first access to the page: no stride yet
+        oldest->valid = true;
+        oldest->page = page;
+        oldest->last_block = block;
+        oldest->last_use = now;
+        oldest->stride = 0;
+        oldest->confirmed = false;
+        return;
+    }
+    entry->last_use = now;
+    int64_t stride = (int64_t) (block - entry->last_block);
+    if (stride == 0) {
+        return; // another access to the same block
+    }
+    entry->confirmed = stride == entry->stride;
+    entry->stride = stride;
+    entry->last_block = block;
+    if (entry->confirmed) {
+        for (unsigned i = 1; i <= degree; i++) {
+            push(block, stride * (int64_t) i, prefetches);
+        }
+    }
+}
+
+Stream_Prefetcher::Stream_Prefetcher(unsigned offset_bits, unsigned depth, unsigned num_streams)
+    : Prefetcher(offset_bits), depth(depth), streams(num_streams), now(0) {
+    for (Stream &stream : streams) {
+        stream.valid = false;
+    }
+}
+
+void Stream_Prefetcher::observe(uint64_t block, bool miss, bool prefetched_hit,
+                                std::vector<uint64_t> &prefetches) {
+    (void) prefetched_hit;
+    now++;
+    Stream *oldest = &streams[0];
+    for (Stream &stream : streams) {
+        if (stream.valid && block >= stream.next && block <= stream.end) {
+            // the demand stream caught up: top the window up to depth blocks ahead
+            stream.last_use = now;
+            stream.next = block + 1;
+            while (stream.end - block < depth && stream.end < max_block) {
+                stream.end++;
+                prefetches.push_back(stream.end);
+            }
+            return;
+        }
+        if (!stream.valid || (oldest->valid && stream.last_use < oldest->last_use)) {
+            oldest = &stream;
+        }
+    }
+    if (!miss || block == max_block) {
+        return;
+    }
+    oldest->valid = true;
+    oldest->last_use = now;
+    oldest->next = block + 1;
+    oldest->end = block;
+    while (oldest->end - block < depth && oldest->end < max_block) {
+        oldest->end++;
+        prefetches.push_back(oldest->end);
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * h file for hardware prefetcher models
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef PREFETCHER_H
+#define PREFETCHER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/*
+ * Prefetchers watch the demand accesses of a cache (as block numbers, i.e.
+ * address >> log2(block size)) and name blocks to fetch ahead of use. The
+ * cache fills them like a miss, but off the critical path: a prefetch fill
+ * costs no cycles of its own (a dirty block it evicts is still written back).
+ */
+enum Prefetcher_Kind {
+    PREFETCH_NONE,
+    PREFETCH_NEXT_LINE, // next N blocks on a miss or the first use of a prefetched block
+    PREFETCH_STRIDE,    // per-page stride table, no program counter needed
+    PREFETCH_STREAM     // ascending stream trackers running a fixed depth ahead
+};
+
+/*
+ * A prefetcher and its sizing, as given by --prefetch.
+ */
+struct Prefetcher_Config {
+    Prefetcher_Kind kind;
+    unsigned degree;  // blocks per prefetch (next-line, stride) or stream depth
+    unsigned entries; // stride table entries or number of streams
+};
+
+/**
+ * Parses a prefetcher spec: none, next-line[:degree], stride[:degree[:entries]]
+ * or stream[:depth[:streams]].
+ *
+ * @param spec the spec
+ * @param config set to the prefetcher
+ * @param error set to the message (without "Error: ") if the spec is invalid
+ * @return true if the spec is valid
+ */
+bool parse_prefetcher_config(const std::string &spec, Prefetcher_Config &config, std::string &error);
+
+class Prefetcher {
+protected:
+    uint64_t max_block; // the last block of the address space
+
+    /**
+     * Appends block + delta to the prefetches unless it leaves the address space.
+     */
+    void push(uint64_t block, int64_t delta, std::vector<uint64_t> &prefetches) const;
+
+public:
+    /**
+     * @param offset_bits log2 of the block size
+     */
+    Prefetcher(unsigned offset_bits) : max_block(~uint64_t(0) >> offset_bits) { }
+    virtual ~Prefetcher() { }
+
+    /**
+     * Observes one demand access.
+     *
+     * @param block the block accessed
+     * @param miss true if the access missed
+     * @param prefetched_hit true if the access is the first use of a prefetched block
+     * @param prefetches the blocks to prefetch are appended here
+     */
+    virtual void observe(uint64_t block, bool miss, bool prefetched_hit, std::vector<uint64_t> &prefetches) = 0;
+
+    /**
+     * Creates the prefetcher of a configuration.
+     *
+     * @return the prefetcher, or nullptr for PREFETCH_NONE
+     */
+    static std::unique_ptr<Prefetcher> create(const Prefetcher_Config &config, unsigned offset_bits);
+};
+
+/*
+ * Tagged next-N-line prefetching: a miss, or the first hit on a prefetched
+ * block, fetches the next degree blocks.
+ */
+class Next_Line_Prefetcher : public Prefetcher {
+private:
+    unsigned degree;
+
+public:
+    Next_Line_Prefetcher(unsigned offset_bits, unsigned degree) : Prefetcher(offset_bits), degree(degree) { }
+    void observe(uint64_t block, bool miss, bool prefetched_hit, std::vector<uint64_t> &prefetches);
+};
+
+/*
+ * Without program counters, strides are learned per 4 KiB page: each table
+ * entry remembers the last block accessed in its page and the last stride.
+ * Once the same nonzero stride is seen twice in a row, every access in the
+ * page prefetches degree strides ahead. Entries are replaced LRU.
+ */
+class Stride_Prefetcher : public Prefetcher {
+private:
+    struct Entry {
+        uint64_t page, last_block, last_use;
+        int64_t stride;
+        bool confirmed, valid;
+    };
+
+    unsigned degree, page_shift;
+    std::vector<Entry> table;
+    uint64_t now;
+
+public:
+    Stride_Prefetcher(unsigned offset_bits, unsigned degree, unsigned entries);
+    void observe(uint64_t block, bool miss, bool prefetched_hit, std::vector<uint64_t> &prefetches);
+};
+
+/*
+ * Stream buffers in the style of Jouppi, filling the cache instead of a side
+ * buffer: a miss outside every stream starts a new one (replacing the least
+ * recently used) that prefetches the next depth blocks. An access inside a
+ * stream's prefetched window advances it, so it keeps running depth blocks
+ * ahead of the demand accesses.
+ */
+class Stream_Prefetcher : public Prefetcher {
+private:
+    struct Stream {
+        uint64_t next, end, last_use; // window [next, end] has been prefetched
+        bool valid;
+    };
+
+    unsigned depth;
+    std::vector<Stream> streams;
+    uint64_t now;
+
+public:
+    Stream_Prefetcher(unsigned offset_bits, unsigned depth, unsigned num_streams);
+    void observe(uint64_t block, bool miss, bool prefetched_hit, std::vector<uint64_t> &prefetches);
+};
+
+#endif //PREFETCHER_H
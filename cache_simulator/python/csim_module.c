@@ -0,0 +1,201 @@
+/*
+ * C implementation of the Python extension over libcsim
+ * Jiwon Moon, Hajin Jang
+ *
+ *   import csim
+ *   cache = csim.Cache(256, 4, 16, write_allocate=True, write_through=False, policy="lru")
+ *   cache.access(addresses, ops)   # buffers of uint64 addresses and uint8 ops
+ *   cache.stats()                  # dict of counters
+ *
+ * Any object with the buffer protocol works for access(), e.g.
+ * array.array("Q") and array.array("B") or numpy uint64 and uint8 arrays, so
+ * a whole trace crosses into the simulator in one call without copies.
+ *
+ * access() runs without the GIL. Each Cache has a lock, held around every
+ * use of its csim_cache, so threads sharing a Cache take turns (see csim.h).
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <string.h>
+#include "csim.h"
+
+typedef struct {
+    PyObject_HEAD
+    csim_cache *cache;
+    PyThread_type_lock lock; /* guards cache */
+} Cache_Object;
+
+/* Takes the lock of a cache, letting other threads run while it waits. */
+static void lock_cache(Cache_Object *self) {
+    if (!PyThread_acquire_lock(self->lock, NOWAIT_LOCK)) {
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static PyObject *Cache_new(PyTypeObject *type, PyObject *args, PyObject *kwargs) {
+    Cache_Object *self = (Cache_Object *) type->tp_alloc(type, 0);
+    (void) args;
+    (void) kwargs;
+    if (self == NULL) {
+        return NULL;
+    }
+    self->lock = PyThread_allocate_lock();
+    if (self->lock == NULL) {
+        Py_DECREF(self);
+        return PyErr_NoMemory();
+    }
+    return (PyObject *) self;
+}
+
+static int Cache_init(Cache_Object *self, PyObject *args, PyObject *kwargs) {
+    static char *keywords[] = {"sets", "blocks_per_set", "bytes_per_block", "write_allocate", "write_through",
+                               "policy", NULL};
+    unsigned int sets, blocks_per_set, bytes_per_block;
+    int write_allocate = 1, write_through = 0;
+    const char *policy = "lru";
+    char error[256];
+    csim_config config;
+    if (!PyArg_ParseTupleAndKeywords(args, kwargs, "III|pps", keywords, &sets, &blocks_per_set, &bytes_per_block,
+                                     &write_allocate, &write_through, &policy)) {
+        return -1;
+    }
+    config.sets = sets;
+    config.blocks_per_set = blocks_per_set;
+    config.bytes_per_block = bytes_per_block;
+    config.write_allocate = write_allocate;
+    config.write_through = write_through;
+    config.policy = policy;
+    lock_cache(self);
+    csim_destroy(self->cache);
+    self->cache = csim_create(&config, error, sizeof(error));
+    PyThread_release_lock(self->lock);
+    if (self->cache == NULL) {
+        PyErr_SetString(PyExc_ValueError, error);
+        return -1;
+    }
+    return 0;
+}
+
+static void Cache_dealloc(Cache_Object *self) {
+    csim_destroy(self->cache);
+    if (self->lock != NULL) {
+        PyThread_free_lock(self->lock);
+    }
+    Py_TYPE(self)->tp_free((PyObject *) self);
+}
+
+static PyObject *Cache_access(Cache_Object *self, PyObject *args) {
+    PyObject *address_object, *op_object;
+    Py_buffer addresses, ops;
+    int initialized = 1;
+    if (!PyArg_ParseTuple(args, "OO", &address_object, &op_object)) {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(address_object, &addresses, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        return NULL;
+    }
+    if (PyObject_GetBuffer(op_object, &ops, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) < 0) {
+        PyBuffer_Release(&addresses);
+        return NULL;
+    }
+    if (addresses.itemsize != 8 || ops.itemsize != 1 || strchr("QLqlKk", addresses.format[0]) == NULL
+        || strchr("Bbc", ops.format[0]) == NULL) {
+        PyErr_SetString(PyExc_TypeError, "addresses must be 64-bit unsigned integers and ops 8-bit integers");
+    } else if (addresses.len / 8 != ops.len) {
+        PyErr_SetString(PyExc_ValueError, "addresses and ops differ in length");
+    } else {
+        size_t n = (size_t) ops.len;
+        /* the buffers stay exported and the cache locked, so other threads
+           may run meanwhile */
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(self->lock, WAIT_LOCK);
+        if (self->cache != NULL) {
+            csim_access_batch(self->cache, (const uint64_t *) addresses.buf, (const uint8_t *) ops.buf, n);
+        } else {
+            initialized = 0;
+        }
+        PyThread_release_lock(self->lock);
+        Py_END_ALLOW_THREADS
+        if (!initialized) {
+            PyErr_SetString(PyExc_RuntimeError, "cache is not initialized");
+        }
+    }
+    PyBuffer_Release(&addresses);
+    PyBuffer_Release(&ops);
+    if (PyErr_Occurred()) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+static PyObject *Cache_stats(Cache_Object *self, PyObject *unused) {
+    csim_stats stats;
+    int initialized;
+    (void) unused;
+    lock_cache(self);
+    initialized = self->cache != NULL;
+    if (initialized) {
+        csim_get_stats(self->cache, &stats);
+    }
+    PyThread_release_lock(self->lock);
+    if (!initialized) {
+        PyErr_SetString(PyExc_RuntimeError, "cache is not initialized");
+        return NULL;
+    }
+    return Py_BuildValue("{s:K,s:K,s:K,s:K,s:K,s:K,s:K,s:K}",
+                         "loads", (unsigned long long) stats.loads,
+                         "load_hits", (unsigned long long) stats.load_hits,
+                         "load_misses", (unsigned long long) stats.load_misses,
+                         "stores", (unsigned long long) stats.stores,
+                         "store_hits", (unsigned long long) stats.store_hits,
+                         "store_misses", (unsigned long long) stats.store_misses,
+                         "cycles", (unsigned long long) stats.cycles,
+                         "dirty_evictions", (unsigned long long) stats.dirty_evictions);
+}
+
+static PyMethodDef Cache_methods[] = {
+    {"access", (PyCFunction) Cache_access, METH_VARARGS,
+     "access(addresses, ops): runs the accesses in order (ops: 0 load, 1 store, 2 fetch)"},
+    {"stats", (PyCFunction) Cache_stats, METH_NOARGS, "stats(): the counters so far, as a dict"},
+    {NULL, NULL, 0, NULL}
+};
+
+static PyTypeObject Cache_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "csim.Cache",
+    .tp_basicsize = sizeof(Cache_Object),
+    .tp_dealloc = (destructor) Cache_dealloc,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_doc = "Cache(sets, blocks_per_set, bytes_per_block, write_allocate=True, write_through=False, policy='lru')",
+    .tp_methods = Cache_methods,
+    .tp_init = (initproc) Cache_init,
+    .tp_new = Cache_new,
+};
+
+static struct PyModuleDef csim_module = {
+    PyModuleDef_HEAD_INIT, "csim", "Cache simulator (libcsim) bindings", -1, NULL, NULL, NULL, NULL, NULL
+};
+
+PyMODINIT_FUNC PyInit_csim(void) {
+    PyObject *module;
+    if (PyType_Ready(&Cache_Type) < 0) {
+        return NULL;
+    }
+    module = PyModule_Create(&csim_module);
+    if (module == NULL) {
+        return NULL;
+    }
+    Py_INCREF(&Cache_Type);
+    if (PyModule_AddObject(module, "Cache", (PyObject *) &Cache_Type) < 0) {
+        Py_DECREF(&Cache_Type);
+        Py_DECREF(module);
+        return NULL;
+    }
+    PyModule_AddIntConstant(module, "LOAD", CSIM_LOAD);
+    PyModule_AddIntConstant(module, "STORE", CSIM_STORE);
+    PyModule_AddIntConstant(module, "FETCH", CSIM_FETCH);
+    return module;
+}
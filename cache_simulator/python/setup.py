@@ -0,0 +1,23 @@
+#
+# Builds the csim Python extension over libcsim.a: run "make python" in
+# cache_simulator, which builds the library first.
+#
+# Jiwon Moon, Hajin Jang
+#
+
+from setuptools import Extension, setup
+
+setup(
+    name="csim",
+    version="1.0",
+    description="Cache simulator bindings",
+    ext_modules=[
+        Extension(
+            "csim",
+            sources=["csim_module.c"],
+            include_dirs=[".."],
+            extra_objects=["../libcsim.a"],
+            libraries=["stdc++"],
+        )
+    ],
+)
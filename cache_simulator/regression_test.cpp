@@ -0,0 +1,853 @@
+/*
+ * Regression suite: runs synthetic 64-bit traces through Cache_Simulator and
+ * Parallel_Simulator and compares the results with a straightforward
+ * reference model, then does the same for Cache_Hierarchy and checks its
+ * corner cases
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "cache_hierarchy.h"
+#include "cache_simulator.h"
+#include "parallel_simulator.h"
+#include "replacement_policy.h"
+#include "trace.h"
+
+namespace {
+
+/*
+ * The reference model: every set is an array of ways, searched linearly for
+ * the whole block number (address / block size), so it shares no address
+ * decoding with the simulator. Misses fill the lowest invalid way, as the
+ * simulator does, and each policy's victim follows its description in
+ * replacement_policy.h in the most direct form:
+ *
+ *   lru, fifo, lfu  the line with the oldest use, the oldest fill, or the
+ *                   fewest uses since its fill (then the oldest use)
+ *   random          the same per-set xorshift sequence
+ *   tree-plru       a walk down a tree of "victim is on the right" flags over
+ *                   halves of the way range
+ *   bit-plru        the first way whose MRU flag is clear
+ *   srrip, brrip    the first way with RRPV 3, after aging the set until
+ *                   there is one
+ *   opt             the line whose next access, from a backward scan of the
+ *                   trace, is furthest away (Belady)
+ */
+class Reference_Cache {
+private:
+    struct Line {
+        bool valid, dirty;
+        uint64_t block;
+        uint64_t last_use, filled, uses, next;
+        unsigned rrpv;
+        bool mru;
+    };
+
+    struct Set {
+        std::vector<Line> ways;
+        std::vector<bool> victim_right; // tree-plru node n (1-based heap order)
+        uint32_t random;
+        uint64_t fills;
+    };
+
+    uint64_t num_sets, num_ways, block_bytes;
+    bool is_write_allocate, is_write_through;
+    Replacement_Policy policy;
+    std::unordered_map<uint64_t, Set> sets; // only the sets the trace touches
+    std::vector<uint64_t> next_access;      // opt
+    uint64_t now;
+    uint64_t loads, stores, load_hits, load_misses, store_hits, store_misses, cycles;
+
+    Set &set_of(uint64_t index) {
+        auto found = sets.find(index);
+        if (found != sets.end()) {
+            return found->second;
+        }
+        Set &set = sets[index];
+        Line invalid = {false, false, 0, 0, 0, 0, 0, 3, false};
+        set.ways.assign(num_ways, invalid);
+        set.victim_right.assign(num_ways, false);
+        set.random = (uint32_t) index * 2654435761U + 1;
+        if (set.random == 0) {
+            set.random = 1;
+        }
+        set.fills = 0;
+        return set;
+    }
+
+    void touch_tree(Set &set, uint64_t way) {
+        uint64_t node = 1, low = 0, high = num_ways;
+        while (high - low > 1) {
+            uint64_t middle = (low + high) / 2;
+            bool left = way < middle;
+            set.victim_right[node] = left;
+            node = 2 * node + (left ? 0 : 1);
+            (left ? high : low) = middle;
+        }
+    }
+
+    void touch_mru(Set &set, uint64_t way) {
+        set.ways[way].mru = true;
+        for (const Line &line : set.ways) {
+            if (!line.mru) {
+                return;
+            }
+        }
+        for (Line &line : set.ways) {
+            line.mru = false;
+        }
+        set.ways[way].mru = true;
+    }
+
+    void on_hit(Set &set, uint64_t way) {
+        Line &line = set.ways[way];
+        line.last_use = now;
+        line.uses++;
+        line.rrpv = 0;
+        line.next = next_access.empty() ? 0 : next_access[now];
+        touch_tree(set, way);
+        touch_mru(set, way);
+    }
+
+    void on_fill(Set &set, uint64_t way) {
+        Line &line = set.ways[way];
+        line.last_use = line.filled = now;
+        line.uses = 1;
+        line.rrpv = policy == POLICY_BRRIP && set.fills++ % 32 != 0 ? 3 : 2;
+        line.next = next_access.empty() ? 0 : next_access[now];
+        touch_tree(set, way);
+        touch_mru(set, way);
+    }
+
+    uint64_t victim(Set &set) {
+        std::vector<Line> &ways = set.ways;
+        uint64_t chosen = 0;
+        switch (policy) {
+        case POLICY_LRU:
+        case POLICY_FIFO:
+        case POLICY_LFU:
+        case POLICY_OPT:
+            for (uint64_t i = 1; i < num_ways; i++) {
+                const Line &a = ways[i], &b = ways[chosen];
+                bool better = policy == POLICY_LRU ? a.last_use < b.last_use
+                              : policy == POLICY_FIFO ? a.filled < b.filled
+                              : policy == POLICY_LFU ? a.uses < b.uses || (a.uses == b.uses && a.last_use < b.last_use)
+                              : a.next > b.next;
+                if (better) {
+                    chosen = i;
+                }
+            }
+            return chosen;
+        case POLICY_RANDOM:
+            set.random ^= set.random << 13;
+            set.random ^= set.random >> 17;
+            set.random ^= set.random << 5;
+            return set.random % num_ways;
+        case POLICY_TREE_PLRU: {
+            uint64_t node = 1, low = 0, high = num_ways;
+            while (high - low > 1) {
+                uint64_t middle = (low + high) / 2;
+                bool right = set.victim_right[node];
+                node = 2 * node + (right ? 1 : 0);
+                (right ? low : high) = middle;
+            }
+            return low;
+        }
+        case POLICY_BIT_PLRU:
+            for (uint64_t i = 0; i < num_ways; i++) {
+                if (!ways[i].mru) {
+                    return i;
+                }
+            }
+            return 0;
+        case POLICY_SRRIP:
+        case POLICY_BRRIP:
+            while (true) {
+                for (uint64_t i = 0; i < num_ways; i++) {
+                    if (ways[i].rrpv == 3) {
+                        return i;
+                    }
+                }
+                for (Line &line : ways) {
+                    line.rrpv++;
+                }
+            }
+        }
+        return chosen;
+    }
+
+public:
+    Reference_Cache(uint64_t num_sets, uint64_t num_ways, uint64_t block_bytes, bool is_write_allocate,
+                    bool is_write_through, Replacement_Policy policy)
+        : num_sets(num_sets), num_ways(num_ways), block_bytes(block_bytes), is_write_allocate(is_write_allocate),
+          is_write_through(is_write_through), policy(policy), now(0), loads(0), stores(0), load_hits(0),
+          load_misses(0), store_hits(0), store_misses(0), cycles(0) {
+    }
+
+    /**
+     * Gives OPT the whole trace, which must then be run from its start.
+     */
+    void look_ahead(const std::vector<Trace_Record> &records) {
+        std::map<uint64_t, uint64_t> later; // block -> its next access so far
+        next_access.assign(records.size(), UINT64_MAX);
+        for (size_t i = records.size(); i-- > 0;) {
+            uint64_t block = records[i].address / block_bytes;
+            auto found = later.find(block);
+            if (found != later.end()) {
+                next_access[i] = found->second;
+            }
+            later[block] = i;
+        }
+    }
+
+    void access(uint64_t address, bool is_store) {
+        uint64_t block = address / block_bytes;
+        Set &set = set_of(block % num_sets);
+        uint64_t memory_cycles = 100 * (block_bytes / 4);
+        uint64_t write_cycles = is_write_through ? 101 : 1;
+        (is_store ? stores : loads)++;
+        uint64_t way = num_ways;
+        for (uint64_t i = 0; i < num_ways; i++) {
+            if (set.ways[i].valid && set.ways[i].block == block) {
+                way = i;
+            }
+        }
+        if (way < num_ways) {
+            on_hit(set, way);
+            if (is_store) {
+                store_hits++;
+                set.ways[way].dirty = true;
+                cycles += write_cycles;
+            } else {
+                load_hits++;
+                cycles++;
+            }
+        } else if (is_store && !is_write_allocate) {
+            store_misses++;
+            cycles += write_cycles;
+        } else {
+            (is_store ? store_misses : load_misses)++;
+            for (way = 0; way < num_ways && set.ways[way].valid; way++) {
+            }
+            if (way == num_ways) {
+                way = victim(set);
+                if (!is_write_through && set.ways[way].dirty) {
+                    cycles += memory_cycles;
+                }
+            }
+            Line &line = set.ways[way];
+            line.valid = true;
+            line.block = block;
+            line.dirty = is_store;
+            on_fill(set, way);
+            cycles += memory_cycles;
+            if (is_store) {
+                cycles += 1 + write_cycles;
+            }
+        }
+        now++;
+    }
+
+    void print_stats(std::ostream &out) const {
+        out << "Total loads: " << loads << "\n";
+        out << "Total stores: " << stores << "\n";
+        out << "Load hits: " << load_hits << "\n";
+        out << "Load misses: " << load_misses << "\n";
+        out << "Store hits: " << store_hits << "\n";
+        out << "Store misses: " << store_misses << "\n";
+        out << "Total cycles: " << cycles << "\n";
+    }
+};
+
+/*
+ * The reference hierarchy: the levels of the data path (no victim caches),
+ * each a plain list of lines per set, following the rules documented in
+ * cache_hierarchy.h. LRU victims are the line touched longest ago; OPT
+ * victims the line whose next access, found by scanning the trace from the
+ * last time the level touched it, is furthest away.
+ */
+class Reference_Hierarchy {
+private:
+    struct Line {
+        uint64_t block;
+        bool dirty;
+        uint64_t touched; // LRU order
+        uint64_t next;    // next access to the block after the level last touched it
+    };
+
+    struct Level {
+        Level_Config config;
+        std::vector<std::vector<Line>> sets;
+        Cache_Stats stats;
+    };
+
+    const std::vector<Trace_Record> &trace;
+    uint64_t block_bytes, memory_latency;
+    std::vector<Level> levels;
+    uint64_t now, ticks, memory_reads, memory_writes, cycles;
+
+    uint64_t next_access(uint64_t block) const {
+        for (uint64_t i = now + 1; i < trace.size(); i++) {
+            if (trace[i].address / block_bytes == block) {
+                return i;
+            }
+        }
+        return UINT64_MAX;
+    }
+
+    std::vector<Line> &set_of(Level &level, uint64_t block) {
+        return level.sets[block % level.config.sets];
+    }
+
+    Line *find(Level &level, uint64_t block) {
+        for (Line &line : set_of(level, block)) {
+            if (line.block == block) {
+                return &line;
+            }
+        }
+        return nullptr;
+    }
+
+    void touch(Line &line) {
+        line.touched = ++ticks;
+        line.next = next_access(line.block);
+    }
+
+    bool remove(Level &level, uint64_t block, bool &dirty) {
+        std::vector<Line> &set = set_of(level, block);
+        for (size_t i = 0; i < set.size(); i++) {
+            if (set[i].block == block) {
+                dirty = set[i].dirty;
+                set.erase(set.begin() + i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void fill(size_t depth, uint64_t block, bool dirty) {
+        Level &level = levels[depth];
+        std::vector<Line> &set = set_of(level, block);
+        Line line = {block, dirty, 0, 0};
+        touch(line);
+        if (set.size() < level.config.ways) {
+            set.push_back(line);
+            return;
+        }
+        size_t chosen = 0;
+        for (size_t i = 1; i < set.size(); i++) {
+            if (level.config.policy == POLICY_OPT ? set[i].next > set[chosen].next
+                                                  : set[i].touched < set[chosen].touched) {
+                chosen = i;
+            }
+        }
+        Line victim = set[chosen];
+        set[chosen] = line;
+        level.stats.evictions++;
+        if (level.config.inclusion == INCLUSION_INCLUSIVE) {
+            for (size_t above = 0; above < depth; above++) {
+                bool copy_dirty;
+                if (remove(levels[above], victim.block, copy_dirty)) {
+                    levels[above].stats.back_invalidations++;
+                    victim.dirty = victim.dirty || copy_dirty;
+                }
+            }
+        }
+        if (victim.dirty) {
+            level.stats.writebacks++;
+        }
+        write_down(depth + 1, victim.block, victim.dirty);
+    }
+
+    void write_down(size_t depth, uint64_t block, bool dirty) {
+        if (depth == levels.size()) {
+            if (dirty) {
+                cycles += memory_latency;
+                memory_writes++;
+            }
+            return;
+        }
+        Level &level = levels[depth];
+        if (level.config.inclusion != INCLUSION_EXCLUSIVE && !dirty) {
+            return;
+        }
+        cycles += level.config.latency;
+        Line *line = find(level, block);
+        if (line != nullptr) {
+            touch(*line);
+            line->dirty = line->dirty || dirty;
+        } else {
+            fill(depth, block, dirty);
+        }
+    }
+
+public:
+    Reference_Hierarchy(const std::vector<Level_Config> &configs, uint64_t memory_latency,
+                        const std::vector<Trace_Record> &trace)
+        : trace(trace), block_bytes(configs[0].block_bytes), memory_latency(memory_latency), now(0), ticks(0),
+          memory_reads(0), memory_writes(0), cycles(0) {
+        for (const Level_Config &config : configs) {
+            Level level;
+            level.config = config;
+            level.sets.resize(config.sets);
+            level.stats = Cache_Stats();
+            levels.push_back(level);
+        }
+    }
+
+    void run() {
+        for (now = 0; now < trace.size(); now++) {
+            access(trace[now].address / block_bytes, trace[now].is_store);
+        }
+    }
+
+    void access(uint64_t block, bool is_store) {
+        size_t hit = levels.size();
+        for (size_t depth = 0; depth < levels.size(); depth++) {
+            Level &level = levels[depth];
+            cycles += level.config.latency;
+            Line *line = find(level, block);
+            if (is_store) {
+                level.stats.stores++;
+                line != nullptr ? level.stats.store_hits++ : level.stats.store_misses++;
+            } else {
+                level.stats.loads++;
+                line != nullptr ? level.stats.load_hits++ : level.stats.load_misses++;
+            }
+            if (line != nullptr) {
+                touch(*line);
+                line->dirty = line->dirty || (is_store && depth == 0);
+                hit = depth;
+                break;
+            }
+        }
+        if (hit == 0) {
+            return;
+        }
+        if (hit == levels.size()) {
+            cycles += memory_latency;
+            memory_reads++;
+        }
+        // an exclusive level hands its copy up; the others keep theirs
+        bool dirty = false;
+        if (hit < levels.size() && levels[hit].config.inclusion == INCLUSION_EXCLUSIVE) {
+            remove(levels[hit], block, dirty);
+        }
+        for (size_t depth = hit; depth-- > 0;) {
+            if (depth == 0 || levels[depth].config.inclusion != INCLUSION_EXCLUSIVE) {
+                fill(depth, block, depth == 0 && (is_store || dirty));
+            }
+        }
+    }
+
+    void print_stats(std::ostream &out) const {
+        for (const Level &level : levels) {
+            const std::string &name = level.config.name;
+            const Cache_Stats &stats = level.stats;
+            out << name << " loads: " << stats.loads << "\n";
+            out << name << " stores: " << stats.stores << "\n";
+            out << name << " load hits: " << stats.load_hits << "\n";
+            out << name << " load misses: " << stats.load_misses << "\n";
+            out << name << " store hits: " << stats.store_hits << "\n";
+            out << name << " store misses: " << stats.store_misses << "\n";
+            out << name << " evictions: " << stats.evictions << "\n";
+            out << name << " writebacks: " << stats.writebacks << "\n";
+            out << name << " back invalidations: " << stats.back_invalidations << "\n";
+        }
+        out << "Memory reads: " << memory_reads << "\n";
+        out << "Memory writes: " << memory_writes << "\n";
+        out << "Total cycles: " << cycles << "\n";
+    }
+};
+
+struct Geometry {
+    unsigned sets, ways, block_bytes;
+};
+
+struct Synthetic_Trace {
+    const char *name;
+    std::vector<Trace_Record> records;
+};
+
+Trace_Record make_record(uint64_t address, bool is_store) {
+    Trace_Record record;
+    record.address = address;
+    record.is_store = is_store;
+    record.is_fetch = false;
+    record.core = 0;
+    record.pc = 0;
+    return record;
+}
+
+/**
+ * Builds the synthetic traces. Each one stresses a part of the address space
+ * that a 32-bit simulator gets wrong.
+ */
+std::vector<Synthetic_Trace> make_traces(size_t n) {
+    std::mt19937_64 rng(2024);
+    std::vector<Synthetic_Trace> traces;
+
+    // uniformly random 64-bit addresses: almost every access misses
+    Synthetic_Trace random = {"random-64", {}};
+    for (size_t i = 0; i < n; i++) {
+        random.records.push_back(make_record(rng(), rng() % 3 == 0));
+    }
+    traces.push_back(random);
+
+    // a hot working set in the 48-bit user half of the address space
+    Synthetic_Trace user = {"hot-48", {}};
+    const uint64_t stack = 0x7ffd12340000ULL;
+    for (size_t i = 0; i < n; i++) {
+        user.records.push_back(make_record(stack + (rng() % (1 << 18)) * 4, rng() % 10 < 3));
+    }
+    traces.push_back(user);
+
+    // strided loops over a 57-bit (5-level paging) kernel address range
+    Synthetic_Trace kernel = {"stride-57", {}};
+    const uint64_t base = 0x01ff800000000000ULL;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t stride = 64 << (i / 4096 % 4);
+        kernel.records.push_back(make_record(base + (i % 2048) * stride, i % 7 == 0));
+    }
+    traces.push_back(kernel);
+
+    // blocks that share their low 32 bits and differ only above them; with
+    // truncated addresses they would all be the same block
+    Synthetic_Trace aliasing = {"alias-above-32", {}};
+    for (size_t i = 0; i < n; i++) {
+        uint64_t high = (rng() % 64) << 32 | (rng() % 4) << 56;
+        aliasing.records.push_back(make_record(high | 0x12345678ULL, rng() % 4 == 0));
+    }
+    traces.push_back(aliasing);
+
+    // the very top of the address space, next to 2^64
+    Synthetic_Trace top = {"top-of-64", {}};
+    for (size_t i = 0; i < n; i++) {
+        top.records.push_back(make_record(~uint64_t(0) - (rng() % (1 << 16)) * 8, rng() % 2 == 0));
+    }
+    traces.push_back(top);
+    return traces;
+}
+
+/**
+ * @return false (after printing the difference) if the two outputs differ
+ */
+bool expect_same(const std::string &name, const std::string &expected, const std::string &actual) {
+    if (expected == actual) {
+        return true;
+    }
+    std::cout << "FAIL " << name << "\nexpected:\n" << expected << "actual:\n" << actual;
+    return false;
+}
+
+/**
+ * Checks that text traces with full 64-bit addresses parse exactly, that
+ * addresses wider than 64 bits are rejected, and that 8-byte binary traces
+ * round-trip.
+ */
+bool check_trace_formats(const std::vector<Trace_Record> &records) {
+    bool ok = true;
+    std::string text;
+    for (const Trace_Record &record : records) {
+        char line[64];
+        snprintf(line, sizeof(line), "%c 0x%016llx 4\n", record.is_store ? 's' : 'l',
+                 (unsigned long long) record.address);
+        text += line;
+    }
+    Text_Trace_Parser parser;
+    std::vector<Trace_Record> parsed;
+    if (!parser.parse(text.data(), text.data() + text.size(), parsed) || parsed.size() != records.size()) {
+        std::cout << "FAIL text trace: 64-bit addresses did not parse\n";
+        ok = false;
+    } else {
+        for (size_t i = 0; i < records.size(); i++) {
+            if (parsed[i].address != records[i].address || parsed[i].is_store != records[i].is_store) {
+                std::cout << "FAIL text trace: record " << i << " differs\n";
+                ok = false;
+                break;
+            }
+        }
+    }
+
+    const char *too_wide = "l 0x10000000000000000 4\n";
+    Text_Trace_Parser wide_parser;
+    std::vector<Trace_Record> wide;
+    if (wide_parser.parse(too_wide, too_wide + strlen(too_wide), wide)) {
+        std::cout << "FAIL text trace: a 65-bit address was accepted\n";
+        ok = false;
+    }
+
+    char path[] = "/tmp/csim_regress_XXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        std::cout << "FAIL binary trace: cannot create a temporary file\n";
+        return false;
+    }
+    close(fd);
+    Trace_Writer writer;
+    bool written = writer.open(path, 8);
+    for (const Trace_Record &record : records) {
+        written = written && writer.append(record);
+    }
+    written = written && writer.close();
+    Trace_File file;
+    std::string error;
+    std::vector<Trace_Record> decoded(records.size());
+    if (!written || !file.open(path, error) || file.size() != records.size()
+        || file.decode(0, decoded.size(), decoded.data()) != records.size()) {
+        std::cout << "FAIL binary trace: 8-byte trace did not round-trip\n";
+        ok = false;
+    } else {
+        for (size_t i = 0; i < records.size(); i++) {
+            if (decoded[i].address != records[i].address || decoded[i].is_store != records[i].is_store) {
+                std::cout << "FAIL binary trace: record " << i << " differs\n";
+                ok = false;
+                break;
+            }
+        }
+    }
+    unlink(path);
+    return ok;
+}
+
+/**
+ * Builds a trace over 48 blocks of 16 bytes, half of the accesses going to 8
+ * hot ones, so that every level of a small hierarchy both hits and evicts.
+ *
+ * @param stores whether about 30% of the accesses are stores, or none
+ */
+std::vector<Trace_Record> make_hierarchy_trace(size_t n, bool stores) {
+    std::mt19937_64 rng(33);
+    std::vector<Trace_Record> records;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t block = rng() % 2 == 0 ? rng() % 8 : 8 + rng() % 40;
+        records.push_back(make_record(block * 16 + rng() % 16, stores && rng() % 10 < 3));
+    }
+    return records;
+}
+
+/**
+ * Keeps the lines of cache or hierarchy statistics that count demand requests
+ * (loads, stores, their hits and misses and memory reads). OPT breaks ties
+ * between blocks that are never used again in its own order, which may change
+ * which dirty block is written back but not these.
+ */
+std::string demand_counters(const std::string &stats) {
+    std::istringstream in(stats);
+    std::string line, kept;
+    while (std::getline(in, line)) {
+        if (line.find("loads:") != std::string::npos || line.find("stores:") != std::string::npos
+            || line.find("hits:") != std::string::npos || line.find("misses:") != std::string::npos
+            || line.find("Memory reads:") != std::string::npos) {
+            kept += line + "\n";
+        }
+    }
+    return kept;
+}
+
+/**
+ * Runs a trace through a hierarchy and the reference hierarchy and compares
+ * their statistics, all of them or only the demand counters.
+ *
+ * @param specs the level specifications, top to bottom
+ */
+bool check_hierarchy(const std::vector<std::string> &specs, const Synthetic_Trace &trace, bool demand_only) {
+    std::string name = std::string(trace.name) + " hierarchy";
+    std::vector<Level_Config> configs(specs.size());
+    std::string error;
+    bool needs_next_use = false;
+    for (size_t i = 0; i < specs.size(); i++) {
+        name += " " + specs[i];
+        if (!parse_level_config(specs[i], configs[i], error)) {
+            std::cout << "FAIL " << name << ": " << error << "\n";
+            return false;
+        }
+        needs_next_use = needs_next_use || configs[i].policy == POLICY_OPT;
+    }
+    if (!Cache_Hierarchy::validate(configs, error)) {
+        std::cout << "FAIL " << name << ": " << error << "\n";
+        return false;
+    }
+
+    Reference_Hierarchy reference(configs, 100, trace.records);
+    reference.run();
+    std::ostringstream expected;
+    reference.print_stats(expected);
+
+    Cache_Hierarchy hierarchy(configs, 100);
+    Next_Use_Index next_use(hierarchy.block_offset_bits());
+    if (needs_next_use) {
+        next_use.add(trace.records.data(), trace.records.size());
+        hierarchy.set_next_use(next_use.data(), next_use.size());
+    }
+    hierarchy.access_batch(trace.records.data(), trace.records.size());
+    std::ostringstream actual;
+    std::streambuf *saved = std::cout.rdbuf(actual.rdbuf());
+    hierarchy.print_stats();
+    std::cout.rdbuf(saved);
+
+    if (demand_only) {
+        return expect_same(name, demand_counters(expected.str()), demand_counters(actual.str()));
+    }
+    return expect_same(name, expected.str(), actual.str());
+}
+
+/**
+ * Checks that a victim-cache hit in the L1 of a hierarchy moves the block
+ * back into the L1, and that an L1 cannot be given an inclusion policy.
+ */
+bool check_hierarchy_victim_refill() {
+    bool ok = true;
+    std::vector<Level_Config> configs(2);
+    std::string error;
+    if (!parse_level_config("l1:1:1:16:1", configs[0], error) || !parse_level_config("l2:4:2:16:10", configs[1], error)
+        || !Cache_Hierarchy::validate(configs, error)) {
+        std::cout << "FAIL hierarchy: " << error << "\n";
+        return false;
+    }
+    // 0x10 evicts 0x0 into the victim cache; the second 0x0 is a victim hit
+    // and the third must hit in the L1
+    const Trace_Record records[] = {
+        make_record(0x0, false), make_record(0x10, false), make_record(0x0, false), make_record(0x0, false),
+    };
+    Cache_Hierarchy hierarchy(configs, 100, 2);
+    hierarchy.access_batch(records, 4);
+    const Cache_Stats &l1 = hierarchy.stats(0);
+    if (l1.victim_hits != 1 || l1.load_hits != 1) {
+        std::cout << "FAIL hierarchy: L1 victim hit not refilled (" << l1.victim_hits << " victim hits, "
+                  << l1.load_hits << " load hits)\n";
+        ok = false;
+    }
+
+    const char *upper_levels[][2] = {{"l1:1:1:16:1:lru:exclusive", "l2:4:2:16:10"},
+                                     {"l1i:1:1:16:1:lru:inclusive", "l1:1:1:16:1"},
+                                     {"l1i:1:1:16:1", "l1:1:1:16:1:lru:exclusive"}};
+    for (const auto &levels : upper_levels) {
+        if (parse_level_config(levels[0], configs[0], error) && parse_level_config(levels[1], configs[1], error)
+            && Cache_Hierarchy::validate(configs, error)) {
+            std::cout << "FAIL hierarchy: an inclusion policy was accepted on an L1 (" << levels[0] << " "
+                      << levels[1] << ")\n";
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+}
+
+/**
+ * Main function of the regression suite.
+ *
+ * @return 0 if every case matches the reference model
+ */
+int main() {
+    // geometries from a single block to 256-way sets (several valid-bit words
+    // per set), 2^20 sets and 16 MiB blocks (a miss costs 419430400 cycles, so
+    // 32-bit counters overflow within a few misses)
+    const Geometry geometries[] = {
+        {1, 1, 4}, {1, 8, 16}, {256, 4, 16}, {1024, 1, 64}, {4, 256, 64},
+        {64, 16, 4096}, {1 << 20, 2, 64}, {16, 4, 1 << 24}, {1 << 16, 2, 1 << 20},
+    };
+    const bool write_policies[][2] = {{true, true}, {true, false}, {false, true}}; // allocate, through
+    const Replacement_Policy policies[] = {POLICY_LRU, POLICY_FIFO, POLICY_RANDOM, POLICY_TREE_PLRU, POLICY_BIT_PLRU,
+                                           POLICY_LFU, POLICY_SRRIP, POLICY_BRRIP, POLICY_OPT};
+
+    std::vector<Synthetic_Trace> traces = make_traces(20000);
+    unsigned passed = 0, failed = 0;
+    for (const Synthetic_Trace &trace : traces) {
+        for (const Geometry &g : geometries) {
+            for (const auto &write : write_policies) {
+                for (Replacement_Policy policy : policies) {
+                    std::ostringstream name;
+                    name << trace.name << " " << g.sets << " " << g.ways << " " << g.block_bytes << " "
+                         << (write[0] ? "write-allocate " : "no-write-allocate ")
+                         << (write[1] ? "write-through " : "write-back ") << replacement_policy_name(policy);
+
+                    Reference_Cache reference(g.sets, g.ways, g.block_bytes, write[0], write[1], policy);
+                    if (policy == POLICY_OPT) {
+                        reference.look_ahead(trace.records);
+                    }
+                    for (const Trace_Record &record : trace.records) {
+                        reference.access(record.address, record.is_store);
+                    }
+                    std::ostringstream expected;
+                    reference.print_stats(expected);
+
+                    Cache_Simulator cache(g.sets, g.ways, g.block_bytes, write[0], write[1], policy);
+                    Next_Use_Index next_use(cache.block_offset_bits());
+                    if (policy == POLICY_OPT) {
+                        next_use.add(trace.records.data(), trace.records.size());
+                        cache.set_next_use(next_use.data(), next_use.size());
+                    }
+                    cache.access_batch(trace.records.data(), trace.records.size());
+                    std::ostringstream serial;
+                    cache.print_stats(serial);
+                    if (policy == POLICY_OPT) {
+                        // OPT's order among dead blocks is its own (see
+                        // demand_counters), and Parallel_Simulator has no OPT
+                        bool ok = expect_same(name.str(), demand_counters(expected.str()),
+                                              demand_counters(serial.str()));
+                        (ok ? passed : failed)++;
+                        continue;
+                    }
+                    bool ok = expect_same(name.str(), expected.str(), serial.str());
+
+                    if (g.sets > 1) {
+                        Parallel_Simulator parallel(3, g.sets, g.ways, g.block_bytes, write[0], write[1], policy);
+                        parallel.access_batch(trace.records.data(), trace.records.size());
+                        std::ostringstream threaded;
+                        parallel.finish().print_stats(threaded);
+                        ok = expect_same(name.str() + " (3 threads)", expected.str(), threaded.str()) && ok;
+                    }
+                    (ok ? passed : failed)++;
+                }
+            }
+        }
+        (check_trace_formats(trace.records) ? passed : failed)++;
+    }
+
+    // inclusive back-invalidation (across two levels in the three-level
+    // cases), exclusive swaps and NINE dirty write-downs with LRU; then OPT at
+    // the L1 and below it. OPT runs with stores compare only the demand
+    // counters (see demand_counters), and OPT at the L1 only runs loads: its
+    // choice among dead blocks there decides which blocks are written down
+    const Synthetic_Trace mixed = {"hot-blocks", make_hierarchy_trace(3000, true)};
+    const Synthetic_Trace loads = {"hot-blocks-loads", make_hierarchy_trace(3000, false)};
+    const struct {
+        std::vector<std::string> specs;
+        bool with_stores;
+    } hierarchies[] = {
+        {{"l1d:2:2:16:1", "l2:4:4:16:10:lru:inclusive"}, true},
+        {{"l1d:2:2:16:1", "l2:2:2:16:10:lru:inclusive"}, true},
+        {{"l1d:2:2:16:1", "l2:4:2:16:10:lru:exclusive"}, true},
+        {{"l1d:2:2:16:1", "l2:4:4:16:10"}, true},
+        {{"l1d:1:2:16:1", "l2:2:4:16:10", "l3:4:4:16:30:lru:inclusive"}, true},
+        {{"l1d:1:2:16:1", "l2:2:2:16:10:lru:exclusive", "l3:4:4:16:30:lru:inclusive"}, true},
+        {{"l1d:2:2:16:1:opt", "l2:4:4:16:10"}, false},
+        {{"l1d:2:2:16:1:opt", "l2:2:4:16:10:opt"}, false},
+        {{"l1d:1:1:16:1", "l2:1:2:16:10:opt:exclusive"}, false},
+        {{"l1d:2:2:16:1", "l2:2:4:16:10:opt:exclusive"}, false},
+        {{"l1d:2:2:16:1", "l2:2:4:16:10:opt:exclusive"}, true},
+        {{"l1d:2:2:16:1", "l2:2:4:16:10:opt"}, true},
+    };
+    for (const auto &h : hierarchies) {
+        bool is_opt = false;
+        for (const std::string &spec : h.specs) {
+            is_opt = is_opt || spec.find(":opt") != std::string::npos;
+        }
+        bool ok = check_hierarchy(h.specs, h.with_stores ? mixed : loads, is_opt && h.with_stores);
+        (ok ? passed : failed)++;
+    }
+    (check_hierarchy_victim_refill() ? passed : failed)++;
+    std::cout << passed << " passed, " << failed << " failed\n";
+    return failed == 0 ? 0 : 1;
+}
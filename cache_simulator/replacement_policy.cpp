@@ -0,0 +1,53 @@
+/*
+ * C++ implementation of cache replacement policies
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include "replacement_policy.h"
+
+namespace {
+
+const char *const POLICY_NAMES[] = {
+    "lru", "fifo", "random", "tree-plru", "bit-plru", "lfu", "srrip", "brrip", "opt"
+};
+
+}
+
+/**
+ * Converts a policy name ("lru", "fifo", "random", "tree-plru", "bit-plru",
+ * "lfu", "srrip", "brrip" or "opt") to the policy.
+ *
+ * @return false if the name is unknown
+ */
+bool parse_replacement_policy(const std::string &name, Replacement_Policy &policy) {
+    for (unsigned i = 0; i < sizeof(POLICY_NAMES) / sizeof(POLICY_NAMES[0]); i++) {
+        if (name == POLICY_NAMES[i]) {
+            policy = (Replacement_Policy) i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return the name of a policy
+ */
+const char *replacement_policy_name(Replacement_Policy policy) {
+    return POLICY_NAMES[policy];
+}
+
+/**
+ * Appends the next n accesses of the trace.
+ */
+void Next_Use_Index::add(const Trace_Record *records, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        uint64_t now = next_use.size();
+        auto inserted = last_use.insert(std::make_pair(records[i].address >> offset_bits, now));
+        if (!inserted.second) {
+            // the previous access to this block is next used now
+            next_use[inserted.first->second] = now;
+            inserted.first->second = now;
+        }
+        next_use.push_back(UINT64_MAX);
+    }
+}
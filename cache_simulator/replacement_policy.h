@@ -0,0 +1,498 @@
+/*
+ * h file for cache replacement policies
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef REPLACEMENT_POLICY_H
+#define REPLACEMENT_POLICY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "trace.h"
+
+/*
+ * Replacement policies share one compile-time interface, used by the
+ * simulator's access loop, which is instantiated once per policy so every call
+ * below is inlined:
+ *
+ *   void init(uint32_t num_sets, uint32_t num_ways);
+ *   void on_hit(uint32_t set, uint32_t way, uint64_t now);   a valid way was accessed
+ *   void on_fill(uint32_t set, uint32_t way, uint64_t now);  a block was filled into way
+ *   uint32_t victim(uint32_t set, uint64_t now);             pick a way of a full set
+ *
+ * now is the index of the current access in the trace. The cache fills invalid
+ * ways before it asks for a victim, so victim() is only called on full sets.
+ * Optional hooks have no-op defaults in Policy_Base.
+ */
+enum Replacement_Policy {
+    POLICY_LRU,
+    POLICY_FIFO,
+    POLICY_RANDOM,
+    POLICY_TREE_PLRU,
+    POLICY_BIT_PLRU,
+    POLICY_LFU,
+    POLICY_SRRIP,
+    POLICY_BRRIP,
+    POLICY_OPT
+};
+
+/**
+ * Converts a policy name ("lru", "fifo", "random", "tree-plru", "bit-plru",
+ * "lfu", "srrip", "brrip" or "opt") to the policy.
+ *
+ * @return false if the name is unknown
+ */
+bool parse_replacement_policy(const std::string &name, Replacement_Policy &policy);
+
+/**
+ * @return the name of a policy
+ */
+const char *replacement_policy_name(Replacement_Policy policy);
+
+/*
+ * Optional hooks of the policy interface.
+ */
+class Policy_Base {
+public:
+    /**
+     * Gives the policy the next-use index of the trace (see Next_Use_Index).
+     */
+    void set_next_use(const uint64_t *next_use, uint64_t length) {
+        (void) next_use;
+        (void) length;
+    }
+};
+
+/*
+ * Doubly linked recency list per set, threaded through flat prev/next arrays
+ * with the most recent way at the head. Moving a way and finding the tail are O(1).
+ */
+class Recency_List {
+protected:
+    uint32_t num_ways;
+    std::vector<uint32_t> prev_way, next_way; // per-way links
+    std::vector<uint32_t> head_way, tail_way; // per-set most/least recent way
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        this->num_ways = num_ways;
+        prev_way.resize((size_t) num_sets * num_ways);
+        next_way.resize((size_t) num_sets * num_ways);
+        head_way.assign(num_sets, 0);
+        tail_way.assign(num_sets, num_ways - 1);
+        for (size_t set = 0; set < num_sets; set++) {
+            for (uint32_t way = 0; way < num_ways; way++) {
+                prev_way[set * num_ways + way] = way - 1; // wraps for the head, never read
+                next_way[set * num_ways + way] = way + 1;
+            }
+        }
+    }
+
+    void move_to_head(uint32_t set, uint32_t way) {
+        if (head_way[set] == way) {
+            return;
+        }
+        uint32_t *prev = &prev_way[(size_t) set * num_ways];
+        uint32_t *next = &next_way[(size_t) set * num_ways];
+        // unlink (the way is not the head, so it has a predecessor)
+        next[prev[way]] = next[way];
+        if (tail_way[set] == way) {
+            tail_way[set] = prev[way];
+        } else {
+            prev[next[way]] = prev[way];
+        }
+        // relink at the head
+        next[way] = head_way[set];
+        prev[head_way[set]] = way;
+        head_way[set] = way;
+    }
+};
+
+/*
+ * True LRU: every access moves the way to the head, the tail is evicted.
+ */
+class Lru_Policy : public Policy_Base, public Recency_List {
+public:
+    void on_hit(uint32_t set, uint32_t way, uint64_t) { move_to_head(set, way); }
+    void on_fill(uint32_t set, uint32_t way, uint64_t) { move_to_head(set, way); }
+    uint32_t victim(uint32_t set, uint64_t) const { return tail_way[set]; }
+};
+
+/*
+ * FIFO: only fills move a way to the head, so the tail is the oldest block.
+ */
+class Fifo_Policy : public Policy_Base, public Recency_List {
+public:
+    void on_hit(uint32_t, uint32_t, uint64_t) { }
+    void on_fill(uint32_t set, uint32_t way, uint64_t) { move_to_head(set, way); }
+    uint32_t victim(uint32_t set, uint64_t) const { return tail_way[set]; }
+};
+
+/*
+ * Random replacement with a xorshift generator per set, so a set's victims do
+ * not depend on accesses to other sets.
+ */
+class Random_Policy : public Policy_Base {
+private:
+    uint32_t way_mask;
+    std::vector<uint32_t> state;
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        way_mask = num_ways - 1; // ways are a power of 2
+        state.resize(num_sets);
+        for (uint32_t set = 0; set < num_sets; set++) {
+            state[set] = set * 2654435761U + 1;
+            if (state[set] == 0) {
+                state[set] = 1;
+            }
+        }
+    }
+
+    void on_hit(uint32_t, uint32_t, uint64_t) { }
+    void on_fill(uint32_t, uint32_t, uint64_t) { }
+
+    uint32_t victim(uint32_t set, uint64_t) {
+        uint32_t x = state[set];
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        state[set] = x;
+        return x & way_mask;
+    }
+};
+
+/*
+ * Tree pseudo-LRU: a binary tree of num_ways - 1 bits per set. Each access
+ * points the nodes on its path away from the accessed way; the victim is found
+ * by following the bits from the root. O(log ways) per access.
+ */
+class Tree_Plru_Policy : public Policy_Base {
+private:
+    uint32_t num_ways, levels, words_per_set;
+    std::vector<uint64_t> bits; // node n (1-based heap order) is bit n of the set
+
+    bool get(uint32_t set, uint32_t node) const {
+        return (bits[(size_t) set * words_per_set + node / 64] >> (node % 64)) & 1;
+    }
+
+    void put(uint32_t set, uint32_t node, bool value) {
+        uint64_t &word = bits[(size_t) set * words_per_set + node / 64];
+        uint64_t mask = uint64_t(1) << (node % 64);
+        word = value ? (word | mask) : (word & ~mask);
+    }
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        this->num_ways = num_ways;
+        levels = 0;
+        while ((1U << levels) < num_ways) {
+            levels++;
+        }
+        words_per_set = (num_ways + 63) / 64;
+        bits.assign((size_t) num_sets * words_per_set, 0);
+    }
+
+    void on_hit(uint32_t set, uint32_t way, uint64_t) {
+        uint32_t node = 1;
+        for (uint32_t level = 0; level < levels; level++) {
+            bool right = (way >> (levels - 1 - level)) & 1;
+            put(set, node, !right); // point away from the accessed half
+            node = 2 * node + right;
+        }
+    }
+
+    void on_fill(uint32_t set, uint32_t way, uint64_t now) { on_hit(set, way, now); }
+
+    uint32_t victim(uint32_t set, uint64_t) const {
+        uint32_t node = 1;
+        for (uint32_t level = 0; level < levels; level++) {
+            node = 2 * node + get(set, node);
+        }
+        return node - num_ways;
+    }
+};
+
+/*
+ * Bit pseudo-LRU (MRU bits): an access sets the way's bit, clearing all others
+ * once every bit would be set; the victim is the first way with a clear bit.
+ * O(ways / 64) per access.
+ */
+class Bit_Plru_Policy : public Policy_Base {
+private:
+    uint32_t num_ways, words_per_set;
+    std::vector<uint64_t> bits;
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        this->num_ways = num_ways;
+        words_per_set = (num_ways + 63) / 64;
+        bits.assign((size_t) num_sets * words_per_set, 0);
+    }
+
+    void on_hit(uint32_t set, uint32_t way, uint64_t) {
+        uint64_t *word = &bits[(size_t) set * words_per_set];
+        word[way / 64] |= uint64_t(1) << (way % 64);
+        for (uint32_t w = 0; w < words_per_set; w++) {
+            uint32_t n = num_ways - w * 64 < 64 ? num_ways - w * 64 : 64;
+            uint64_t full = n == 64 ? ~uint64_t(0) : (uint64_t(1) << n) - 1;
+            if (word[w] != full) {
+                return;
+            }
+        }
+        // every way is marked recent: start a new epoch with just this way
+        for (uint32_t w = 0; w < words_per_set; w++) {
+            word[w] = 0;
+        }
+        word[way / 64] = uint64_t(1) << (way % 64);
+    }
+
+    void on_fill(uint32_t set, uint32_t way, uint64_t now) { on_hit(set, way, now); }
+
+    uint32_t victim(uint32_t set, uint64_t) const {
+        const uint64_t *word = &bits[(size_t) set * words_per_set];
+        for (uint32_t w = 0; w < words_per_set; w++) {
+            if (~word[w] != 0) {
+                uint32_t way = w * 64 + __builtin_ctzll(~word[w]);
+                if (way < num_ways) {
+                    return way;
+                }
+            }
+        }
+        return 0; // only reachable with a single way
+    }
+};
+
+/*
+ * Binary min-heap of the ways of every set, stored flat, with a position index
+ * so that a way's key can be changed in O(log ways).
+ */
+class Way_Heap {
+private:
+    typedef std::pair<uint64_t, uint64_t> Key;
+    uint32_t num_ways;
+    std::vector<uint32_t> heap;     // heap[set * num_ways + i] = way
+    std::vector<uint32_t> position; // position[set * num_ways + way] = i
+    std::vector<Key> keys;          // keys[set * num_ways + way]
+
+    void swap_nodes(size_t base, uint32_t i, uint32_t j) {
+        std::swap(heap[base + i], heap[base + j]);
+        position[base + heap[base + i]] = i;
+        position[base + heap[base + j]] = j;
+    }
+
+    bool less(size_t base, uint32_t i, uint32_t j) const {
+        return keys[base + heap[base + i]] < keys[base + heap[base + j]];
+    }
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        this->num_ways = num_ways;
+        heap.resize((size_t) num_sets * num_ways);
+        position.resize((size_t) num_sets * num_ways);
+        keys.assign((size_t) num_sets * num_ways, Key(0, 0));
+        for (size_t i = 0; i < heap.size(); i++) {
+            heap[i] = i % num_ways;
+            position[i] = i % num_ways;
+        }
+    }
+
+    /**
+     * Sets the key of a way and restores the heap order.
+     */
+    void update(uint32_t set, uint32_t way, uint64_t major, uint64_t minor) {
+        size_t base = (size_t) set * num_ways;
+        Key old_key = keys[base + way];
+        keys[base + way] = Key(major, minor);
+        uint32_t i = position[base + way];
+        if (keys[base + way] < old_key) {
+            while (i > 0 && less(base, i, (i - 1) / 2)) {
+                swap_nodes(base, i, (i - 1) / 2);
+                i = (i - 1) / 2;
+            }
+        } else {
+            while (true) {
+                uint32_t smallest = i, left = 2 * i + 1, right = 2 * i + 2;
+                if (left < num_ways && less(base, left, smallest)) {
+                    smallest = left;
+                }
+                if (right < num_ways && less(base, right, smallest)) {
+                    smallest = right;
+                }
+                if (smallest == i) {
+                    break;
+                }
+                swap_nodes(base, i, smallest);
+                i = smallest;
+            }
+        }
+    }
+
+    /**
+     * @return the way with the smallest key in the set
+     */
+    uint32_t top(uint32_t set) const { return heap[(size_t) set * num_ways]; }
+};
+
+/*
+ * LFU: evicts the least frequently used way, the least recently used one among
+ * ties. Counts restart when a block is filled. O(log ways) per access.
+ */
+class Lfu_Policy : public Policy_Base {
+private:
+    uint32_t num_ways;
+    std::vector<uint64_t> counts;
+    Way_Heap heap;
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        this->num_ways = num_ways;
+        counts.assign((size_t) num_sets * num_ways, 0);
+        heap.init(num_sets, num_ways);
+    }
+
+    void on_hit(uint32_t set, uint32_t way, uint64_t now) {
+        uint64_t count = ++counts[(size_t) set * num_ways + way];
+        heap.update(set, way, count, now);
+    }
+
+    void on_fill(uint32_t set, uint32_t way, uint64_t now) {
+        counts[(size_t) set * num_ways + way] = 1;
+        heap.update(set, way, 1, now);
+    }
+
+    uint32_t victim(uint32_t set, uint64_t) const { return heap.top(set); }
+};
+
+/*
+ * Re-reference interval prediction with 2-bit RRPVs (Jaleel et al.). The ways
+ * of a set are kept as one bitmask per RRPV value, so finding a distant way and
+ * aging the whole set are O(ways / 64) word operations. Hits promote to 0.
+ * SRRIP inserts at 2; BRRIP inserts at 3 except for every 32nd fill of a set.
+ */
+template <bool Bimodal>
+class Rrip_Policy : public Policy_Base {
+private:
+    static const unsigned MAX_RRPV = 3;
+    uint32_t words_per_set;
+    std::vector<uint64_t> level_bits[MAX_RRPV + 1]; // a way's RRPV is the level holding its bit
+    std::vector<uint8_t> fills;                     // per-set BRRIP throttle
+
+    void move(uint32_t set, uint32_t way, unsigned value) {
+        size_t word = (size_t) set * words_per_set + way / 64;
+        uint64_t mask = uint64_t(1) << (way % 64);
+        for (unsigned v = 0; v <= MAX_RRPV; v++) {
+            level_bits[v][word] &= ~mask;
+        }
+        level_bits[value][word] |= mask;
+    }
+
+public:
+    void init(uint32_t num_sets, uint32_t num_ways) {
+        words_per_set = (num_ways + 63) / 64;
+        for (unsigned v = 0; v < MAX_RRPV; v++) {
+            level_bits[v].assign((size_t) num_sets * words_per_set, 0);
+        }
+        // every way starts out distant
+        level_bits[MAX_RRPV].assign((size_t) num_sets * words_per_set, 0);
+        for (uint32_t set = 0; set < num_sets; set++) {
+            for (uint32_t way = 0; way < num_ways; way++) {
+                level_bits[MAX_RRPV][(size_t) set * words_per_set + way / 64] |= uint64_t(1) << (way % 64);
+            }
+        }
+        fills.assign(num_sets, 0);
+    }
+
+    void on_hit(uint32_t set, uint32_t way, uint64_t) { move(set, way, 0); }
+
+    void on_fill(uint32_t set, uint32_t way, uint64_t) {
+        unsigned insert = MAX_RRPV - 1;
+        if (Bimodal) {
+            insert = (fills[set]++ % 32 == 0) ? MAX_RRPV - 1 : MAX_RRPV;
+        }
+        move(set, way, insert);
+    }
+
+    uint32_t victim(uint32_t set, uint64_t) {
+        size_t base = (size_t) set * words_per_set;
+        while (true) {
+            for (uint32_t w = 0; w < words_per_set; w++) {
+                if (level_bits[MAX_RRPV][base + w] != 0) {
+                    return w * 64 + __builtin_ctzll(level_bits[MAX_RRPV][base + w]);
+                }
+            }
+            // no distant way: age every way of the set by one, which just shifts
+            // the level masks up (the top level is empty, so nothing saturates)
+            for (uint32_t w = 0; w < words_per_set; w++) {
+                for (unsigned v = MAX_RRPV; v > 0; v--) {
+                    level_bits[v][base + w] = level_bits[v - 1][base + w];
+                }
+                level_bits[0][base + w] = 0;
+            }
+        }
+    }
+};
+
+typedef Rrip_Policy<false> Srrip_Policy;
+typedef Rrip_Policy<true> Brrip_Policy;
+
+/*
+ * Belady's OPT: evicts the way whose block is next used furthest in the
+ * future, using a precomputed next-use index of the trace. O(log ways).
+ */
+class Opt_Policy : public Policy_Base {
+private:
+    const uint64_t *next_use;
+    uint64_t length;
+    Way_Heap heap;
+
+    void schedule(uint32_t set, uint32_t way, uint64_t now) {
+        uint64_t next = now < length ? next_use[now] : UINT64_MAX;
+        heap.update(set, way, ~next, 0); // min-heap on ~next = max next use
+    }
+
+public:
+    Opt_Policy() : next_use(nullptr), length(0) { }
+
+    void set_next_use(const uint64_t *next_use, uint64_t length) {
+        this->next_use = next_use;
+        this->length = length;
+    }
+
+    void init(uint32_t num_sets, uint32_t num_ways) { heap.init(num_sets, num_ways); }
+    void on_hit(uint32_t set, uint32_t way, uint64_t now) { schedule(set, way, now); }
+    void on_fill(uint32_t set, uint32_t way, uint64_t now) { schedule(set, way, now); }
+    uint32_t victim(uint32_t set, uint64_t) const { return heap.top(set); }
+};
+
+/*
+ * Next-use index for OPT: entry i is the index of the next access to the same
+ * block as access i, or UINT64_MAX if there is none. Built in one forward pass,
+ * so traces can be added in chunks.
+ */
+class Next_Use_Index {
+private:
+    unsigned offset_bits;
+    std::vector<uint64_t> next_use;
+    std::unordered_map<uint64_t, uint64_t> last_use; // block -> latest access
+
+public:
+    /**
+     * @param offset_bits log2 of the block size
+     */
+    Next_Use_Index(unsigned offset_bits) : offset_bits(offset_bits) { }
+
+    /**
+     * Appends the next n accesses of the trace.
+     */
+    void add(const Trace_Record *records, size_t n);
+
+    const uint64_t *data() const { return next_use.data(); }
+    uint64_t size() const { return next_use.size(); }
+};
+
+#endif //REPLACEMENT_POLICY_H
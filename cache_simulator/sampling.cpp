@@ -0,0 +1,264 @@
+/*
+ * C++ implementation of sampled cache simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <random>
+#include <sstream>
+#include "sampling.h"
+
+namespace {
+
+// two-sided 95% quantile of the normal distribution
+const double Z_95 = 1.96;
+// picks the sampled sets, so a ratio always samples the same sets
+const uint64_t SET_SEED = 0x5e75;
+
+bool parse_count(const std::string &text, uint64_t &value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    value = std::strtoull(text.c_str(), nullptr, 10);
+    return true;
+}
+
+unsigned log2_of(uint64_t x) {
+    unsigned bits = 0;
+    while ((uint64_t(1) << bits) < x) {
+        bits++;
+    }
+    return bits;
+}
+
+}
+
+/**
+ * Parses a set sampling ratio n (simulate 1 in n sets), e.g. "16".
+ *
+ * @return false if the ratio is not a number, otherwise config is set
+ */
+bool parse_set_sampling(const std::string &spec, Sampling_Config &config, std::string &error) {
+    uint64_t ratio;
+    if (!parse_count(spec, ratio) || ratio > UINT32_MAX) {
+        error = "invalid set sampling ratio " + spec;
+        return false;
+    }
+    config.kind = SAMPLE_SETS;
+    config.set_ratio = (unsigned) ratio;
+    config.unit = config.period = config.warmup = 0;
+    return true;
+}
+
+/**
+ * Parses a time sampling spec unit:period[:warmup], e.g. "1000:100000:10000".
+ * The warmup defaults to a tenth of the gap, (period - unit) / 10; a warmup
+ * of the whole gap keeps the cache state exact but simulates every access.
+ *
+ * @return false if the spec is malformed, otherwise config is set
+ */
+bool parse_time_sampling(const std::string &spec, Sampling_Config &config, std::string &error) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 2 || fields.size() > 3) {
+        error = "time sampling must be unit:period[:warmup]: " + spec;
+        return false;
+    }
+    uint64_t unit, period, warmup = 0;
+    if (!parse_count(fields[0], unit) || !parse_count(fields[1], period)
+        || (fields.size() > 2 && !parse_count(fields[2], warmup))) {
+        error = "invalid number in time sampling " + spec;
+        return false;
+    }
+    if (unit == 0 || period < unit) {
+        error = "time sampling needs 0 < unit <= period: " + spec;
+        return false;
+    }
+    if (fields.size() < 3) {
+        warmup = (period - unit) / 10;
+    } else if (warmup > period - unit) {
+        error = "time sampling warmup must fit between the units: " + spec;
+        return false;
+    }
+    config.kind = SAMPLE_TIME;
+    config.set_ratio = 1;
+    config.unit = unit;
+    config.period = period;
+    config.warmup = warmup;
+    return true;
+}
+
+/**
+ * Checks that a sampling configuration fits a cache.
+ *
+ * @return false if it does not, otherwise error is untouched
+ */
+bool Sampled_Simulator::validate(const Cache_Config &cache, const Sampling_Config &config, std::string &error) {
+    if (config.kind == SAMPLE_SETS) {
+        unsigned ratio = config.set_ratio;
+        if (ratio == 0 || (ratio & (ratio - 1)) != 0 || ratio > cache.n_sets) {
+            error = "the set sampling ratio must be a power of 2 no larger than the number of sets.";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @param cache the configuration of the full cache
+ * @param config how to sample
+ */
+Sampled_Simulator::Sampled_Simulator(const Cache_Config &cache, const Sampling_Config &config)
+    : config(config), num_sets(cache.n_sets), offset_bits(log2_of(cache.n_bytes_per_block)),
+      index_bits(log2_of(cache.n_sets)), ratio_bits(0), position(0), unit_misses(0), num_accesses(0),
+      num_simulated(0) {
+    unsigned sampled_sets = cache.n_sets;
+    if (config.kind == SAMPLE_SETS) {
+        ratio_bits = log2_of(config.set_ratio);
+        sampled_sets >>= ratio_bits;
+        samples.assign(sampled_sets, Sample());
+        // the first sampled_sets of a seeded shuffle (the generator and the
+        // swaps are fully specified, unlike std::shuffle)
+        std::vector<uint32_t> order(num_sets);
+        for (uint32_t s = 0; s < num_sets; s++) {
+            order[s] = s;
+        }
+        std::mt19937_64 rng(SET_SEED);
+        for (uint32_t s = 0; s < sampled_sets; s++) {
+            std::swap(order[s], order[s + rng() % (num_sets - s)]);
+        }
+        sampled_set.assign(num_sets, -1);
+        for (uint32_t s = 0; s < sampled_sets; s++) {
+            sampled_set[order[s]] = (int32_t) s;
+        }
+    }
+    sampled_cache.reset(new Cache_Simulator(sampled_sets, cache.n_blocks_per_set, cache.n_bytes_per_block,
+                                            cache.is_write_allocate, cache.is_write_through, cache.policy));
+}
+
+/**
+ * Runs a batch of decoded trace records, simulating the sampled ones.
+ *
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Sampled_Simulator::access_batch(const Trace_Record *records, size_t n) {
+    num_accesses += n;
+    if (config.kind == SAMPLE_SETS) {
+        access_sets(records, n);
+    } else {
+        access_time(records, n);
+    }
+}
+
+/**
+ * Maps the accesses of the sampled sets to the sets of the smaller cache
+ * (the tag is unchanged) and runs them one at a time, so each set's misses
+ * are known.
+ */
+void Sampled_Simulator::access_sets(const Trace_Record *records, size_t n) {
+    const uint64_t index_mask = (uint64_t(1) << index_bits) - 1;
+    const uint64_t offset_mask = (uint64_t(1) << offset_bits) - 1;
+    const unsigned tag_shift = offset_bits + index_bits;
+    for (size_t i = 0; i < n; i++) {
+        int32_t set = sampled_set[(records[i].address >> offset_bits) & index_mask];
+        if (set < 0) {
+            continue;
+        }
+        Trace_Record mapped = records[i];
+        mapped.address = ((records[i].address >> tag_shift) << (tag_shift - ratio_bits))
+                         | ((uint64_t) set << offset_bits) | (records[i].address & offset_mask);
+        uint64_t misses = sampled_cache->total_misses();
+        sampled_cache->access_batch(&mapped, 1);
+        Sample &sample = samples[set];
+        sample.accesses++;
+        sample.misses += sampled_cache->total_misses() - misses;
+        num_simulated++;
+    }
+}
+
+/**
+ * Splits the records at the phase boundaries of each period: skipped,
+ * warming, then measured. A unit cut off by the end of the trace is not a
+ * sample.
+ */
+void Sampled_Simulator::access_time(const Trace_Record *records, size_t n) {
+    const uint64_t warm_start = config.period - config.unit - config.warmup;
+    const uint64_t measure_start = config.period - config.unit;
+    while (n > 0) {
+        uint64_t phase = position % config.period;
+        uint64_t end = phase < warm_start ? warm_start : phase < measure_start ? measure_start : config.period;
+        size_t take = (size_t) std::min<uint64_t>(n, end - phase);
+        if (phase >= warm_start) {
+            if (phase == measure_start) {
+                unit_misses = sampled_cache->total_misses();
+            }
+            sampled_cache->access_batch(records, take);
+            num_simulated += take;
+            if (phase + take == config.period) {
+                Sample sample = {config.unit, sampled_cache->total_misses() - unit_misses};
+                samples.push_back(sample);
+            }
+        }
+        position += take;
+        records += take;
+        n -= take;
+    }
+}
+
+/**
+ * Prints the sample sizes and the estimated miss rate with its 95%
+ * confidence interval.
+ *
+ * @param out the stream to print to
+ */
+void Sampled_Simulator::print_stats(std::ostream &out) const {
+    double accesses = 0, misses = 0;
+    for (const Sample &sample : samples) {
+        accesses += sample.accesses;
+        misses += sample.misses;
+    }
+    const double n = samples.size();
+    const double rate = accesses > 0 ? misses / accesses : 0.0;
+    // variance of the ratio estimator over the samples, corrected for the
+    // fraction of the population that was sampled
+    double spread = 0;
+    for (const Sample &sample : samples) {
+        double residual = sample.misses - rate * sample.accesses;
+        spread += residual * residual;
+    }
+    const double fraction = config.kind == SAMPLE_SETS ? n / num_sets : (double) config.unit / config.period;
+    const double mean_accesses = n > 0 ? accesses / n : 0.0;
+
+    if (config.kind == SAMPLE_SETS) {
+        out << "Sampling: 1 in " << config.set_ratio << " sets (" << samples.size() << " of " << num_sets
+            << " sets)\n";
+    } else {
+        out << "Sampling: " << config.unit << " of every " << config.period << " accesses after "
+            << config.warmup << " warming\n";
+    }
+    std::ios::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "Total accesses: " << num_accesses << "\n";
+    out << "Simulated accesses: " << num_simulated << std::fixed << std::setprecision(2) << " ("
+        << (num_accesses > 0 ? 100.0 * num_simulated / num_accesses : 0.0) << "%)\n";
+    out << "Measured accesses: " << (uint64_t) accesses << "\n";
+    out << "Samples: " << samples.size() << "\n";
+    out << std::setprecision(4) << "Estimated miss rate: " << 100.0 * rate << "%";
+    if (n >= 2 && mean_accesses > 0) {
+        double standard_error = std::sqrt((1.0 - fraction) * spread / (n - 1) / n) / mean_accesses;
+        out << " +- " << 100.0 * Z_95 * standard_error << "% (95% confidence)\n";
+    } else {
+        out << " (too few samples for a confidence interval)\n";
+    }
+    out << "Estimated misses: " << std::setprecision(0) << rate * num_accesses << "\n";
+    out.flags(flags);
+    out.precision(precision);
+}
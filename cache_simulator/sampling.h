@@ -0,0 +1,138 @@
+/*
+ * h file for sampled cache simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef SAMPLING_H
+#define SAMPLING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cache_config.h"
+#include "cache_simulator.h"
+#include "trace.h"
+
+/*
+ * How a sampled run picks the accesses it simulates.
+ *
+ *   sets  only n_sets / set_ratio sets are simulated (Kessler, Hill and
+ *         Wood, "A comparison of trace-sampling techniques"), in a cache of
+ *         that many sets; accesses to other sets are skipped. The sets are
+ *         picked at random with a fixed seed rather than every set_ratio-th,
+ *         which would line up with power-of-2 strides in the trace
+ *   time  in every period of accesses the last unit are measured, after
+ *         warmup accesses that only update the cache (functional warming, as
+ *         in SMARTS); the rest of the period is skipped. Only a warmup of the
+ *         whole gap, period - unit, keeps the cache state exact
+ */
+enum Sampling_Kind {
+    SAMPLE_SETS,
+    SAMPLE_TIME
+};
+
+struct Sampling_Config {
+    Sampling_Kind kind;
+    unsigned set_ratio;           // sets
+    uint64_t unit, period, warmup; // time
+};
+
+/**
+ * Parses a set sampling ratio n (simulate 1 in n sets), e.g. "16".
+ *
+ * @return false if the ratio is not a number, otherwise config is set
+ */
+bool parse_set_sampling(const std::string &spec, Sampling_Config &config, std::string &error);
+
+/**
+ * Parses a time sampling spec unit:period[:warmup], e.g. "1000:100000:10000".
+ * The warmup defaults to a tenth of the gap, (period - unit) / 10; a warmup
+ * of the whole gap keeps the cache state exact but simulates every access.
+ *
+ * @return false if the spec is malformed, otherwise config is set
+ */
+bool parse_time_sampling(const std::string &spec, Sampling_Config &config, std::string &error);
+
+/*
+ * Runs a trace through a cache, simulating only a sample of it, and
+ * estimates the miss rate of the full run with a 95% confidence interval.
+ *
+ * Each sampled set (or each measured unit) is one sample of a ratio
+ * estimator: the estimate is the sum of the misses over the sum of the
+ * accesses of the samples, and its standard error comes from the spread of
+ * the samples' misses around the estimate, with the finite population
+ * correction for the fraction sampled.
+ */
+class Sampled_Simulator {
+private:
+    struct Sample {
+        uint64_t accesses, misses;
+    };
+
+    Sampling_Config config;
+    unsigned num_sets; // of the full cache
+    std::unique_ptr<Cache_Simulator> sampled_cache;
+    // sets: address decoding of the full cache, and the set of the smaller
+    // cache each set maps to (-1 if it is not sampled)
+    unsigned offset_bits, index_bits, ratio_bits;
+    std::vector<int32_t> sampled_set;
+    // time
+    uint64_t position, unit_misses;
+    uint64_t num_accesses, num_simulated;
+    std::vector<Sample> samples; // one per sampled set or measured unit
+
+    void access_sets(const Trace_Record *records, size_t n);
+    void access_time(const Trace_Record *records, size_t n);
+
+    Sampled_Simulator(const Sampled_Simulator &);
+    Sampled_Simulator &operator=(const Sampled_Simulator &);
+
+public:
+    /**
+     * @param cache the configuration of the full cache
+     * @param config how to sample
+     */
+    Sampled_Simulator(const Cache_Config &cache, const Sampling_Config &config);
+
+    /**
+     * Checks that a sampling configuration fits a cache.
+     *
+     * @return false if it does not, otherwise error is untouched
+     */
+    static bool validate(const Cache_Config &cache, const Sampling_Config &config, std::string &error);
+
+    /**
+     * @return the simulated cache, to attach models to (time sampling only)
+     */
+    Cache_Simulator &cache() { return *sampled_cache; }
+
+    /**
+     * Runs a batch of decoded trace records, simulating the sampled ones.
+     *
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Not supported (OPT is rejected, its next-use index would count the
+     * skipped accesses); present so the simulator can be driven like a
+     * Cache_Simulator.
+     */
+    void set_next_use(const uint64_t *, uint64_t) { }
+
+    unsigned block_offset_bits() const { return offset_bits; }
+
+    /**
+     * Prints the sample sizes and the estimated miss rate with its 95%
+     * confidence interval.
+     *
+     * @param out the stream to print to
+     */
+    void print_stats(std::ostream &out) const;
+};
+
+#endif //SAMPLING_H
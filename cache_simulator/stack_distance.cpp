@@ -0,0 +1,174 @@
+/*
+ * C++ implementation of LRU stack distance profiling
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include "stack_distance.h"
+
+namespace {
+
+unsigned log2_of(unsigned x) {
+    unsigned bits = 0;
+    while ((1U << bits) < x) {
+        bits++;
+    }
+    return bits;
+}
+
+}
+
+/**
+ * @param sets number of sets, a power of 2
+ * @param block_bytes block size, a power of 2
+ * @param max_ways the largest associativity of interest
+ */
+Set_Stack_Profiler::Set_Stack_Profiler(unsigned sets, unsigned block_bytes, unsigned max_ways)
+    : offset_bits(log2_of(block_bytes)), index_bits(log2_of(sets)), max_ways(max_ways) {
+    stacks.assign((size_t) sets * max_ways, 0);
+    depths.assign(sets, 0);
+    histogram.assign(max_ways + 1, 0);
+}
+
+/**
+ * Records a batch of accesses.
+ */
+void Set_Stack_Profiler::access_batch(const Trace_Record *records, size_t n) {
+    const uint64_t index_mask = (uint64_t(1) << index_bits) - 1;
+    for (size_t i = 0; i < n; i++) {
+        uint64_t block = records[i].address >> offset_bits;
+        uint32_t index = block & index_mask;
+        uint64_t *stack = &stacks[(size_t) index * max_ways];
+        uint32_t depth = depths[index];
+        uint32_t distance = 0;
+        while (distance < depth && stack[distance] != block) {
+            distance++;
+        }
+        histogram[distance < depth ? distance : max_ways]++;
+        // move (or push) the block to the top; a block pushed off the bottom
+        // is beyond every associativity of interest
+        if (distance == depth) {
+            if (depth < max_ways) {
+                depths[index] = depth + 1;
+            } else {
+                distance = max_ways - 1;
+            }
+        }
+        memmove(stack + 1, stack, distance * sizeof(uint64_t));
+        stack[0] = block;
+    }
+}
+
+/**
+ * @return the number of accesses that hit with the given associativity
+ *         (at most max_ways)
+ */
+uint64_t Set_Stack_Profiler::hits(unsigned ways) const {
+    uint64_t hits = 0;
+    for (unsigned d = 0; d < ways && d < max_ways; d++) {
+        hits += histogram[d];
+    }
+    return hits;
+}
+
+/**
+ * @return the number of recorded accesses
+ */
+uint64_t Set_Stack_Profiler::accesses() const {
+    uint64_t accesses = 0;
+    for (uint64_t count : histogram) {
+        accesses += count;
+    }
+    return accesses;
+}
+
+/**
+ * @param block_bytes block size, a power of 2
+ */
+Lru_Stack_Profiler::Lru_Stack_Profiler(unsigned block_bytes)
+    : offset_bits(log2_of(block_bytes)), total(0), clock(1), cold(0) {
+    tree.assign((1 << 20) + 1, 0);
+    histogram.assign(65, 0);
+}
+
+void Lru_Stack_Profiler::add(uint64_t time, int delta) {
+    for (; time < tree.size(); time += time & (~time + 1)) {
+        tree[time] += delta;
+    }
+}
+
+uint64_t Lru_Stack_Profiler::prefix(uint64_t time) const {
+    uint64_t sum = 0;
+    for (; time > 0; time -= time & (~time + 1)) {
+        sum += tree[time];
+    }
+    return sum;
+}
+
+/**
+ * Renumbers the latest accesses 1..footprint in order, so the tree only has to
+ * cover live blocks, and rebuilds it with room for as many accesses again.
+ */
+void Lru_Stack_Profiler::compact() {
+    std::vector<std::pair<uint64_t, uint64_t>> live; // (time, block)
+    live.reserve(last_use.size());
+    for (auto &entry : last_use) {
+        live.push_back(std::make_pair(entry.second, entry.first));
+    }
+    std::sort(live.begin(), live.end());
+    tree.assign(std::max<size_t>(2 * live.size(), 1 << 20) + 1, 0);
+    for (size_t i = 0; i < live.size(); i++) {
+        last_use[live[i].second] = i + 1;
+        tree[i + 1] = 1;
+    }
+    // linear-time Fenwick construction: push each node into its parent
+    for (uint64_t i = 1; i < tree.size(); i++) {
+        uint64_t parent = i + (i & (~i + 1));
+        if (parent < tree.size()) {
+            tree[parent] += tree[i];
+        }
+    }
+    clock = live.size() + 1;
+}
+
+/**
+ * Records a batch of accesses.
+ */
+void Lru_Stack_Profiler::access_batch(const Trace_Record *records, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        if (clock == tree.size()) {
+            compact();
+        }
+        uint64_t block = records[i].address >> offset_bits;
+        auto inserted = last_use.insert(std::make_pair(block, clock));
+        if (inserted.second) {
+            cold++;
+        } else {
+            // distinct blocks touched since the last access: marks after it
+            uint64_t previous = inserted.first->second;
+            uint64_t distance = prefix(clock - 1) - prefix(previous);
+            histogram[distance == 0 ? 0 : 64 - __builtin_clzll(distance)]++;
+            add(previous, -1);
+            inserted.first->second = clock;
+        }
+        add(clock, 1);
+        clock++;
+        total++;
+    }
+}
+
+/**
+ * @return the number of accesses that hit in a fully associative cache of
+ *         the given number of blocks, a power of 2
+ */
+uint64_t Lru_Stack_Profiler::hits(uint64_t blocks) const {
+    // distance d hits iff d < blocks, i.e. its bucket is at most log2(blocks)
+    unsigned last = 64 - __builtin_clzll(blocks) - 1;
+    uint64_t hits = 0;
+    for (unsigned k = 0; k <= last && k < histogram.size(); k++) {
+        hits += histogram[k];
+    }
+    return hits;
+}
@@ -0,0 +1,104 @@
+/*
+ * h file for LRU stack distance profiling
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef STACK_DISTANCE_H
+#define STACK_DISTANCE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "trace.h"
+
+/*
+ * LRU has the inclusion property: an access hits in an A-way set exactly when
+ * fewer than A other blocks of its set were touched since the block's last
+ * access (its stack distance). One pass that records the distance of every
+ * access therefore yields the hits and misses of every associativity at once.
+ *
+ * Set_Stack_Profiler keeps a Mattson stack per set, cut off at max_ways, for
+ * one (sets, block size) geometry; finding a block is a scan of at most
+ * max_ways tags. Lru_Stack_Profiler is the fully associative, unbounded case:
+ * the distance is the number of distinct blocks touched since the last access,
+ * counted with a Fenwick tree over access times (O(log n) per access).
+ *
+ * Stores are treated as loads (write-allocate), so the counts match csim with
+ * lru and write-allocate under either write policy.
+ */
+class Set_Stack_Profiler {
+private:
+    unsigned offset_bits, index_bits, max_ways;
+    std::vector<uint64_t> stacks;   // per set, most recent block first
+    std::vector<uint32_t> depths;   // per set, number of blocks on the stack
+    std::vector<uint64_t> histogram; // histogram[d] accesses at distance d, d == max_ways: beyond
+
+public:
+    /**
+     * @param sets number of sets, a power of 2
+     * @param block_bytes block size, a power of 2
+     * @param max_ways the largest associativity of interest
+     */
+    Set_Stack_Profiler(unsigned sets, unsigned block_bytes, unsigned max_ways);
+
+    /**
+     * Records a batch of accesses.
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * @return the number of accesses that hit with the given associativity
+     *         (at most max_ways)
+     */
+    uint64_t hits(unsigned ways) const;
+
+    /**
+     * @return the number of recorded accesses
+     */
+    uint64_t accesses() const;
+};
+
+class Lru_Stack_Profiler {
+private:
+    unsigned offset_bits;
+    uint64_t total;                                  // accesses recorded
+    uint64_t clock;                                  // time of the next access, renumbered by compact()
+    std::unordered_map<uint64_t, uint64_t> last_use; // block -> time of its latest access
+    std::vector<uint32_t> tree;                      // Fenwick tree, 1 at the latest access of each block
+    std::vector<uint64_t> histogram;                 // histogram[0] distance 0, histogram[k] distance in [2^(k-1), 2^k)
+    uint64_t cold;                                   // first accesses (infinite distance)
+
+    void add(uint64_t time, int delta);
+    uint64_t prefix(uint64_t time) const;
+    void compact();
+
+public:
+    /**
+     * @param block_bytes block size, a power of 2
+     */
+    Lru_Stack_Profiler(unsigned block_bytes);
+
+    /**
+     * Records a batch of accesses.
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * @return the number of accesses that hit in a fully associative cache of
+     *         the given number of blocks, a power of 2
+     */
+    uint64_t hits(uint64_t blocks) const;
+
+    /**
+     * @return the number of recorded accesses
+     */
+    uint64_t accesses() const { return total; }
+
+    /**
+     * @return the number of distinct blocks seen
+     */
+    uint64_t footprint() const { return last_use.size(); }
+};
+
+#endif //STACK_DISTANCE_H
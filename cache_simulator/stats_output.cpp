@@ -0,0 +1,207 @@
+/*
+ * C++ implementation of machine-readable statistics and interval sampling
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <utility>
+#include "stats_output.h"
+
+namespace {
+
+// windows reserved up front; longer runs grow the buffer geometrically
+const size_t RESERVED_SAMPLES = 4096;
+
+double ratio(uint64_t part, uint64_t whole) {
+    return whole > 0 ? (double) part / whole : 0.0;
+}
+
+}
+
+/**
+ * Parses a stats format: text, json or csv.
+ *
+ * @return false if the format is unknown
+ */
+bool parse_stats_format(const std::string &name, Stats_Format &format) {
+    if (name == "text") {
+        format = STATS_TEXT;
+    } else if (name == "json") {
+        format = STATS_JSON;
+    } else if (name == "csv") {
+        format = STATS_CSV;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Writes the configuration and final counters of a cache as JSON or CSV. Both
+ * carry the same fields, and every field is always present (the prefetch
+ * counters are 0 without a prefetcher).
+ *
+ * @param out the stream to write to
+ * @param format STATS_JSON or STATS_CSV
+ * @param config the configuration of the cache
+ * @param counters its counters
+ */
+void write_stats(std::ostream &out, Stats_Format format, const Cache_Config &config, const Cache_Counters &counters) {
+    uint64_t accesses = counters.loads + counters.stores;
+    uint64_t hits = counters.load_hits + counters.store_hits;
+    std::ostringstream hit_rate;
+    hit_rate << std::fixed << std::setprecision(6) << ratio(hits, accesses);
+    const std::vector<std::pair<const char *, std::string>> fields = {
+        {"sets", std::to_string(config.n_sets)},
+        {"blocks_per_set", std::to_string(config.n_blocks_per_set)},
+        {"bytes_per_block", std::to_string(config.n_bytes_per_block)},
+        {"write_allocate", config.is_write_allocate ? "true" : "false"},
+        {"write_through", config.is_write_through ? "true" : "false"},
+        {"policy", std::string("\"") + replacement_policy_name(config.policy) + "\""},
+        {"loads", std::to_string(counters.loads)},
+        {"stores", std::to_string(counters.stores)},
+        {"load_hits", std::to_string(counters.load_hits)},
+        {"load_misses", std::to_string(counters.load_misses)},
+        {"store_hits", std::to_string(counters.store_hits)},
+        {"store_misses", std::to_string(counters.store_misses)},
+        {"hit_rate", hit_rate.str()},
+        {"cycles", std::to_string(counters.cycles)},
+        {"dirty_evictions", std::to_string(counters.writebacks)},
+        {"prefetches", std::to_string(counters.prefetches)},
+        {"prefetch_fills", std::to_string(counters.prefetch_fills)},
+        {"useful_prefetches", std::to_string(counters.useful_prefetches)},
+        {"victim_hits", std::to_string(counters.victim_hits)},
+        {"buffered_writes", std::to_string(counters.buffered_writes)},
+        {"coalesced_writes", std::to_string(counters.coalesced_writes)},
+        {"write_stalls", std::to_string(counters.write_stalls)},
+        {"write_stall_cycles", std::to_string(counters.write_stall_cycles)},
+    };
+    if (format == STATS_JSON) {
+        out << "{\n";
+        for (size_t i = 0; i < fields.size(); i++) {
+            out << "  \"" << fields[i].first << "\": " << fields[i].second << (i + 1 < fields.size() ? ",\n" : "\n");
+        }
+        out << "}\n";
+        return;
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        out << fields[i].first << (i + 1 < fields.size() ? "," : "\n");
+    }
+    for (size_t i = 0; i < fields.size(); i++) {
+        std::string value = fields[i].second;
+        value.erase(std::remove(value.begin(), value.end(), '"'), value.end());
+        out << value << (i + 1 < fields.size() ? "," : "\n");
+    }
+}
+
+/**
+ * @param cache the cache to run
+ * @param interval the number of accesses per window
+ */
+Interval_Sampler::Interval_Sampler(Cache_Simulator &cache, uint64_t interval)
+    : cache(cache), interval(interval), in_window(0), window_fetches(0), last(cache.counters()) {
+    samples.reserve(RESERVED_SAMPLES);
+}
+
+/**
+ * Runs a batch of decoded trace records, closing every window it completes.
+ *
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Interval_Sampler::access_batch(const Trace_Record *records, size_t n) {
+    while (n > 0) {
+        size_t take = (size_t) std::min<uint64_t>(n, interval - in_window);
+        cache.access_batch(records, take);
+        for (size_t i = 0; i < take; i++) {
+            window_fetches += records[i].is_fetch;
+        }
+        in_window += take;
+        records += take;
+        n -= take;
+        if (in_window == interval) {
+            close_window();
+        }
+    }
+}
+
+/**
+ * Closes the last, partial window.
+ */
+void Interval_Sampler::finish() {
+    if (in_window > 0) {
+        close_window();
+    }
+}
+
+/**
+ * Stores the counters of the window that just ended and starts the next.
+ */
+void Interval_Sampler::close_window() {
+    Cache_Counters now = cache.counters();
+    Sample sample;
+    sample.accesses = in_window;
+    sample.fetches = window_fetches;
+    sample.hits = (now.load_hits + now.store_hits) - (last.load_hits + last.store_hits);
+    sample.misses = (now.load_misses + now.store_misses) - (last.load_misses + last.store_misses);
+    sample.cycles = now.cycles - last.cycles;
+    sample.writebacks = now.writebacks - last.writebacks;
+    samples.push_back(sample);
+    last = now;
+    in_window = 0;
+    window_fetches = 0;
+}
+
+/**
+ * Writes the samples to a file: a JSON object if path ends in .json,
+ * otherwise CSV with one row per window.
+ *
+ * @return false if the file cannot be written, with error set
+ */
+bool Interval_Sampler::write(const std::string &path, std::string &error) const {
+    std::ofstream out(path);
+    if (!out) {
+        error = "could not create " + path + ".";
+        return false;
+    }
+    bool per_instruction = false;
+    for (const Sample &sample : samples) {
+        per_instruction = per_instruction || sample.fetches > 0;
+    }
+    const bool json = path.size() >= 5 && path.compare(path.size() - 5, 5, ".json") == 0;
+    out << std::fixed << std::setprecision(6);
+    if (json) {
+        out << "{\n  \"interval\": " << interval << ",\n  \"mpki_basis\": \""
+            << (per_instruction ? "instructions" : "accesses") << "\",\n  \"samples\": [";
+    } else {
+        out << "window,first_access,accesses,hits,misses,hit_rate,mpki,cycles,dirty_evictions\n";
+    }
+    uint64_t first = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        const Sample &s = samples[i];
+        double hit_rate = ratio(s.hits, s.accesses);
+        double mpki = 1000.0 * ratio(s.misses, per_instruction ? s.fetches : s.accesses);
+        if (json) {
+            out << (i > 0 ? ",\n" : "\n") << "    {\"window\": " << i << ", \"first_access\": " << first
+                << ", \"accesses\": " << s.accesses << ", \"hits\": " << s.hits << ", \"misses\": " << s.misses
+                << ", \"hit_rate\": " << hit_rate << ", \"mpki\": " << mpki << ", \"cycles\": " << s.cycles
+                << ", \"dirty_evictions\": " << s.writebacks << "}";
+        } else {
+            out << i << "," << first << "," << s.accesses << "," << s.hits << "," << s.misses << "," << hit_rate
+                << "," << mpki << "," << s.cycles << "," << s.writebacks << "\n";
+        }
+        first += s.accesses;
+    }
+    if (json) {
+        out << "\n  ]\n}\n";
+    }
+    out.flush();
+    if (!out) {
+        error = "could not write " + path + ".";
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+/*
+ * h file for machine-readable statistics and interval sampling
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef STATS_OUTPUT_H
+#define STATS_OUTPUT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "cache_config.h"
+#include "cache_simulator.h"
+#include "trace.h"
+
+enum Stats_Format {
+    STATS_TEXT, // print_stats()
+    STATS_JSON, // one object
+    STATS_CSV   // a header row and one row of values
+};
+
+/**
+ * Parses a stats format: text, json or csv.
+ *
+ * @return false if the format is unknown
+ */
+bool parse_stats_format(const std::string &name, Stats_Format &format);
+
+/**
+ * Writes the configuration and final counters of a cache as JSON or CSV. Both
+ * carry the same fields, and every field is always present (the prefetch
+ * counters are 0 without a prefetcher).
+ *
+ * @param out the stream to write to
+ * @param format STATS_JSON or STATS_CSV
+ * @param config the configuration of the cache
+ * @param counters its counters
+ */
+void write_stats(std::ostream &out, Stats_Format format, const Cache_Config &config, const Cache_Counters &counters);
+
+/*
+ * Drives a Cache_Simulator like run_trace() does and records its counters
+ * every interval accesses, so phase behaviour can be plotted. Batches are
+ * split at window boundaries; closing a window takes a snapshot of the
+ * counters and stores the difference in a preallocated buffer of fixed-size
+ * samples, so nothing is formatted or allocated while the trace runs.
+ *
+ * MPKI is misses per 1000 instruction fetches (i records) when the trace
+ * has any, otherwise per 1000 accesses.
+ */
+class Interval_Sampler {
+private:
+    struct Sample {
+        uint64_t accesses, fetches, hits, misses, cycles, writebacks;
+    };
+
+    Cache_Simulator &cache;
+    uint64_t interval, in_window, window_fetches;
+    Cache_Counters last;
+    std::vector<Sample> samples;
+
+    void close_window();
+
+public:
+    /**
+     * @param cache the cache to run
+     * @param interval the number of accesses per window
+     */
+    Interval_Sampler(Cache_Simulator &cache, uint64_t interval);
+
+    /**
+     * Runs a batch of decoded trace records, closing every window it completes.
+     *
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    void set_next_use(const uint64_t *next_use, uint64_t length) { cache.set_next_use(next_use, length); }
+
+    unsigned block_offset_bits() const { return cache.block_offset_bits(); }
+
+    /**
+     * Closes the last, partial window.
+     */
+    void finish();
+
+    /**
+     * Writes the samples to a file: a JSON object if path ends in .json,
+     * otherwise CSV with one row per window.
+     *
+     * @return false if the file cannot be written, with error set
+     */
+    bool write(const std::string &path, std::string &error) const;
+
+private:
+    Interval_Sampler(const Interval_Sampler &);
+    Interval_Sampler &operator=(const Interval_Sampler &);
+};
+
+#endif //STATS_OUTPUT_H
@@ -0,0 +1,186 @@
+/*
+ * Single-pass LRU cache size sweep: prints the miss-ratio curve of every
+ * geometry as CSV
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "decompress.h"
+#include "stack_distance.h"
+#include "trace.h"
+#include "trace_stream.h"
+
+namespace {
+
+bool is_power_of_2(unsigned long x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+void usage() {
+    std::cerr << "Usage: csim_sweep [-b block_bytes[,block_bytes...]] [-s max_sets] [-w max_ways]\n"
+              << "                  [-c max_capacity_bytes] [trace]\n"
+              << "  -b  block sizes to sweep (default 64)\n"
+              << "  -s  largest number of sets of the set-associative curves (default 4096)\n"
+              << "  -w  largest associativity of the set-associative curves (default 16)\n"
+              << "  -c  largest fully associative capacity (default 67108864)\n"
+              << "The trace (text, possibly gzip/zstd/lz4 compressed, or binary) is read from\n"
+              << "standard input if not given.\n";
+}
+
+/*
+ * Every profiler of one block size.
+ */
+struct Block_Size_Profile {
+    unsigned block_bytes;
+    Lru_Stack_Profiler fully_associative;
+    std::vector<std::unique_ptr<Set_Stack_Profiler>> set_associative; // 2, 4, ... max_sets sets
+
+    Block_Size_Profile(unsigned block_bytes, unsigned max_sets, unsigned max_ways)
+        : block_bytes(block_bytes), fully_associative(block_bytes) {
+        for (unsigned sets = 2; sets <= max_sets; sets *= 2) {
+            set_associative.emplace_back(new Set_Stack_Profiler(sets, block_bytes, max_ways));
+        }
+    }
+
+    void access_batch(const Trace_Record *records, size_t n) {
+        fully_associative.access_batch(records, n);
+        for (auto &profiler : set_associative) {
+            profiler->access_batch(records, n);
+        }
+    }
+};
+
+void print_row(unsigned block_bytes, uint64_t sets, uint64_t ways, uint64_t accesses, uint64_t hits) {
+    uint64_t misses = accesses - hits;
+    std::cout << block_bytes << "," << sets << "," << ways << "," << sets * ways * block_bytes << ","
+              << accesses << "," << hits << "," << misses << ","
+              << std::fixed << std::setprecision(6) << (accesses > 0 ? (double) misses / accesses : 0.0) << "\n";
+}
+
+}
+
+/**
+ * Main function of the sweep. The trace is streamed once through an LRU stack
+ * profiler per geometry, so memory does not grow with the trace length.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of strings containing command line arguments
+ * @return 0 if the sweep ran successfully
+ */
+int main(int argc, char *argv[]) {
+    std::vector<unsigned> block_sizes;
+    unsigned long max_sets = 4096, max_ways = 16, max_capacity = 64UL << 20;
+    int opt;
+    while ((opt = getopt(argc, argv, "b:s:w:c:")) != -1) {
+        switch (opt) {
+        case 'b': {
+            std::stringstream ss(optarg);
+            std::string size;
+            while (std::getline(ss, size, ',')) {
+                block_sizes.push_back(std::strtoul(size.c_str(), nullptr, 10));
+            }
+            break;
+        }
+        case 's':
+            max_sets = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'w':
+            max_ways = std::strtoul(optarg, nullptr, 10);
+            break;
+        case 'c':
+            max_capacity = std::strtoul(optarg, nullptr, 10);
+            break;
+        default:
+            usage();
+            return EXIT_FAILURE;
+        }
+    }
+    if (block_sizes.empty()) {
+        block_sizes.push_back(64);
+    }
+    for (unsigned block_bytes : block_sizes) {
+        if (!is_power_of_2(block_bytes) || block_bytes < 4) {
+            std::cerr << "Error: block size must be a positive power of 2 and at least 4.\n";
+            return EXIT_FAILURE;
+        }
+    }
+    if (!is_power_of_2(max_sets) || !is_power_of_2(max_ways) || !is_power_of_2(max_capacity)) {
+        std::cerr << "Error: sets, ways and capacity must be positive powers of 2.\n";
+        return EXIT_FAILURE;
+    }
+    if (argc - optind > 1) {
+        usage();
+        return EXIT_FAILURE;
+    }
+    const char *path = argc - optind == 1 ? argv[optind] : nullptr;
+
+    std::vector<std::unique_ptr<Block_Size_Profile>> profiles;
+    for (unsigned block_bytes : block_sizes) {
+        profiles.emplace_back(new Block_Size_Profile(block_bytes, max_sets, max_ways));
+    }
+    auto profile = [&](const Trace_Record *records, size_t n) {
+        for (auto &p : profiles) {
+            p->access_batch(records, n);
+        }
+    };
+
+    if (path != nullptr && is_binary_trace(path)) {
+        Trace_File trace;
+        std::string error;
+        if (!trace.open(path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+        std::vector<Trace_Record> chunk(4096);
+        uint64_t next = 0;
+        size_t n;
+        while ((n = trace.decode(next, chunk.size(), chunk.data())) > 0) {
+            profile(chunk.data(), n);
+            next += n;
+        }
+    } else {
+        Decompressed_Input input;
+        std::string error;
+        if (!input.open(path, error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+        Trace_Stream stream(input.fd());
+        const Trace_Record *records;
+        size_t n;
+        while (stream.next(records, n)) {
+            profile(records, n);
+        }
+        if (stream.failed(error) || !input.finish(error)) {
+            std::cerr << "Error: " << error << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    // one row per geometry: the fully associative curve first, then every
+    // associativity of every set count
+    std::cout << "block_bytes,sets,ways,capacity_bytes,accesses,hits,misses,miss_ratio\n";
+    for (auto &p : profiles) {
+        const Lru_Stack_Profiler &fully = p->fully_associative;
+        for (uint64_t ways = 1; ways * p->block_bytes <= max_capacity; ways *= 2) {
+            print_row(p->block_bytes, 1, ways, fully.accesses(), fully.hits(ways));
+        }
+        unsigned sets = 2;
+        for (auto &profiler : p->set_associative) {
+            for (unsigned ways = 1; ways <= max_ways; ways *= 2) {
+                print_row(p->block_bytes, sets, ways, profiler->accesses(), profiler->hits(ways));
+            }
+            sets *= 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+/*
+ * C++ implementation of SIMD tag matching
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include "tag_match.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+/**
+ * Portable kernel, usable for any n up to 64.
+ */
+uint64_t match_tags_scalar(const uint16_t *tags, unsigned n, uint16_t key) {
+    uint64_t match = 0;
+    for (unsigned i = 0; i < n; i++) {
+        match |= uint64_t(tags[i] == key) << i;
+    }
+    return match;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+/**
+ * SSE2 kernel, 8 tags per compare. n must be a multiple of 16.
+ */
+uint64_t match_tags_sse(const uint16_t *tags, unsigned n, uint16_t key) {
+    const __m128i broadcast = _mm_set1_epi16((short) key);
+    uint64_t match = 0;
+    for (unsigned i = 0; i < n; i += 16) {
+        __m128i eq0 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) (tags + i)), broadcast);
+        __m128i eq1 = _mm_cmpeq_epi16(_mm_loadu_si128((const __m128i *) (tags + i + 8)), broadcast);
+        // narrow the 16-bit lanes to bytes so movemask yields one bit per tag
+        uint32_t bits = _mm_movemask_epi8(_mm_packs_epi16(eq0, eq1));
+        match |= uint64_t(bits) << i;
+    }
+    return match;
+}
+
+/**
+ * AVX2 kernel, 16 tags per compare. n must be a multiple of 16.
+ */
+__attribute__((target("avx2")))
+uint64_t match_tags_avx2(const uint16_t *tags, unsigned n, uint16_t key) {
+    const __m256i broadcast = _mm256_set1_epi16((short) key);
+    uint64_t match = 0;
+    unsigned i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i eq0 = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) (tags + i)), broadcast);
+        __m256i eq1 = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) (tags + i + 16)), broadcast);
+        // packs works within 128-bit lanes, so restore tag order across lanes
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(eq0, eq1), 0xd8);
+        uint32_t bits = _mm256_movemask_epi8(packed);
+        match |= uint64_t(bits) << i;
+    }
+    if (i < n) {
+        __m256i eq = _mm256_cmpeq_epi16(_mm256_loadu_si256((const __m256i *) (tags + i)), broadcast);
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi16(eq, eq), 0xd8);
+        uint32_t bits = _mm256_movemask_epi8(packed) & 0xffff;
+        match |= uint64_t(bits) << i;
+    }
+    return match;
+}
+
+#endif
+
+/**
+ * Picks the widest kernel the running CPU supports.
+ *
+ * @param n the number of tags that will be passed to each call
+ * @return the kernel, or the scalar kernel if n is not a multiple of 16
+ */
+Tag_Match_Fn select_tag_match(unsigned n) {
+#if defined(__x86_64__) || defined(__i386__)
+    if (n % 16 == 0) {
+        if (__builtin_cpu_supports("avx2")) {
+            return match_tags_avx2;
+        }
+        return match_tags_sse; // SSE2 is part of every x86-64 CPU
+    }
+#endif
+    (void) n;
+    return match_tags_scalar;
+}
+
+/**
+ * @return the name of the kernel select_tag_match picks for n tags
+ */
+const char *tag_match_name(unsigned n) {
+    Tag_Match_Fn fn = select_tag_match(n);
+#if defined(__x86_64__) || defined(__i386__)
+    if (fn == match_tags_avx2) {
+        return "avx2";
+    }
+    if (fn == match_tags_sse) {
+        return "sse2";
+    }
+#endif
+    return fn == match_tags_scalar ? "scalar" : "unknown";
+}
@@ -0,0 +1,50 @@
+/*
+ * h file for SIMD tag matching
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TAG_MATCH_H
+#define TAG_MATCH_H
+
+#include <cstdint>
+
+/*
+ * Tag match kernels compare up to 64 16-bit partial tags against a key and
+ * return a bitmask with bit i set if tags[i] == key. The cache keeps a partial
+ * (low 16 bits) copy of every tag next to the full tags so that sixteen ways
+ * fit in one AVX2 register; candidate ways are then confirmed against the full
+ * tag.
+ */
+typedef uint64_t (*Tag_Match_Fn)(const uint16_t *tags, unsigned n, uint16_t key);
+
+/**
+ * Portable kernel, usable for any n up to 64.
+ */
+uint64_t match_tags_scalar(const uint16_t *tags, unsigned n, uint16_t key);
+
+#if defined(__x86_64__) || defined(__i386__)
+/**
+ * SSE2 kernel, 8 tags per compare. n must be a multiple of 16.
+ */
+uint64_t match_tags_sse(const uint16_t *tags, unsigned n, uint16_t key);
+
+/**
+ * AVX2 kernel, 16 tags per compare. n must be a multiple of 16.
+ */
+uint64_t match_tags_avx2(const uint16_t *tags, unsigned n, uint16_t key);
+#endif
+
+/**
+ * Picks the widest kernel the running CPU supports.
+ *
+ * @param n the number of tags that will be passed to each call
+ * @return the kernel, or the scalar kernel if n is not a multiple of 16
+ */
+Tag_Match_Fn select_tag_match(unsigned n);
+
+/**
+ * @return the name of the kernel select_tag_match picks for n tags
+ */
+const char *tag_match_name(unsigned n);
+
+#endif //TAG_MATCH_H
@@ -0,0 +1,79 @@
+/*
+ * Micro benchmark of the tag match kernels for 1-way to 1024-way sets
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+#include "tag_match.h"
+
+/**
+ * Looks up every query in its set with the given kernel, 64 ways at a time.
+ *
+ * @return nanoseconds per lookup
+ */
+double time_kernel(Tag_Match_Fn fn, const std::vector<uint16_t> &tags, unsigned ways,
+                   const std::vector<std::pair<uint32_t, uint16_t>> &queries, uint64_t &checksum) {
+    auto start = std::chrono::steady_clock::now();
+    for (auto &query : queries) {
+        const uint16_t *set = &tags[(size_t) query.first * ways];
+        for (unsigned base = 0; base < ways; base += 64) {
+            unsigned n = ways - base < 64 ? ways - base : 64;
+            uint64_t match = fn(set + base, n, query.second);
+            if (match != 0) {
+                checksum += base + __builtin_ctzll(match);
+                break;
+            }
+        }
+    }
+    std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / queries.size();
+}
+
+/**
+ * Main function of the benchmark. Each configuration uses 1M tags split into
+ * sets of the given associativity; half of the queries hit.
+ */
+int main() {
+    const size_t total_tags = 1 << 20;
+    const size_t num_queries = 1 << 21;
+    std::mt19937_64 rng(42);
+    uint64_t checksum = 0;
+
+    std::cout << std::setw(6) << "ways" << std::setw(12) << "scalar ns"
+              << std::setw(12) << "sse2 ns" << std::setw(12) << "avx2 ns" << "\n";
+    for (unsigned ways = 1; ways <= 1024; ways *= 2) {
+        uint32_t sets = total_tags / ways;
+        std::vector<uint16_t> tags(total_tags);
+        for (auto &tag : tags) {
+            tag = (uint16_t) rng();
+        }
+        std::vector<std::pair<uint32_t, uint16_t>> queries(num_queries);
+        for (auto &query : queries) {
+            query.first = rng() % sets;
+            query.second = (rng() & 1) ? tags[(size_t) query.first * ways + rng() % ways] : (uint16_t) rng();
+        }
+
+        std::cout << std::setw(6) << ways << std::fixed << std::setprecision(2)
+                  << std::setw(12) << time_kernel(match_tags_scalar, tags, ways, queries, checksum);
+#if defined(__x86_64__) || defined(__i386__)
+        if (ways % 16 == 0) {
+            std::cout << std::setw(12) << time_kernel(match_tags_sse, tags, ways, queries, checksum);
+            if (__builtin_cpu_supports("avx2")) {
+                std::cout << std::setw(12) << time_kernel(match_tags_avx2, tags, ways, queries, checksum);
+            } else {
+                std::cout << std::setw(12) << "-";
+            }
+        } else {
+            std::cout << std::setw(12) << "-" << std::setw(12) << "-";
+        }
+#endif
+        std::cout << "\n";
+    }
+    std::cout << "selected kernel for 64 ways: " << tag_match_name(64) << " (checksum " << checksum << ")\n";
+    return 0;
+}
@@ -0,0 +1,294 @@
+/*
+ * C++ implementation of TLB and page walk simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include "tlb.h"
+
+namespace {
+
+// page table entries live above every user address: 0xff, the table level
+// (1 to 4) and the 8-byte entry index within that level of a 48-bit table
+const uint64_t PTE_BASE = 0xff00000000000000ULL;
+const unsigned VA_BITS = 48;
+
+bool is_power_of_2(unsigned x) {
+    return x > 0 && (x & (x - 1)) == 0;
+}
+
+bool parse_unsigned(const std::string &text, unsigned &value) {
+    if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+        return false;
+    }
+    unsigned long parsed = std::strtoul(text.c_str(), nullptr, 10);
+    value = (unsigned) parsed;
+    return parsed == value;
+}
+
+bool parse_address(const std::string &text, uint64_t &value) {
+    if (text.empty()) {
+        return false;
+    }
+    char *end;
+    errno = 0;
+    value = std::strtoull(text.c_str(), &end, 16);
+    return *end == '\0' && errno == 0 && text[0] != '-';
+}
+
+/**
+ * @return 0 for a 4K page, 1 for 2M and 2 for 1G
+ */
+unsigned size_code(unsigned page_bits) {
+    return page_bits == PAGE_4K ? 0 : page_bits == PAGE_2M ? 1 : 2;
+}
+
+}
+
+/**
+ * Parses a page size: 4k, 2m or 1g (either case).
+ *
+ * @param page_bits set to log2 of the size
+ * @return false if the size is unknown
+ */
+bool parse_page_size(const std::string &text, unsigned &page_bits) {
+    if (text == "4k" || text == "4K") {
+        page_bits = PAGE_4K;
+    } else if (text == "2m" || text == "2M") {
+        page_bits = PAGE_2M;
+    } else if (text == "1g" || text == "1G") {
+        page_bits = PAGE_1G;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Parses a TLB level given as name:sets:ways:latency[:policy], e.g.
+ * "dtlb:16:4:1" or "stlb:128:8:7:lru". The policy defaults to lru.
+ *
+ * @return false if the specification is malformed, otherwise config is set
+ */
+bool parse_tlb_level_config(const std::string &spec, Tlb_Level_Config &config, std::string &error) {
+    std::vector<std::string> fields;
+    std::stringstream ss(spec);
+    std::string field;
+    while (std::getline(ss, field, ':')) {
+        fields.push_back(field);
+    }
+    if (fields.size() < 4 || fields.size() > 5 || fields[0].empty()) {
+        error = "TLB level must be name:sets:ways:latency[:policy]: " + spec;
+        return false;
+    }
+    config.name = fields[0];
+    if (!parse_unsigned(fields[1], config.sets) || !parse_unsigned(fields[2], config.ways)
+        || !parse_unsigned(fields[3], config.latency)) {
+        error = "invalid number in TLB level " + spec;
+        return false;
+    }
+    config.policy = POLICY_LRU;
+    if (fields.size() > 4 && !parse_replacement_policy(fields[4], config.policy)) {
+        error = "invalid eviction policy in TLB level " + spec;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Reads ranges from a file, one "start end size" per line with start and
+ * end (exclusive) in hex, e.g. "0x7f0000000000 0x7f0040000000 2m". Blank
+ * lines and lines starting with # are ignored.
+ *
+ * @return false if the file cannot be read or a line is invalid
+ */
+bool Page_Map::load(const char *path, std::string &error) {
+    std::ifstream in(path);
+    if (!in) {
+        error = "could not open page map " + std::string(path) + ".";
+        return false;
+    }
+    std::string line;
+    unsigned line_number = 0;
+    while (std::getline(in, line)) {
+        line_number++;
+        std::istringstream fields(line);
+        std::string start, end, size, extra;
+        if (!(fields >> start) || start[0] == '#') {
+            continue;
+        }
+        Range range;
+        std::ostringstream where;
+        where << path << ":" << line_number;
+        if (!(fields >> end >> size) || (fields >> extra) || !parse_address(start, range.start)
+            || !parse_address(end, range.end) || !parse_page_size(size, range.page_bits)) {
+            error = "page map line must be \"start end 4k|2m|1g\" at " + where.str() + ".";
+            return false;
+        }
+        uint64_t mask = (uint64_t(1) << range.page_bits) - 1;
+        if (range.end <= range.start || (range.start & mask) != 0 || (range.end & mask) != 0) {
+            error = "page map range is empty or not aligned to its page size at " + where.str() + ".";
+            return false;
+        }
+        ranges.push_back(range);
+    }
+    std::sort(ranges.begin(), ranges.end(), [](const Range &a, const Range &b) { return a.start < b.start; });
+    for (size_t i = 1; i < ranges.size(); i++) {
+        if (ranges[i].start < ranges[i - 1].end) {
+            error = "page map ranges overlap in " + std::string(path) + ".";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @return log2 of the size of the page holding address
+ */
+unsigned Page_Map::page_bits(uint64_t address) const {
+    // the last range starting at or below the address
+    auto it = std::upper_bound(ranges.begin(), ranges.end(), address,
+                               [](uint64_t a, const Range &range) { return a < range.start; });
+    if (it != ranges.begin() && address < (it - 1)->end) {
+        return (it - 1)->page_bits;
+    }
+    return default_bits;
+}
+
+/**
+ * @param configs the TLB levels, top to bottom
+ * @param pages the page size of every address
+ * @param cache the data cache behind the TLB
+ * @param walk_through_cache whether page walk references are loads of the data cache
+ * @param walk_latency cycles per page walk reference when they are not
+ */
+Tlb_Simulator::Tlb_Simulator(const std::vector<Tlb_Level_Config> &configs, const Page_Map &pages,
+                             Cache_Simulator &cache, bool walk_through_cache, unsigned walk_latency)
+    : pages(pages), cache(cache), walk_through_cache(walk_through_cache), walk_latency(walk_latency), walks(0),
+      walk_references(0), translation_cycles(0) {
+    for (const Tlb_Level_Config &config : configs) {
+        std::unique_ptr<Level> level(new Level());
+        level->config = config;
+        // one 4-byte "block" per translation (see translate)
+        level->entries.reset(new Cache_Simulator(config.sets, config.ways, 4, true, false, config.policy));
+        level->lookups = level->hits = 0;
+        levels.push_back(std::move(level));
+    }
+    page_accesses[0] = page_accesses[1] = page_accesses[2] = 0;
+}
+
+/**
+ * Checks a TLB configuration.
+ *
+ * @return false if it is invalid, otherwise error is untouched
+ */
+bool Tlb_Simulator::validate(const std::vector<Tlb_Level_Config> &configs, std::string &error) {
+    for (const Tlb_Level_Config &config : configs) {
+        if (!is_power_of_2(config.sets) || !is_power_of_2(config.ways)) {
+            error = "number of sets and entries in each set of " + config.name + " must be positive powers of 2";
+            return false;
+        }
+        if (config.policy == POLICY_OPT) {
+            error = "TLB level " + config.name + " does not support opt";
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Translates one address: looks it up in every level until one hits, walks
+ * the page table if none does, and fills the levels that missed.
+ */
+void Tlb_Simulator::translate(uint64_t address) {
+    const unsigned page_bits = pages.page_bits(address);
+    const unsigned code = size_code(page_bits);
+    page_accesses[code]++;
+    // the page number, tagged with the page size in the top bits, as the
+    // address of a 4-byte block: the set index comes from the low page bits
+    const uint64_t key = (uint64_t(code) << 60) | ((address >> page_bits) << 2);
+
+    size_t hit_level = levels.size();
+    for (size_t i = 0; i < levels.size(); i++) {
+        Level &level = *levels[i];
+        level.lookups++;
+        level.entries->inc_timer();
+        translation_cycles += level.config.latency;
+        if (level.entries->probe(key, false)) {
+            level.hits++;
+            hit_level = i;
+            break;
+        }
+    }
+
+    if (hit_level == levels.size()) {
+        // one reference per table level down to the leaf: 4 for a 4K page,
+        // 3 for 2M (the PDE is the leaf) and 2 for 1G (the PDPTE is)
+        walks++;
+        const uint64_t va = address & ((uint64_t(1) << VA_BITS) - 1);
+        const unsigned depth = 4 - (page_bits - PAGE_4K) / 9;
+        for (unsigned k = 1; k <= depth; k++) {
+            uint64_t entry = va >> (VA_BITS - 9 * k);
+            uint64_t pte = PTE_BASE | (uint64_t(k) << VA_BITS) | (entry << 3);
+            walk_references++;
+            if (walk_through_cache) {
+                cache.load(pte);
+                cache.inc_timer();
+            } else {
+                translation_cycles += walk_latency;
+            }
+        }
+    }
+
+    Cache_Block victim;
+    for (size_t i = 0; i < hit_level; i++) {
+        levels[i]->entries->insert(key, false, victim);
+    }
+}
+
+/**
+ * Translates and then runs a batch of decoded trace records through the cache.
+ *
+ * @param records the records to process
+ * @param n the number of records
+ */
+void Tlb_Simulator::access_batch(const Trace_Record *records, size_t n) {
+    if (!walk_through_cache) {
+        for (size_t i = 0; i < n; i++) {
+            translate(records[i].address);
+        }
+        cache.access_batch(records, n);
+        return;
+    }
+    // the walk's loads must reach the cache before the access they translate
+    for (size_t i = 0; i < n; i++) {
+        translate(records[i].address);
+        cache.access_batch(records + i, 1);
+    }
+}
+
+/**
+ * Prints the counters of the data cache, then of every TLB level, the
+ * page walks and the cycles including translation.
+ */
+void Tlb_Simulator::print_stats() const {
+    cache.print_stats();
+    for (const std::unique_ptr<Level> &level : levels) {
+        const std::string &name = level->config.name;
+        std::cout << name << " lookups: " << level->lookups << "\n";
+        std::cout << name << " hits: " << level->hits << "\n";
+        std::cout << name << " misses: " << level->lookups - level->hits << "\n";
+    }
+    std::cout << "Page walks: " << walks << "\n";
+    std::cout << "Page walk references: " << walk_references << "\n";
+    std::cout << "4K page accesses: " << page_accesses[0] << "\n";
+    std::cout << "2M page accesses: " << page_accesses[1] << "\n";
+    std::cout << "1G page accesses: " << page_accesses[2] << "\n";
+    std::cout << "Translation cycles: " << translation_cycles << "\n";
+    std::cout << "Total cycles with translation: " << cache.total_cycles() + translation_cycles << "\n";
+}
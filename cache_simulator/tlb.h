@@ -0,0 +1,170 @@
+/*
+ * h file for TLB and page walk simulation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TLB_H
+#define TLB_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "cache_simulator.h"
+#include "replacement_policy.h"
+#include "trace.h"
+
+/*
+ * Page sizes of x86-64 4-level paging, as log2 of the size.
+ */
+const unsigned PAGE_4K = 12;
+const unsigned PAGE_2M = 21;
+const unsigned PAGE_1G = 30;
+
+/**
+ * Parses a page size: 4k, 2m or 1g (either case).
+ *
+ * @param page_bits set to log2 of the size
+ * @return false if the size is unknown
+ */
+bool parse_page_size(const std::string &text, unsigned &page_bits);
+
+/*
+ * Configuration of one TLB level. Levels are listed top (looked up first) to
+ * bottom. Each level holds translations of every page size.
+ */
+struct Tlb_Level_Config {
+    std::string name;
+    unsigned sets, ways;
+    unsigned latency; // cycles for a lookup in this level
+    Replacement_Policy policy;
+};
+
+/**
+ * Parses a TLB level given as name:sets:ways:latency[:policy], e.g.
+ * "dtlb:16:4:1" or "stlb:128:8:7:lru". The policy defaults to lru.
+ *
+ * @return false if the specification is malformed, otherwise config is set
+ */
+bool parse_tlb_level_config(const std::string &spec, Tlb_Level_Config &config, std::string &error);
+
+/*
+ * The page size backing each virtual address: a default size, overridden by
+ * address ranges, e.g. the heap mapped with 2M pages.
+ */
+class Page_Map {
+private:
+    struct Range {
+        uint64_t start, end; // [start, end), aligned to the page size
+        unsigned page_bits;
+    };
+
+    unsigned default_bits;
+    std::vector<Range> ranges; // sorted, not overlapping
+
+public:
+    Page_Map() : default_bits(PAGE_4K) { }
+
+    /**
+     * Sets the page size of addresses outside every range.
+     */
+    void set_default(unsigned page_bits) { default_bits = page_bits; }
+
+    /**
+     * Reads ranges from a file, one "start end size" per line with start and
+     * end (exclusive) in hex, e.g. "0x7f0000000000 0x7f0040000000 2m". Blank
+     * lines and lines starting with # are ignored.
+     *
+     * @return false if the file cannot be read or a line is invalid
+     */
+    bool load(const char *path, std::string &error);
+
+    /**
+     * @return log2 of the size of the page holding address
+     */
+    unsigned page_bits(uint64_t address) const;
+};
+
+/*
+ * A multi-level TLB and a radix page table walker in front of a
+ * Cache_Simulator. Every access is translated first: the levels are looked up
+ * top to bottom, paying each level's latency; a miss in every level walks the
+ * page table (4 references for a 4K page, 3 for 2M, 2 for 1G) and fills every
+ * level. Each TLB level is itself a Cache_Simulator whose blocks are
+ * translations, tagged with their page size.
+ *
+ * Page table entries live at synthetic addresses in the top of the address
+ * space, laid out like a real 4-level table, so neighbouring pages share
+ * cache blocks of page table entries. Walk references either cost a fixed
+ * latency each or, with walks through the cache, are loads of the data cache
+ * (and show up in its counters). Translation does not change the address: the
+ * cache is virtually indexed and tagged. Page walk caches are not modelled.
+ */
+class Tlb_Simulator {
+private:
+    struct Level {
+        Tlb_Level_Config config;
+        std::unique_ptr<Cache_Simulator> entries;
+        uint64_t lookups, hits;
+    };
+
+    std::vector<std::unique_ptr<Level>> levels;
+    Page_Map pages;
+    Cache_Simulator &cache;
+    bool walk_through_cache;
+    unsigned walk_latency;
+    uint64_t walks, walk_references, translation_cycles;
+    uint64_t page_accesses[3]; // 4K, 2M, 1G
+
+    void translate(uint64_t address);
+
+public:
+    /**
+     * @param configs the TLB levels, top to bottom
+     * @param pages the page size of every address
+     * @param cache the data cache behind the TLB
+     * @param walk_through_cache whether page walk references are loads of the data cache
+     * @param walk_latency cycles per page walk reference when they are not
+     */
+    Tlb_Simulator(const std::vector<Tlb_Level_Config> &configs, const Page_Map &pages, Cache_Simulator &cache,
+                  bool walk_through_cache, unsigned walk_latency);
+
+    /**
+     * Checks a TLB configuration.
+     *
+     * @return false if it is invalid, otherwise error is untouched
+     */
+    static bool validate(const std::vector<Tlb_Level_Config> &configs, std::string &error);
+
+    /**
+     * Translates and then runs a batch of decoded trace records through the cache.
+     *
+     * @param records the records to process
+     * @param n the number of records
+     */
+    void access_batch(const Trace_Record *records, size_t n);
+
+    /**
+     * Gives the data cache the next-use index of the trace (not supported
+     * with walks through the cache, whose loads are not in the trace).
+     */
+    void set_next_use(const uint64_t *next_use, uint64_t length) { cache.set_next_use(next_use, length); }
+
+    /**
+     * @return log2 of the block size of the data cache
+     */
+    unsigned block_offset_bits() const { return cache.block_offset_bits(); }
+
+    /**
+     * Prints the counters of the data cache, then of every TLB level, the
+     * page walks and the cycles including translation.
+     */
+    void print_stats() const;
+
+private:
+    Tlb_Simulator(const Tlb_Simulator &);
+    Tlb_Simulator &operator=(const Tlb_Simulator &);
+};
+
+#endif //TLB_H
@@ -0,0 +1,444 @@
+/*
+ * C++ implementation of memory trace input and output
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "trace.h"
+
+namespace {
+
+/*
+ * Lookup table from character to hex digit value, 0xff for non-digits.
+ */
+struct Hex_Table {
+    unsigned char value[256];
+
+    Hex_Table() {
+        memset(value, 0xff, sizeof(value));
+        for (int c = '0'; c <= '9'; c++) {
+            value[c] = c - '0';
+        }
+        for (int c = 'a'; c <= 'f'; c++) {
+            value[c] = c - 'a' + 10;
+            value[c - 'a' + 'A'] = c - 'a' + 10;
+        }
+    }
+};
+
+const Hex_Table hex_table;
+
+inline bool is_blank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+inline size_t mask_bytes(uint32_t flags) {
+    return (flags & TRACE_FLAG_FETCH) ? 2 * sizeof(uint64_t) : sizeof(uint64_t);
+}
+
+inline size_t block_bytes(unsigned address_bytes, uint32_t flags) {
+    return mask_bytes(flags) + TRACE_BLOCK_RECORDS * address_bytes;
+}
+
+}
+
+/**
+ * Parses a hexadecimal number with an optional "0x" prefix.
+ *
+ * @param p pointer to the first character, advanced past the number
+ * @param end end of the buffer
+ * @param value set to the parsed value
+ * @return true if at least one hex digit was read and the value fits in 64 bits
+ */
+bool parse_hex(const char *&p, const char *end, uint64_t &value) {
+    if (end - p >= 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X')) {
+        p += 2;
+    }
+    const char *start = p;
+    uint64_t result = 0;
+    bool overflow = false;
+    while (p < end) {
+        unsigned digit = hex_table.value[(unsigned char) *p];
+        if (digit > 0xf) {
+            break;
+        }
+        overflow |= (result >> 60) != 0;
+        result = (result << 4) | digit;
+        p++;
+    }
+    value = result;
+    return p != start && !overflow;
+}
+
+/**
+ * @param keep_pcs whether to parse the third field of each line (otherwise the pc is 0)
+ */
+Text_Trace_Parser::Text_Trace_Parser(bool keep_pcs) : line_number(0), failed(false), keep_pcs(keep_pcs) {
+}
+
+/**
+ * Parses one line without its newline. Blank lines are skipped.
+ */
+bool Text_Trace_Parser::parse_line(const char *begin, const char *end, std::vector<Trace_Record> &out) {
+    line_number++;
+    const char *p = begin;
+    while (p < end && is_blank(*p)) {
+        p++;
+    }
+    if (p == end) {
+        return true; // blank line
+    }
+    // optional core id of a multi-core trace
+    unsigned core = 0;
+    if (*p >= '0' && *p <= '9') {
+        while (p < end && *p >= '0' && *p <= '9') {
+            core = core * 10 + (*p++ - '0');
+            if (core > UINT16_MAX) {
+                return false;
+            }
+        }
+        if (p == end || !is_blank(*p)) {
+            return false;
+        }
+        while (p < end && is_blank(*p)) {
+            p++;
+        }
+        if (p == end) {
+            return false;
+        }
+    }
+    char op = *p++;
+    if (p == end || !is_blank(*p)) {
+        return false;
+    }
+    while (p < end && is_blank(*p)) {
+        p++;
+    }
+    Trace_Record record;
+    if (!parse_hex(p, end, record.address)) {
+        return false;
+    }
+    record.is_store = (op != 'l' && op != 'i');
+    record.is_fetch = (op == 'i');
+    record.core = (uint16_t) core;
+    // the optional third field, for miss attribution (the simulator does not
+    // use the access size found there otherwise); anything but a hex number
+    // (or nothing) leaves the pc at 0
+    record.pc = 0;
+    if (keep_pcs) {
+        while (p < end && is_blank(*p)) {
+            p++;
+        }
+        if (p == end || !parse_hex(p, end, record.pc)) {
+            record.pc = 0;
+        }
+    }
+    out.push_back(record);
+    return true;
+}
+
+/**
+ * Parses every complete line in [begin, end) and appends the records to out.
+ *
+ * @return false if a malformed line was found (see error_line())
+ */
+bool Text_Trace_Parser::parse(const char *begin, const char *end, std::vector<Trace_Record> &out) {
+    if (failed) {
+        return false;
+    }
+    const char *p = begin;
+    // finish the line that was split at the end of the previous piece
+    if (!partial.empty()) {
+        const char *newline = (const char *) memchr(p, '\n', end - p);
+        if (newline == nullptr) {
+            partial.append(p, end);
+            return true;
+        }
+        partial.append(p, newline);
+        if (!parse_line(partial.data(), partial.data() + partial.size(), out)) {
+            failed = true;
+            return false;
+        }
+        partial.clear();
+        p = newline + 1;
+    }
+    while (p < end) {
+        const char *newline = (const char *) memchr(p, '\n', end - p);
+        if (newline == nullptr) {
+            partial.assign(p, end);
+            break;
+        }
+        if (!parse_line(p, newline, out)) {
+            failed = true;
+            return false;
+        }
+        p = newline + 1;
+    }
+    return true;
+}
+
+/**
+ * Parses a final line that was not terminated by a newline.
+ *
+ * @return false if it was malformed
+ */
+bool Text_Trace_Parser::finish(std::vector<Trace_Record> &out) {
+    if (failed) {
+        return false;
+    }
+    bool ok = parse_line(partial.data(), partial.data() + partial.size(), out);
+    partial.clear();
+    failed = !ok;
+    return ok;
+}
+
+/**
+ * Reads a whole text trace from a file descriptor.
+ *
+ * @param fd the file descriptor to read until EOF
+ * @param out the vector the records are appended to
+ * @param error set to a message if the trace could not be read
+ * @param keep_pcs whether to parse the third field of each line
+ * @return true on success
+ */
+bool read_text_trace(int fd, std::vector<Trace_Record> &out, std::string &error, bool keep_pcs) {
+    std::vector<char> buffer(1 << 20);
+    Text_Trace_Parser parser(keep_pcs);
+    while (true) {
+        ssize_t n = read(fd, buffer.data(), buffer.size());
+        if (n < 0) {
+            error = std::string("unable to read trace: ") + strerror(errno);
+            return false;
+        }
+        if (n == 0) {
+            break;
+        }
+        if (!parser.parse(buffer.data(), buffer.data() + n, out)) {
+            error = "malformed trace line " + std::to_string(parser.error_line());
+            return false;
+        }
+    }
+    if (!parser.finish(out)) {
+        error = "malformed trace line " + std::to_string(parser.error_line());
+        return false;
+    }
+    return true;
+}
+
+Trace_File::Trace_File() : data(nullptr), length(0), count(0), address_bytes(0), flags(0) {
+}
+
+Trace_File::~Trace_File() {
+    if (data != nullptr) {
+        munmap((void *) data, length);
+    }
+}
+
+/**
+ * Maps the binary trace at path and validates its header.
+ *
+ * @return true on success, otherwise error is set
+ */
+bool Trace_File::open(const std::string &path, std::string &error) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "unable to open " + path + ": " + strerror(errno);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size < sizeof(Trace_Header)) {
+        ::close(fd);
+        error = path + " is not a binary trace";
+        return false;
+    }
+    void *mapping = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "unable to map " + path + ": " + strerror(errno);
+        return false;
+    }
+    // the simulator streams through the trace once
+    madvise(mapping, st.st_size, MADV_SEQUENTIAL);
+    data = (const unsigned char *) mapping;
+    length = st.st_size;
+
+    Trace_Header header;
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0 || header.version != TRACE_VERSION
+        || (header.address_bytes != 4 && header.address_bytes != 8) || (header.flags & ~TRACE_FLAG_FETCH) != 0) {
+        error = path + " is not a supported binary trace";
+        return false;
+    }
+    uint64_t blocks = (header.count + TRACE_BLOCK_RECORDS - 1) / TRACE_BLOCK_RECORDS;
+    if (length < sizeof(Trace_Header) + blocks * block_bytes(header.address_bytes, header.flags)) {
+        error = path + " is truncated";
+        return false;
+    }
+    count = header.count;
+    address_bytes = header.address_bytes;
+    flags = header.flags;
+    return true;
+}
+
+/**
+ * Decodes up to n records starting at record first.
+ *
+ * @return the number of records written to out
+ */
+size_t Trace_File::decode(uint64_t first, size_t n, Trace_Record *out) const {
+    if (first >= count) {
+        return 0;
+    }
+    if (n > count - first) {
+        n = count - first;
+    }
+    const size_t stride = block_bytes(address_bytes, flags);
+    size_t done = 0;
+    while (done < n) {
+        uint64_t record = first + done;
+        const unsigned char *block = data + sizeof(Trace_Header) + (record / TRACE_BLOCK_RECORDS) * stride;
+        unsigned i = record % TRACE_BLOCK_RECORDS;
+        size_t in_block = TRACE_BLOCK_RECORDS - i;
+        if (in_block > n - done) {
+            in_block = n - done;
+        }
+        uint64_t store_mask, fetch_mask = 0;
+        memcpy(&store_mask, block, sizeof(store_mask));
+        if (flags & TRACE_FLAG_FETCH) {
+            memcpy(&fetch_mask, block + sizeof(store_mask), sizeof(fetch_mask));
+        }
+        const unsigned char *addresses = block + mask_bytes(flags);
+        for (size_t k = 0; k < in_block; k++, i++) {
+            Trace_Record &r = out[done + k];
+            if (address_bytes == 4) {
+                uint32_t address;
+                memcpy(&address, addresses + i * 4, 4);
+                r.address = address;
+            } else {
+                memcpy(&r.address, addresses + i * 8, 8);
+            }
+            r.is_store = (store_mask >> i) & 1;
+            r.is_fetch = (fetch_mask >> i) & 1;
+            r.core = 0;
+            r.pc = 0;
+        }
+        done += in_block;
+    }
+    return n;
+}
+
+/**
+ * Checks whether the file at path starts with the binary trace magic.
+ */
+bool is_binary_trace(const std::string &path) {
+    char magic[sizeof(TRACE_MAGIC)];
+    FILE *file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    bool binary = fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+                  && memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+    fclose(file);
+    return binary;
+}
+
+Trace_Writer::Trace_Writer() : file(nullptr), address_bytes(0), flags(0), count(0), store_mask(0), fetch_mask(0) {
+}
+
+Trace_Writer::~Trace_Writer() {
+    if (file != nullptr) {
+        fclose(file);
+    }
+}
+
+/**
+ * Creates path and writes a provisional header.
+ *
+ * @param address_bytes 4 or 8
+ * @param flags TRACE_FLAG_* bits
+ */
+bool Trace_Writer::open(const std::string &path, unsigned address_bytes, uint32_t flags) {
+    if ((address_bytes != 4 && address_bytes != 8) || (flags & ~TRACE_FLAG_FETCH) != 0) {
+        return false;
+    }
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    this->address_bytes = address_bytes;
+    this->flags = flags;
+    count = 0;
+    store_mask = 0;
+    fetch_mask = 0;
+    memset(block, 0, sizeof(block));
+    Trace_Header header;
+    memset(&header, 0, sizeof(header));
+    return fwrite(&header, sizeof(header), 1, file) == 1;
+}
+
+/**
+ * Appends one record. Fails if the address does not fit in address_bytes,
+ * if it is an instruction fetch and the file has no fetch column, or if it
+ * has a core id (the binary format has no core column).
+ */
+bool Trace_Writer::append(const Trace_Record &record) {
+    if ((address_bytes == 4 && record.address > UINT32_MAX) || (record.is_fetch && !(flags & TRACE_FLAG_FETCH))
+        || record.core != 0) {
+        return false;
+    }
+    unsigned i = count % TRACE_BLOCK_RECORDS;
+    if (address_bytes == 4) {
+        uint32_t address = (uint32_t) record.address;
+        memcpy(block + i * 4, &address, 4);
+    } else {
+        memcpy(block + i * 8, &record.address, 8);
+    }
+    if (record.is_store) {
+        store_mask |= uint64_t(1) << i;
+    }
+    if (record.is_fetch) {
+        fetch_mask |= uint64_t(1) << i;
+    }
+    count++;
+    if (count % TRACE_BLOCK_RECORDS == 0) {
+        return flush_block();
+    }
+    return true;
+}
+
+bool Trace_Writer::flush_block() {
+    bool ok = fwrite(&store_mask, sizeof(store_mask), 1, file) == 1
+              && (!(flags & TRACE_FLAG_FETCH) || fwrite(&fetch_mask, sizeof(fetch_mask), 1, file) == 1)
+              && fwrite(block, address_bytes, TRACE_BLOCK_RECORDS, file) == TRACE_BLOCK_RECORDS;
+    store_mask = 0;
+    fetch_mask = 0;
+    memset(block, 0, sizeof(block));
+    return ok;
+}
+
+/**
+ * Writes the last (padded) block, patches the record count into the header and
+ * closes the file.
+ */
+bool Trace_Writer::close() {
+    bool ok = true;
+    if (count % TRACE_BLOCK_RECORDS != 0) {
+        ok = flush_block();
+    }
+    Trace_Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    header.version = TRACE_VERSION;
+    header.address_bytes = address_bytes;
+    header.count = count;
+    header.flags = flags;
+    ok = ok && fseek(file, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, file) == 1;
+    ok = (fclose(file) == 0) && ok;
+    file = nullptr;
+    return ok;
+}
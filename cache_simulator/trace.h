@@ -0,0 +1,213 @@
+/*
+ * h file for memory trace input and output
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*
+ * One decoded memory access of a trace.
+ */
+struct Trace_Record {
+    uint64_t address;
+    bool is_store;
+    bool is_fetch; // instruction fetch (a load from the instruction side)
+    uint16_t core; // issuing core of a multi-core trace, 0 otherwise
+    uint64_t pc;   // third field of a text trace (the accessing instruction), 0 if absent
+};
+
+/*
+ * Binary trace format. All fields are stored in host (little endian) byte order.
+ *
+ *   header:  Trace_Header
+ *   body:    ceil(count / 64) blocks, each holding 64 records as
+ *              uint64_t store_mask          bit i set if record i is a store
+ *              uint64_t fetch_mask          only with TRACE_FLAG_FETCH: bit i set if
+ *                                           record i is an instruction fetch
+ *              address[64]                  4 or 8 bytes each (address_bytes)
+ *            the last block is padded with zero records.
+ *
+ * Keeping the op bits in a per-block mask keeps records at 4 or 8 bytes each and
+ * lets the address array of a block be read straight out of the mapping.
+ */
+const char TRACE_MAGIC[8] = {'C', 'S', 'I', 'M', 'T', 'R', 'C', '\0'};
+const uint32_t TRACE_VERSION = 1;
+const unsigned TRACE_BLOCK_RECORDS = 64;
+const uint32_t TRACE_FLAG_FETCH = 1;
+
+struct Trace_Header {
+    char magic[8];
+    uint32_t version;
+    uint32_t address_bytes; // 4 or 8
+    uint64_t count;         // number of records (excluding padding)
+    uint32_t flags;         // TRACE_FLAG_* bits
+    uint32_t reserved;
+};
+
+/**
+ * Parses a hexadecimal number with an optional "0x" prefix.
+ *
+ * @param p pointer to the first character, advanced past the number
+ * @param end end of the buffer
+ * @param value set to the parsed value
+ * @return true if at least one hex digit was read and the value fits in 64 bits
+ */
+bool parse_hex(const char *&p, const char *end, uint64_t &value);
+
+/*
+ * Incremental parser for text traces ("l 0x1fffff50 1" per line). The op is l
+ * (load), i (instruction fetch) or anything else (store). If asked to, the
+ * parser keeps the optional third field as the record's pc when it is a hex
+ * number, e.g. the address of the accessing instruction. A line of a
+ * multi-core trace starts with the decimal id of the issuing core
+ * ("3 l 0x1fffff50 1"). Input can be fed in arbitrary pieces; a line split
+ * between two pieces is carried over.
+ */
+class Text_Trace_Parser {
+private:
+    std::string partial;
+    uint64_t line_number;
+    bool failed;
+    bool keep_pcs;
+
+    bool parse_line(const char *begin, const char *end, std::vector<Trace_Record> &out);
+
+public:
+    /**
+     * @param keep_pcs whether to parse the third field of each line (otherwise the pc is 0)
+     */
+    explicit Text_Trace_Parser(bool keep_pcs = false);
+
+    /**
+     * Parses every complete line in [begin, end) and appends the records to out.
+     *
+     * @return false if a malformed line was found (see error_line())
+     */
+    bool parse(const char *begin, const char *end, std::vector<Trace_Record> &out);
+
+    /**
+     * Parses a final line that was not terminated by a newline.
+     *
+     * @return false if it was malformed
+     */
+    bool finish(std::vector<Trace_Record> &out);
+
+    /**
+     * @return the line number of the last line parsed (the malformed one after a failure)
+     */
+    uint64_t error_line() const { return line_number; }
+};
+
+/**
+ * Reads a whole text trace from a file descriptor.
+ *
+ * @param fd the file descriptor to read until EOF
+ * @param out the vector the records are appended to
+ * @param error set to a message if the trace could not be read
+ * @param keep_pcs whether to parse the third field of each line
+ * @return true on success
+ */
+bool read_text_trace(int fd, std::vector<Trace_Record> &out, std::string &error, bool keep_pcs = false);
+
+/*
+ * A binary trace file mapped into memory. Records are decoded on demand, so a
+ * trace of any size costs no more than its page cache footprint.
+ */
+class Trace_File {
+private:
+    const unsigned char *data;
+    size_t length;
+    uint64_t count;
+    unsigned address_bytes;
+    uint32_t flags;
+
+public:
+    Trace_File();
+    ~Trace_File();
+
+    /**
+     * Maps the binary trace at path and validates its header.
+     *
+     * @return true on success, otherwise error is set
+     */
+    bool open(const std::string &path, std::string &error);
+
+    /**
+     * @return the number of records in the trace
+     */
+    uint64_t size() const { return count; }
+
+    /**
+     * @return true if the trace marks instruction fetches
+     */
+    bool has_fetches() const { return (flags & TRACE_FLAG_FETCH) != 0; }
+
+    /**
+     * Decodes up to n records starting at record first.
+     *
+     * @return the number of records written to out
+     */
+    size_t decode(uint64_t first, size_t n, Trace_Record *out) const;
+
+private:
+    Trace_File(const Trace_File &);
+    Trace_File &operator=(const Trace_File &);
+};
+
+/**
+ * Checks whether the file at path starts with the binary trace magic.
+ */
+bool is_binary_trace(const std::string &path);
+
+/*
+ * Streams records into a binary trace file.
+ */
+class Trace_Writer {
+private:
+    FILE *file;
+    unsigned address_bytes;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t store_mask, fetch_mask;
+    unsigned char block[TRACE_BLOCK_RECORDS * 8];
+
+    bool flush_block();
+
+public:
+    Trace_Writer();
+    ~Trace_Writer();
+
+    /**
+     * Creates path and writes a provisional header.
+     *
+     * @param address_bytes 4 or 8
+     * @param flags TRACE_FLAG_* bits
+     */
+    bool open(const std::string &path, unsigned address_bytes, uint32_t flags = 0);
+
+    /**
+     * Appends one record. Fails if the address does not fit in address_bytes,
+     * if it is an instruction fetch and the file has no fetch column, or if it
+     * has a core id (the binary format has no core column). The pc is dropped.
+     */
+    bool append(const Trace_Record &record);
+
+    /**
+     * Writes the last (padded) block, patches the record count into the header and
+     * closes the file.
+     */
+    bool close();
+
+private:
+    Trace_Writer(const Trace_Writer &);
+    Trace_Writer &operator=(const Trace_Writer &);
+};
+
+#endif //TRACE_H
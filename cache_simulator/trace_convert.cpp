@@ -0,0 +1,109 @@
+/*
+ * Converts a text memory trace into the binary trace format
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "trace.h"
+
+/**
+ * Appends parsed records to the writer and empties the vector.
+ *
+ * @return false if an address does not fit the output width
+ */
+bool write_records(Trace_Writer &writer, std::vector<Trace_Record> &records) {
+    for (auto &record : records) {
+        if (!writer.append(record)) {
+            return false;
+        }
+    }
+    records.clear();
+    return true;
+}
+
+/**
+ * Main function of the trace converter. The text trace is streamed, so traces of
+ * any length are converted in constant memory.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of strings containing command line arguments
+ * @return 0 if the trace was converted successfully
+ */
+int main(int argc, char *argv[]) {
+    unsigned address_bytes = 4;
+    uint32_t flags = 0;
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0') {
+        std::string option = argv[arg];
+        if (option == "-w" && arg + 1 < argc) {
+            std::string width = argv[arg + 1];
+            if (width == "64") {
+                address_bytes = 8;
+            } else if (width != "32") {
+                std::cerr << "Error: address width must be 32 or 64.\n";
+                return EXIT_FAILURE;
+            }
+            arg += 2;
+        } else if (option == "-f") {
+            // keep instruction fetches ("i" records) in a fetch column
+            flags |= TRACE_FLAG_FETCH;
+            arg++;
+        } else {
+            break;
+        }
+    }
+    if (argc - arg != 2) {
+        std::cerr << "Usage: trace_convert [-w 32|64] [-f] <text trace or -> <binary trace>\n";
+        return EXIT_FAILURE;
+    }
+    const std::string input = argv[arg];
+    const std::string output = argv[arg + 1];
+
+    int fd = 0;
+    if (input != "-") {
+        fd = open(input.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Error: unable to open " << input << ": " << strerror(errno) << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    Trace_Writer writer;
+    if (!writer.open(output, address_bytes, flags)) {
+        std::cerr << "Error: unable to create " << output << "\n";
+        return EXIT_FAILURE;
+    }
+
+    std::vector<char> buffer(1 << 20);
+    std::vector<Trace_Record> records;
+    Text_Trace_Parser parser;
+    bool ok = true;
+    ssize_t n;
+    while (ok && (n = read(fd, buffer.data(), buffer.size())) > 0) {
+        ok = parser.parse(buffer.data(), buffer.data() + n, records);
+        if (ok && !write_records(writer, records)) {
+            std::cerr << "Error: address does not fit in 32 bits (use -w 64), fetches without -f, or core ids.\n";
+            return EXIT_FAILURE;
+        }
+    }
+    ok = ok && parser.finish(records);
+    if (!ok) {
+        std::cerr << "Error: malformed trace line " << parser.error_line() << "\n";
+        return EXIT_FAILURE;
+    }
+    if (!write_records(writer, records)) {
+        std::cerr << "Error: address does not fit in 32 bits (use -w 64), fetches without -f, or core ids.\n";
+        return EXIT_FAILURE;
+    }
+    if (!writer.close()) {
+        std::cerr << "Error: unable to write " << output << "\n";
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
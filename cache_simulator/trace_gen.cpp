@@ -0,0 +1,179 @@
+/*
+ * C++ implementation of synthetic trace generation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cmath>
+#include <utility>
+#include "trace_gen.h"
+
+namespace {
+
+const char *const PATTERN_NAMES[NUM_TRACE_PATTERNS] = {
+    "sequential", "strided", "random", "zipf", "pointer-chase", "matmul"
+};
+
+const uint64_t STRIDE_BYTES = 256;
+const uint64_t NODE_BYTES = 64;
+const double ZIPF_THETA = 0.99;
+
+Trace_Record make_record(uint64_t address, bool is_store) {
+    Trace_Record record;
+    record.address = address;
+    record.is_store = is_store;
+    record.is_fetch = false;
+    record.core = 0;
+    record.pc = 0;
+    return record;
+}
+
+}
+
+/**
+ * Parses a pattern name (see Trace_Pattern).
+ *
+ * @return false if the name is unknown
+ */
+bool parse_trace_pattern(const std::string &name, Trace_Pattern &pattern) {
+    for (unsigned p = 0; p < NUM_TRACE_PATTERNS; p++) {
+        if (name == PATTERN_NAMES[p]) {
+            pattern = (Trace_Pattern) p;
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @return the name of a pattern
+ */
+const char *trace_pattern_name(Trace_Pattern pattern) {
+    return PATTERN_NAMES[pattern];
+}
+
+/**
+ * @param pattern the access pattern
+ * @param footprint the approximate number of bytes touched (at least 4 KiB)
+ * @param seed the seed of the random patterns
+ */
+Trace_Generator::Trace_Generator(Trace_Pattern pattern, uint64_t footprint, uint64_t seed)
+    : pattern(pattern), footprint(footprint < 4096 ? 4096 : footprint & ~uint64_t(3)), state(seed), position(0),
+      num_blocks(0), zeta_n(0), alpha(0), eta(0), half_pow_theta(0), node(0), n(0), i(0), j(0), k(0) {
+    if (pattern == PATTERN_ZIPF) {
+        // the generator of Gray et al., "Quickly generating billion-record
+        // synthetic databases": the zeta constant is summed once, then every
+        // sample costs one pow()
+        num_blocks = this->footprint / NODE_BYTES;
+        for (uint64_t r = 1; r <= num_blocks; r++) {
+            zeta_n += 1.0 / std::pow((double) r, ZIPF_THETA);
+        }
+        double zeta_2 = 1.0 + 1.0 / std::pow(2.0, ZIPF_THETA);
+        alpha = 1.0 / (1.0 - ZIPF_THETA);
+        eta = (1.0 - std::pow(2.0 / num_blocks, 1.0 - ZIPF_THETA)) / (1.0 - zeta_2 / zeta_n);
+        half_pow_theta = 1.0 + std::pow(0.5, ZIPF_THETA);
+    } else if (pattern == PATTERN_POINTER_CHASE) {
+        // Sattolo's algorithm: a random permutation with a single cycle, so
+        // the chase visits every node before it repeats
+        uint64_t nodes = this->footprint / NODE_BYTES;
+        next_node.resize(nodes);
+        for (uint64_t x = 0; x < nodes; x++) {
+            next_node[x] = (uint32_t) x;
+        }
+        for (uint64_t x = nodes - 1; x > 0; x--) {
+            uint64_t y = random() % x;
+            std::swap(next_node[x], next_node[y]);
+        }
+    } else if (pattern == PATTERN_MATMUL) {
+        n = 1;
+        while (3 * (n + 1) * (n + 1) * 8 <= this->footprint) {
+            n++;
+        }
+    }
+}
+
+/**
+ * splitmix64 (Steele, Lea and Flood).
+ */
+uint64_t Trace_Generator::random() {
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @return a uniform double in [0, 1)
+ */
+double Trace_Generator::random_unit() {
+    return (random() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/**
+ * Appends the next count records of the trace.
+ *
+ * @param out the records are written here
+ * @param count the number of records
+ */
+void Trace_Generator::generate(Trace_Record *out, size_t count) {
+    const uint64_t words = footprint / 4;
+    for (size_t x = 0; x < count; x++) {
+        switch (pattern) {
+        case PATTERN_SEQUENTIAL:
+            out[x] = make_record(TRACE_GEN_BASE + (position % words) * 4, position % 4 == 3);
+            position++;
+            break;
+        case PATTERN_STRIDED:
+            out[x] = make_record(TRACE_GEN_BASE + (position * STRIDE_BYTES) % footprint, position % 4 == 3);
+            position++;
+            break;
+        case PATTERN_RANDOM: {
+            uint64_t r = random();
+            out[x] = make_record(TRACE_GEN_BASE + (r % words) * 4, (r >> 56) < 77); // 77 / 256 = 30%
+            break;
+        }
+        case PATTERN_ZIPF: {
+            double u = random_unit();
+            double uz = u * zeta_n;
+            uint64_t rank;
+            if (uz < 1.0) {
+                rank = 0;
+            } else if (uz < half_pow_theta) {
+                rank = 1;
+            } else {
+                rank = (uint64_t) (num_blocks * std::pow(eta * u - eta + 1.0, alpha));
+                rank = rank < num_blocks ? rank : num_blocks - 1;
+            }
+            // scatter the ranks so the hot blocks do not share sets
+            uint64_t block = (rank * 0x9e3779b97f4a7c15ULL) % num_blocks;
+            uint64_t r = random();
+            out[x] = make_record(TRACE_GEN_BASE + block * NODE_BYTES + (r & (NODE_BYTES - 4)), (r >> 56) < 77);
+            break;
+        }
+        case PATTERN_POINTER_CHASE:
+            node = next_node[node];
+            out[x] = make_record(TRACE_GEN_BASE + (uint64_t) node * NODE_BYTES, false);
+            break;
+        case PATTERN_MATMUL: {
+            // A, B and C are consecutive row-major n x n arrays of doubles;
+            // each (i, j) takes 2n loads and one store
+            const uint64_t a = TRACE_GEN_BASE, b = a + n * n * 8, c = b + n * n * 8;
+            if (k < n) {
+                out[x] = make_record(position % 2 == 0 ? a + (i * n + k) * 8 : b + (k * n + j) * 8, false);
+                if (position % 2 == 1) {
+                    k++;
+                }
+                position++;
+            } else {
+                out[x] = make_record(c + (i * n + j) * 8, true);
+                k = 0;
+                position = 0;
+                if (++j == n) {
+                    j = 0;
+                    i = (i + 1) % n;
+                }
+            }
+            break;
+        }
+        }
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ * h file for synthetic trace generation
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TRACE_GEN_H
+#define TRACE_GEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "trace.h"
+
+/*
+ * Access patterns of the generator. Every pattern touches a footprint of
+ * roughly the given number of bytes starting at TRACE_GEN_BASE.
+ *
+ *   sequential     4-byte words in order, wrapping; every 4th access a store
+ *   strided        one word every 256 bytes, wrapping; every 4th access a store
+ *   random         uniform random words; 30% stores
+ *   zipf           64-byte blocks with Zipfian popularity (theta 0.99), hot
+ *                  blocks scattered over the footprint; 30% stores
+ *   pointer-chase  loads following a random cycle through 64-byte nodes
+ *   matmul         naive ijk product of n x n doubles, C = A * B: loads of
+ *                  A[i][k] and B[k][j], a store of C[i][j] per (i, j)
+ */
+enum Trace_Pattern {
+    PATTERN_SEQUENTIAL,
+    PATTERN_STRIDED,
+    PATTERN_RANDOM,
+    PATTERN_ZIPF,
+    PATTERN_POINTER_CHASE,
+    PATTERN_MATMUL
+};
+
+const unsigned NUM_TRACE_PATTERNS = 6;
+const uint64_t TRACE_GEN_BASE = 0x10000000;
+
+/**
+ * Parses a pattern name (see Trace_Pattern).
+ *
+ * @return false if the name is unknown
+ */
+bool parse_trace_pattern(const std::string &name, Trace_Pattern &pattern);
+
+/**
+ * @return the name of a pattern
+ */
+const char *trace_pattern_name(Trace_Pattern pattern);
+
+/*
+ * Generates the records of a pattern in chunks. The output depends only on
+ * the pattern, the footprint and the seed (the random numbers come from
+ * splitmix64, not from the standard library's distributions, whose output
+ * differs between implementations), so a seed names the same trace
+ * everywhere.
+ */
+class Trace_Generator {
+private:
+    Trace_Pattern pattern;
+    uint64_t footprint, state, position;
+    // zipf
+    uint64_t num_blocks;
+    double zeta_n, alpha, eta, half_pow_theta;
+    // pointer-chase: next node of each node, a single random cycle
+    std::vector<uint32_t> next_node;
+    uint32_t node;
+    // matmul
+    uint64_t n, i, j, k;
+
+    uint64_t random();
+    double random_unit();
+
+public:
+    /**
+     * @param pattern the access pattern
+     * @param footprint the approximate number of bytes touched (at least 4 KiB)
+     * @param seed the seed of the random patterns
+     */
+    Trace_Generator(Trace_Pattern pattern, uint64_t footprint, uint64_t seed);
+
+    /**
+     * Appends the next count records of the trace.
+     *
+     * @param out the records are written here
+     * @param count the number of records
+     */
+    void generate(Trace_Record *out, size_t count);
+};
+
+#endif //TRACE_GEN_H
@@ -0,0 +1,125 @@
+/*
+ * Writes synthetic memory traces for tests and benchmarks
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "trace.h"
+#include "trace_gen.h"
+
+/**
+ * Parses a size with an optional k, m or g suffix (powers of 1024).
+ *
+ * @return false if it is malformed
+ */
+bool parse_bytes(const std::string &text, uint64_t &bytes) {
+    char *end;
+    if (text.empty() || text[0] == '-') {
+        return false;
+    }
+    bytes = std::strtoull(text.c_str(), &end, 10);
+    std::string suffix = end;
+    if (suffix == "k" || suffix == "K") {
+        bytes <<= 10;
+    } else if (suffix == "m" || suffix == "M") {
+        bytes <<= 20;
+    } else if (suffix == "g" || suffix == "G") {
+        bytes <<= 30;
+    } else if (!suffix.empty()) {
+        return false;
+    }
+    return end != text.c_str();
+}
+
+/**
+ * Main function of the trace generator. Records are generated and written a
+ * chunk at a time, so traces of any length take constant memory.
+ *
+ * @param argc number of command line arguments
+ * @param argv array of strings containing command line arguments
+ * @return 0 if the trace was written successfully
+ */
+int main(int argc, char *argv[]) {
+    uint64_t seed = 1, footprint = 16 << 20;
+    bool text = false;
+    int arg = 1;
+    while (arg < argc && argv[arg][0] == '-' && argv[arg][1] != '\0') {
+        std::string option = argv[arg];
+        if (option == "-s" && arg + 1 < argc) {
+            seed = std::strtoull(argv[arg + 1], nullptr, 10);
+            arg += 2;
+        } else if (option == "-m" && arg + 1 < argc) {
+            if (!parse_bytes(argv[arg + 1], footprint)) {
+                std::cerr << "Error: invalid footprint " << argv[arg + 1] << ".\n";
+                return EXIT_FAILURE;
+            }
+            arg += 2;
+        } else if (option == "-t") {
+            text = true;
+            arg++;
+        } else {
+            break;
+        }
+    }
+    Trace_Pattern pattern;
+    if (argc - arg != 3 || !parse_trace_pattern(argv[arg], pattern)) {
+        std::cerr << "Usage: trace_gen [-s seed] [-m footprint] [-t] "
+                     "sequential|strided|random|zipf|pointer-chase|matmul <count> <trace or ->\n"
+                     "  writes a binary trace (-t: a text trace, - for standard output)\n";
+        return EXIT_FAILURE;
+    }
+    const uint64_t count = std::strtoull(argv[arg + 1], nullptr, 10);
+    const std::string output = argv[arg + 2];
+    if (!text && output == "-") {
+        std::cerr << "Error: binary traces must be written to a file.\n";
+        return EXIT_FAILURE;
+    }
+
+    Trace_Generator generator(pattern, footprint, seed);
+    std::vector<Trace_Record> chunk(64 * 1024);
+    Trace_Writer writer;
+    FILE *file = nullptr;
+    if (text) {
+        file = output == "-" ? stdout : std::fopen(output.c_str(), "w");
+    }
+    if (text ? file == nullptr : !writer.open(output, 8)) {
+        std::cerr << "Error: unable to create " << output << "\n";
+        return EXIT_FAILURE;
+    }
+    std::vector<char> line_buffer(chunk.size() * 32);
+    bool ok = true;
+    for (uint64_t done = 0; done < count && ok; done += chunk.size()) {
+        size_t n = count - done < chunk.size() ? (size_t) (count - done) : chunk.size();
+        generator.generate(chunk.data(), n);
+        if (!text) {
+            for (size_t r = 0; r < n && ok; r++) {
+                ok = writer.append(chunk[r]);
+            }
+            continue;
+        }
+        // format a chunk of lines at a time ("l 0x10000040 4")
+        char *p = line_buffer.data();
+        for (size_t r = 0; r < n; r++) {
+            p += std::sprintf(p, "%c 0x%llx 4\n", chunk[r].is_store ? 's' : 'l',
+                              (unsigned long long) chunk[r].address);
+        }
+        ok = std::fwrite(line_buffer.data(), 1, p - line_buffer.data(), file) == (size_t) (p - line_buffer.data());
+    }
+    if (text) {
+        ok = std::fflush(file) == 0 && ok;
+        if (file != stdout) {
+            ok = std::fclose(file) == 0 && ok;
+        }
+    } else {
+        ok = writer.close() && ok;
+    }
+    if (!ok) {
+        std::cerr << "Error: unable to write " << output << "\n";
+        return EXIT_FAILURE;
+    }
+    return 0;
+}
@@ -0,0 +1,109 @@
+/*
+ * C++ implementation of streaming text trace input
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include "trace_stream.h"
+
+/**
+ * Starts reading.
+ *
+ * @param fd the file descriptor to read the text trace from
+ * @param keep_pcs whether to parse the third field of each line
+ * @param num_buffers the number of buffers in the ring
+ * @param read_bytes the size of each piece of input parsed into one buffer
+ */
+Trace_Stream::Trace_Stream(int fd, bool keep_pcs, size_t num_buffers, size_t read_bytes)
+    : buffers(num_buffers > 1 ? num_buffers : 2), free_buffers(buffers.size()), full_buffers(buffers.size() + 1),
+      fd(fd), read_bytes(read_bytes), keep_pcs(keep_pcs), current(-1), done(false) {
+    for (size_t i = 0; i < buffers.size(); i++) {
+        free_buffers.push(i);
+    }
+    reader = std::thread(&Trace_Stream::run_reader, this);
+}
+
+Trace_Stream::~Trace_Stream() {
+    // drain the stream so the reader is never left blocked on a full ring
+    const Trace_Record *records;
+    size_t n;
+    while (next(records, n)) {
+    }
+    reader.join();
+}
+
+/**
+ * Parses the input piece by piece into free buffers until EOF or an error.
+ */
+void Trace_Stream::run_reader() {
+    std::vector<char> input(read_bytes);
+    Text_Trace_Parser parser(keep_pcs);
+    while (true) {
+        int index = free_buffers.pop();
+        std::vector<Trace_Record> &buffer = buffers[index];
+        buffer.clear();
+        ssize_t n = read(fd, input.data(), input.size());
+        bool ok = true;
+        if (n < 0) {
+            error = std::string("unable to read trace: ") + strerror(errno);
+            ok = false;
+        } else if (n == 0) {
+            ok = parser.finish(buffer);
+        } else {
+            ok = parser.parse(input.data(), input.data() + n, buffer);
+        }
+        if (!ok && error.empty()) {
+            error = "malformed trace line " + std::to_string(parser.error_line());
+        }
+        if (ok && !buffer.empty()) {
+            full_buffers.push(index);
+        } else {
+            free_buffers.push(index);
+        }
+        if (!ok || n == 0) {
+            full_buffers.push(-1);
+            return;
+        }
+    }
+}
+
+/**
+ * Hands the previous buffer back and waits for the next full one.
+ *
+ * @param records set to the records of the buffer
+ * @param n set to the number of records
+ * @return false at the end of the trace (see failed())
+ */
+bool Trace_Stream::next(const Trace_Record *&records, size_t &n) {
+    if (current >= 0) {
+        free_buffers.push(current);
+        current = -1;
+    }
+    if (done) {
+        return false;
+    }
+    int index = full_buffers.pop();
+    if (index < 0) {
+        done = true;
+        return false;
+    }
+    current = index;
+    records = buffers[index].data();
+    n = buffers[index].size();
+    return true;
+}
+
+/**
+ * @return true if the trace could not be read to the end, with message set
+ */
+bool Trace_Stream::failed(std::string &message) const {
+    // error is written by the reader before it queues the end marker, which
+    // the consumer has taken by the time it asks
+    if (!error.empty()) {
+        message = error;
+        return true;
+    }
+    return false;
+}
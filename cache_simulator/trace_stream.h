@@ -0,0 +1,71 @@
+/*
+ * h file for streaming text trace input
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TRACE_STREAM_H
+#define TRACE_STREAM_H
+
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+#include "bounded_queue.h"
+#include "trace.h"
+
+/*
+ * Reads a text trace on a background thread. The reader parses fixed-size
+ * pieces of input into a ring of record buffers and the consumer takes full
+ * buffers as they become ready, so parsing overlaps simulation and memory is
+ * bounded by the ring, however long the trace (or a generator piping into
+ * standard input) runs.
+ *
+ * Buffers circulate between two queues: free ones go to the reader, full ones
+ * to the consumer, which hands each back when it asks for the next.
+ */
+class Trace_Stream {
+private:
+    std::vector<std::vector<Trace_Record>> buffers;
+    Bounded_Queue<int> free_buffers, full_buffers; // buffer indices, -1 marks the end
+    int fd;
+    size_t read_bytes;
+    bool keep_pcs;
+    int current;         // buffer held by the consumer, or -1
+    std::string error;   // set by the reader before it marks the end
+    bool done;
+    std::thread reader;
+
+    void run_reader();
+
+public:
+    /**
+     * Starts reading.
+     *
+     * @param fd the file descriptor to read the text trace from
+     * @param keep_pcs whether to parse the third field of each line
+     * @param num_buffers the number of buffers in the ring
+     * @param read_bytes the size of each piece of input parsed into one buffer
+     */
+    Trace_Stream(int fd, bool keep_pcs = false, size_t num_buffers = 8, size_t read_bytes = 256 * 1024);
+    ~Trace_Stream();
+
+    /**
+     * Hands the previous buffer back and waits for the next full one.
+     *
+     * @param records set to the records of the buffer
+     * @param n set to the number of records
+     * @return false at the end of the trace (see failed())
+     */
+    bool next(const Trace_Record *&records, size_t &n);
+
+    /**
+     * @return true if the trace could not be read to the end, with message set
+     */
+    bool failed(std::string &message) const;
+
+private:
+    Trace_Stream(const Trace_Stream &);
+    Trace_Stream &operator=(const Trace_Stream &);
+};
+
+#endif //TRACE_STREAM_H
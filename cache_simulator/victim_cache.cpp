@@ -0,0 +1,69 @@
+/*
+ * C++ implementation of victim cache model
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstddef>
+#include "victim_cache.h"
+
+/**
+ * @param entries the number of blocks held, at least 1
+ */
+Victim_Cache::Victim_Cache(unsigned entries)
+    : addresses(entries, 0), inserted(entries, 0), dirty_bits(entries, false), clock(0) {
+}
+
+int Victim_Cache::find(uint64_t address) const {
+    for (size_t e = 0; e < addresses.size(); e++) {
+        if (inserted[e] != 0 && addresses[e] == address) {
+            return (int) e;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Removes a block, e.g. to swap it back into the cache.
+ *
+ * @param address the address of the block
+ * @param dirty set to whether the block was dirty
+ * @return true if the block was held
+ */
+bool Victim_Cache::take(uint64_t address, bool &dirty) {
+    int e = find(address);
+    if (e < 0) {
+        return false;
+    }
+    dirty = dirty_bits[e];
+    inserted[e] = 0;
+    return true;
+}
+
+/**
+ * Adds a block evicted from the cache, displacing the least recently
+ * inserted block if the victim cache is full.
+ *
+ * @param address the address of the block
+ * @param dirty whether the block is dirty
+ * @param displaced set to the address of the displaced block, if any
+ * @param displaced_dirty set to whether the displaced block was dirty
+ * @return true if a block was displaced
+ */
+bool Victim_Cache::insert(uint64_t address, bool dirty, uint64_t &displaced, bool &displaced_dirty) {
+    // a free entry is marked 0, so it is always the oldest
+    size_t oldest = 0;
+    for (size_t e = 1; e < addresses.size(); e++) {
+        if (inserted[e] < inserted[oldest]) {
+            oldest = e;
+        }
+    }
+    bool was_valid = inserted[oldest] != 0;
+    if (was_valid) {
+        displaced = addresses[oldest];
+        displaced_dirty = dirty_bits[oldest];
+    }
+    addresses[oldest] = address;
+    dirty_bits[oldest] = dirty;
+    inserted[oldest] = ++clock;
+    return was_valid;
+}
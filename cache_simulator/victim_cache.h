@@ -0,0 +1,69 @@
+/*
+ * h file for victim cache model
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef VICTIM_CACHE_H
+#define VICTIM_CACHE_H
+
+#include <cstdint>
+#include <vector>
+
+/*
+ * A small fully associative buffer of blocks evicted from a cache (Jouppi,
+ * "Improving direct-mapped cache performance by the addition of a small
+ * fully-associative cache and prefetch buffers"). A miss in the cache that
+ * finds its block here swaps it back instead of going to the next level, so
+ * the conflict miss is saved. A hit takes the block out, so replacing the
+ * oldest entry is LRU; a dirty block is only written back when it leaves the
+ * victim cache.
+ *
+ * Blocks are named by the address of their first byte. The buffer is meant
+ * to be a few entries, so lookups are a linear scan.
+ */
+class Victim_Cache {
+private:
+    std::vector<uint64_t> addresses;
+    std::vector<uint64_t> inserted; // insertion order, 0 marks a free entry
+    std::vector<bool> dirty_bits;
+    uint64_t clock;
+
+    Victim_Cache(const Victim_Cache &);
+    Victim_Cache &operator=(const Victim_Cache &);
+
+    int find(uint64_t address) const;
+
+public:
+    /**
+     * @param entries the number of blocks held, at least 1
+     */
+    explicit Victim_Cache(unsigned entries);
+
+    /**
+     * @return true if the block is held
+     */
+    bool contains(uint64_t address) const { return find(address) >= 0; }
+
+    /**
+     * Removes a block, e.g. to swap it back into the cache.
+     *
+     * @param address the address of the block
+     * @param dirty set to whether the block was dirty
+     * @return true if the block was held
+     */
+    bool take(uint64_t address, bool &dirty);
+
+    /**
+     * Adds a block evicted from the cache, displacing the least recently
+     * inserted block if the victim cache is full.
+     *
+     * @param address the address of the block
+     * @param dirty whether the block is dirty
+     * @param displaced set to the address of the displaced block, if any
+     * @param displaced_dirty set to whether the displaced block was dirty
+     * @return true if a block was displaced
+     */
+    bool insert(uint64_t address, bool dirty, uint64_t &displaced, bool &displaced_dirty);
+};
+
+#endif //VICTIM_CACHE_H
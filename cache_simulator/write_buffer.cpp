@@ -0,0 +1,51 @@
+/*
+ * C++ implementation of write buffer model
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <cstddef>
+#include "write_buffer.h"
+
+const uint64_t Write_Buffer::WRITE_CYCLES;
+
+/**
+ * @param depth the number of blocks the buffer holds, at least 1
+ */
+Write_Buffer::Write_Buffer(unsigned depth)
+    : depth(depth), num_writes(0), num_coalesced(0), num_stalls(0), stall_cycles(0) {
+}
+
+/**
+ * Queues a write to memory.
+ *
+ * @param block the block written (address >> log2(block size))
+ * @param now the current cycle
+ * @return the cycles the store stalls for a free entry
+ */
+uint64_t Write_Buffer::write(uint64_t block, uint64_t now) {
+    num_writes++;
+    while (!entries.empty() && entries.front().done <= now) {
+        entries.pop_front();
+    }
+    // the front entry is already on its way to memory
+    for (size_t e = 1; e < entries.size(); e++) {
+        if (entries[e].block == block) {
+            num_coalesced++;
+            return 0;
+        }
+    }
+    uint64_t stall = 0;
+    if (entries.size() == depth) {
+        stall = entries.front().done - now;
+        entries.pop_front();
+        num_stalls++;
+        stall_cycles += stall;
+    }
+    uint64_t start = now + stall;
+    if (!entries.empty() && entries.back().done > start) {
+        start = entries.back().done;
+    }
+    Entry entry = {block, start + WRITE_CYCLES};
+    entries.push_back(entry);
+    return stall;
+}
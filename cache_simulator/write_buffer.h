@@ -0,0 +1,76 @@
+/*
+ * h file for write buffer model
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef WRITE_BUFFER_H
+#define WRITE_BUFFER_H
+
+#include <cstdint>
+#include <deque>
+
+/*
+ * A coalescing write buffer between a write-through cache and memory. A
+ * store that would write memory (WRITE_CYCLES) enters the buffer instead and
+ * the core goes on; the buffer drains one block at a time in the background,
+ * each taking WRITE_CYCLES. A store to a block already waiting in the buffer
+ * (not the one being written) merges into it. Only a store that finds the
+ * buffer full stalls, until the oldest write completes.
+ *
+ * Time is the cache's cycle count. Reads do not wait for the buffer and
+ * writes still queued at the end of the trace are not charged.
+ */
+class Write_Buffer {
+public:
+    static const uint64_t WRITE_CYCLES = 100;
+
+private:
+    struct Entry {
+        uint64_t block;
+        uint64_t done; // cycle at which the write to memory completes
+    };
+
+    unsigned depth;
+    std::deque<Entry> entries;
+    uint64_t num_writes, num_coalesced, num_stalls, stall_cycles;
+
+    Write_Buffer(const Write_Buffer &);
+    Write_Buffer &operator=(const Write_Buffer &);
+
+public:
+    /**
+     * @param depth the number of blocks the buffer holds, at least 1
+     */
+    explicit Write_Buffer(unsigned depth);
+
+    /**
+     * Queues a write to memory.
+     *
+     * @param block the block written (address >> log2(block size))
+     * @param now the current cycle
+     * @return the cycles the store stalls for a free entry
+     */
+    uint64_t write(uint64_t block, uint64_t now);
+
+    /**
+     * @return the writes queued, including coalesced ones
+     */
+    uint64_t writes() const { return num_writes; }
+
+    /**
+     * @return the writes merged into a waiting entry
+     */
+    uint64_t coalesced() const { return num_coalesced; }
+
+    /**
+     * @return the writes that found the buffer full
+     */
+    uint64_t stalls() const { return num_stalls; }
+
+    /**
+     * @return the cycles stalled on a full buffer
+     */
+    uint64_t stalled_cycles() const { return stall_cycles; }
+};
+
+#endif //WRITE_BUFFER_H
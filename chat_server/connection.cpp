@@ -52,6 +52,13 @@ void Connection::close() {
   }
 }
 
+void Connection::shutdown() {
+  // wake up any reader or writer blocked on the socket
+  if (is_open()) {
+    ::shutdown(m_fd, SHUT_RDWR);
+  }
+}
+
 bool Connection::send(const Message &msg) {
   // convert the message to a string to have the format "tag:data\n"
   const std::string str_msg = msg.tag + ":" + msg.data + "\n";
@@ -85,7 +92,8 @@ bool Connection::receive(Message &msg) {
   char usrbuf[Message::MAX_LEN + 1];
 
   // handle rio_readlineb success
-  if (rio_readlineb(&m_fdbuf, usrbuf, Message::MAX_LEN) >= 0) {
+  ssize_t response = rio_readlineb(&m_fdbuf, usrbuf, Message::MAX_LEN);
+  if (response > 0) {
     // read message tag and data from the buffer array
     std::stringstream str_stream(usrbuf);
 
@@ -96,6 +104,12 @@ bool Connection::receive(Message &msg) {
     return true;
   }
 
+  // handle EOF (the peer closed or the connection was shut down)
+  if (response == 0) {
+    m_last_result = EOF_OR_ERROR;
+    return false;
+  }
+
   // handle rio_readlineb failure
   m_last_result = INVALID_MSG;
   return false;
@@ -39,6 +39,11 @@ public:
 
   void close();
 
+  // Shut down both directions of the socket without closing the file
+  // descriptor. A thread blocked in receive on this connection wakes up
+  // and sees EOF, so another thread can use this to evict a client.
+  void shutdown();
+
   // send and receive should set m_last_result to indicate
   // whether the most recent send or receive was successful,
   // and if not, whether the reason was an I/O error or reaching EOF,
@@ -49,5 +49,6 @@ struct Message {
 #define TAG_QUIT      "quit"      // quit
 #define TAG_DELIVERY  "delivery"  // message delivered by server to receiving client
 #define TAG_EMPTY     "empty"     // sent by server to receiving client to indicate no msgs available
+#define TAG_HEARTBEAT "heartbeat" // optional keepalive sent by server to an idle receiving client
 
 #endif // MESSAGE_H
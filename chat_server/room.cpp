@@ -9,14 +9,26 @@
 #include "user.h"
 #include "room.h"
 
-Room::Room(const std::string &room_name)
-  : room_name(room_name) {
-  // initialize the mutex
+Room::Room(const std::string &room_name, unsigned quantum, unsigned max_backlog)
+  : room_name(room_name)
+  , quantum(quantum > 0 ? quantum : 1)
+  , max_backlog(max_backlog)
+  , shutting_down(false) {
+  // initialize the mutex and condition variable, start the dispatcher
   pthread_mutex_init(&lock, nullptr);
+  pthread_cond_init(&work_avail, nullptr);
+  pthread_create(&dispatcher, nullptr, dispatch, this);
 }
 
 Room::~Room() {
-  // destroy the mutex
+  // stop the dispatcher, then destroy the mutex and condition variable
+  {
+    Guard g(lock);
+    shutting_down = true;
+    pthread_cond_signal(&work_avail);
+  }
+  pthread_join(dispatcher, nullptr);
+  pthread_cond_destroy(&work_avail);
   pthread_mutex_destroy(&lock);
 }
 
@@ -32,13 +44,74 @@ void Room::remove_member(User *user) {
   members.erase(user);
 }
 
-void Room::broadcast_message(const std::string &sender_username, const std::string &message_text) {
-  // send a message to every (receiver) User in the room
+bool Room::broadcast_message(const std::string &sender_username, const std::string &message_text) {
+  // queue the message on the sender's flow, the dispatcher will
+  // deliver it to every (receiver) User in the room
   Guard g(lock);
+  FlowMap::iterator it = flows.insert(std::make_pair(sender_username, Flow())).first;
+  Flow &flow = it->second;
+  if (max_backlog > 0 && flow.pending.size() >= max_backlog) {
+    return false;
+  }
+  flow.pending.push_back(message_text);
+  if (!flow.active) {
+    flow.active = true;
+    active_flows.push_back(it);
+    pthread_cond_signal(&work_avail);
+  }
+  return true;
+}
+
+void *Room::dispatch(void *arg) {
+  Room *room = (Room *)arg;
+  room->run_dispatcher();
+  return nullptr;
+}
+
+void Room::run_dispatcher() {
+  while (true) {
+    // the lock is released between rounds so that senders can keep
+    // queueing while a busy flow is being served
+    Guard g(lock);
+    while (active_flows.empty() && !shutting_down) {
+      pthread_cond_wait(&work_avail, &lock);
+    }
+    if (shutting_down) {
+      return;
+    }
+
+    // give the flow at the head of the active list one quantum worth
+    // of message bytes, carrying over whatever it does not use
+    FlowMap::iterator it = active_flows.front();
+    active_flows.pop_front();
+    Flow &flow = it->second;
+    flow.deficit += quantum;
+    while (!flow.pending.empty()) {
+      size_t cost = flow.pending.front().length() + 1;
+      if (cost > flow.deficit) {
+        break;
+      }
+      flow.deficit -= cost;
+      deliver(it->first, flow.pending.front());
+      flow.pending.pop_front();
+    }
+
+    if (flow.pending.empty()) {
+      // an idle flow keeps no credit and is forgotten
+      flows.erase(it);
+    } else {
+      active_flows.push_back(it);
+    }
+  }
+}
+
+void Room::deliver(const std::string &sender_username, const std::string &message_text) {
+  // send a message to every (receiver) User in the room, caller
+  // must hold the lock
+  Message msg(TAG_DELIVERY, room_name + ":" + sender_username + ":" + message_text);
   for (auto user : members) {
     if (user->username != sender_username) {
-      std::string msg_data = this->get_room_name() + ":" + sender_username + ":" + message_text;
-      user->mqueue.enqueue(new Message(TAG_DELIVERY, msg_data));
+      user->mqueue.enqueue(&msg);
     }
   }
-}
\ No newline at end of file
+}
@@ -8,6 +8,8 @@
 
 #include <string>
 #include <set>
+#include <map>
+#include <deque>
 #include <pthread.h>
 
 struct User;
@@ -15,9 +17,18 @@ struct User;
 // A Room object is a representation of a chat room.
 // At a minimum, it should keep track of the User objects representing
 // receivers who have joined the room.
+//
+// Broadcasts are not delivered by the sender's thread. Each sender has
+// its own bounded queue of pending broadcasts (a "flow"), and a
+// dispatcher thread per room drains the flows with deficit round
+// robin, so a sender that floods the room only delays its own
+// messages.
 class Room {
 public:
-  Room(const std::string &room_name);
+  // quantum is the number of message bytes a flow may deliver per
+  // round; max_backlog is the number of pending broadcasts a single
+  // sender may have queued before further ones are throttled
+  Room(const std::string &room_name, unsigned quantum = 256, unsigned max_backlog = 1024);
   ~Room();
 
   std::string get_room_name() const { return room_name; }
@@ -25,14 +36,44 @@ public:
   void add_member(User *user);
   void remove_member(User *user);
 
-  void broadcast_message(const std::string &sender_username, const std::string &message_text);
+  // queue a message for delivery to every other member, return false
+  // if the sender's backlog is full (the caller counts it as throttled)
+  bool broadcast_message(const std::string &sender_username, const std::string &message_text);
 
 private:
+  // prohibit value semantics
+  Room(const Room &);
+  Room &operator=(const Room &);
+
+  // pending broadcasts of one sender
+  struct Flow {
+    std::deque<std::string> pending;
+    unsigned deficit;
+    bool active; // true while on the active list
+
+    Flow() : deficit(0), active(false) { }
+  };
+
+  static void *dispatch(void *arg);
+  void run_dispatcher();
+  void deliver(const std::string &sender_username, const std::string &message_text);
+
   std::string room_name;
   pthread_mutex_t lock;
 
   typedef std::set<User *> UserSet;
   UserSet members;
+
+  // deficit round robin state, protected by lock
+  typedef std::map<std::string, Flow> FlowMap;
+  FlowMap flows;
+  std::deque<FlowMap::iterator> active_flows;
+  unsigned quantum;
+  unsigned max_backlog;
+
+  pthread_cond_t work_avail;
+  bool shutting_down;
+  pthread_t dispatcher;
 };
 
-#endif // ROOM_H
\ No newline at end of file
+#endif // ROOM_H
@@ -11,11 +11,13 @@
 #include <vector>
 #include <cctype>
 #include <cassert>
+#include <ctime>
 #include "message.h"
 #include "connection.h"
 #include "user.h"
 #include "room.h"
 #include "guard.h"
+#include "token_bucket.h"
 #include "server.h"
 
 ////////////////////////////////////////////////////////////////////////
@@ -28,15 +30,74 @@
 struct ConnInfo {
   Connection *conn;
   Server *server;
-  ~ConnInfo() { delete conn; }
+  TimerWheel::Timer timer; // login, idle or keepalive timer for this client
+  ~ConnInfo() {
+    // the timer refers to the connection, so it must be gone first
+    server->get_timers().cancel(&timer);
+    delete conn;
+  }
 };
 
-void chat_with_sender(Connection *conn, Server *server, User *user);
-void chat_with_receiver(Connection *conn, Server *server, User *user);
+void chat_with_sender(Connection *conn, Server *server, User *user, TimerWheel::Timer *timer);
+void chat_with_receiver(Connection *conn, Server *server, User *user, TimerWheel::Timer *timer);
 
 namespace
 {
 
+  // tick length of the server's timer wheel
+  const unsigned TIMER_TICK_MS = 100;
+
+  // timer callback: evict a client that timed out by shutting down its
+  // socket, which makes the worker's blocked receive fail
+  void expire_connection(void *arg) {
+    Connection *conn = (Connection *)arg;
+    conn->shutdown();
+  }
+
+  // timer callback: queue a heartbeat for an idle receiver, so that a
+  // dead client is detected when the delivery fails
+  void send_heartbeat(void *arg) {
+    User *user = (User *)arg;
+    Message heartbeat(TAG_HEARTBEAT, "");
+    user->mqueue.enqueue(&heartbeat);
+  }
+
+  // counts the broadcasts of one sender connection, and reports the
+  // throttled ones when the connection ends
+  struct SendCounter {
+    Server *server;
+    std::string username;
+    unsigned long sent;
+    unsigned long throttled;
+
+    SendCounter(Server *server, const std::string &username)
+      : server(server), username(username), sent(0), throttled(0) { }
+
+    ~SendCounter() {
+      if (throttled > 0) {
+        unsigned long total = server->add_throttled(throttled);
+        std::cerr << "sender " << username << ": " << throttled << " of " << sent
+                  << " sends throttled (" << total << " total)" << std::endl;
+      }
+    }
+  };
+
+  // single thread that drives the timer wheel for every connection
+  void *reaper(void *arg) {
+    pthread_detach(pthread_self());
+    Server *server = (Server *)arg;
+    TimerWheel &timers = server->get_timers();
+
+    struct timespec tick;
+    tick.tv_sec = timers.get_tick_ms() / 1000;
+    tick.tv_nsec = (timers.get_tick_ms() % 1000) * 1000000L;
+    while (true) {
+      nanosleep(&tick, nullptr);
+      timers.advance(TimerWheel::now_ms());
+    }
+    return nullptr;
+  }
+
   void *worker(void *arg) {
     pthread_detach(pthread_self());
     struct ConnInfo *temp_info = (ConnInfo *)arg;
@@ -47,6 +108,13 @@ namespace
     Message login_msg = Message();
     Connection* curr_conn = info->conn; // local variable for readability
 
+    // a client that never finishes logging in is disconnected
+    const ServerTimeouts &timeouts = info->server->get_timeouts();
+    if (timeouts.login_ms > 0) {
+      info->server->get_timers().schedule(&info->timer, timeouts.login_ms, 0,
+                                          expire_connection, curr_conn);
+    }
+
     // handle receive failure
     if (!curr_conn->receive(login_msg)) {
       if (curr_conn->get_last_result() == Connection::INVALID_MSG) {
@@ -77,9 +145,9 @@ namespace
     User *user = new User(username);
 
     if (login_msg.tag == TAG_RLOGIN) {
-      chat_with_receiver(curr_conn, info->server, user);
+      chat_with_receiver(curr_conn, info->server, user, &info->timer);
     } else { // since error handled above, TAG_SLOGIN otherwise
-      chat_with_sender(curr_conn, info->server, user);
+      chat_with_sender(curr_conn, info->server, user, &info->timer);
     }
 
     return nullptr;
@@ -87,7 +155,7 @@ namespace
 
 }
 
-void chat_with_receiver(Connection *conn, Server *server, User *user) {
+void chat_with_receiver(Connection *conn, Server *server, User *user, TimerWheel::Timer *timer) {
   // terminate the loop and tear down the client thread if any message
   // transmission fails or if quit message respond to join room
   Message msg = Message();
@@ -121,6 +189,17 @@ void chat_with_receiver(Connection *conn, Server *server, User *user) {
   if (!conn->send(Message(TAG_OK, "joined room " + joined_room->get_room_name()))) {
     return;
   }
+
+  // the login timer is done; from now on an idle receiver is only
+  // probed with heartbeats (if enabled)
+  TimerWheel &timers = server->get_timers();
+  unsigned keepalive_ms = server->get_timeouts().keepalive_ms;
+  if (keepalive_ms > 0) {
+    timers.schedule(timer, keepalive_ms, keepalive_ms, send_heartbeat, user);
+  } else {
+    timers.cancel(timer);
+  }
+
   // deliver dequeued messages to the receiver
   Message *dequeued_msg = nullptr;
   while (true) {
@@ -128,6 +207,7 @@ void chat_with_receiver(Connection *conn, Server *server, User *user) {
     if (dequeued_msg != nullptr) {
       if (conn->send(*dequeued_msg)) {
         delete dequeued_msg;
+        timers.touch(timer, keepalive_ms); // no heartbeat needed for a while
       } else {
         delete dequeued_msg;
         break;
@@ -138,11 +218,26 @@ void chat_with_receiver(Connection *conn, Server *server, User *user) {
   return;
 }
 
-void chat_with_sender(Connection *conn, Server *server, User *user) {
+void chat_with_sender(Connection *conn, Server *server, User *user, TimerWheel::Timer *timer) {
+  // replace the login timer with the idle timer
+  TimerWheel &timers = server->get_timers();
+  unsigned idle_ms = server->get_timeouts().idle_ms;
+  if (idle_ms > 0) {
+    timers.schedule(timer, idle_ms, 0, expire_connection, conn);
+  } else {
+    timers.cancel(timer);
+  }
+
+  // throttled sends are counted and reported when the sender leaves
+  const ServerLimits &limits = server->get_limits();
+  TokenBucket bucket(limits.send_rate, limits.send_burst);
+  SendCounter counter(server, user->username);
+
   Room *curr_room = nullptr;
   while (true) {
     Message msg;
     bool received_message = conn->receive(msg);
+    timers.touch(timer, idle_ms); // any traffic resets the idle timer
     std::string msg_tag;
     std::string msg_data;
     // handle failure to receive message
@@ -202,7 +297,16 @@ void chat_with_sender(Connection *conn, Server *server, User *user) {
           return;
         }
       } else if (msg_tag == TAG_SENDALL) { // handle sendall request
-        curr_room->broadcast_message(user->username, msg_data);
+        counter.sent++;
+        // refuse the message if the sender exceeds its rate or its
+        // backlog in the room is full
+        if (!bucket.try_take() || !curr_room->broadcast_message(user->username, msg_data)) {
+          counter.throttled++;
+          if (!conn->send(Message(TAG_ERR, "rate limit exceeded"))) {
+            return;
+          }
+          continue;
+        }
         // handle failure to send message to everyone
         if (!conn->send(Message(TAG_OK, "message sent"))) {
           return;
@@ -222,9 +326,13 @@ void chat_with_sender(Connection *conn, Server *server, User *user) {
 // Server member function implementation
 ////////////////////////////////////////////////////////////////////////
 
-Server::Server(int port)
+Server::Server(int port, const ServerTimeouts &timeouts, const ServerLimits &limits)
   : m_port(port)
-  , m_ssock(-1) {
+  , m_ssock(-1)
+  , m_timeouts(timeouts)
+  , m_timers(TIMER_TICK_MS)
+  , m_limits(limits)
+  , m_throttled(0) {
   // initialize mutex
   pthread_mutex_init(&m_lock, nullptr);
 }
@@ -247,6 +355,13 @@ bool Server::listen() {
 }
 
 void Server::handle_client_requests() {
+  // start the thread that expires connection timers
+  pthread_t reaper_id;
+  if (pthread_create(&reaper_id, NULL, reaper, this) != 0) {
+    std::cerr << "Error: unable to create the reaper thread." << std::endl;
+    return;
+  }
+
   // infinite loop calling accept or Accept, starting a new
   // pthread for each connected client
   while (true) {
@@ -272,10 +387,17 @@ void Server::handle_client_requests() {
 Room *Server::find_or_create_room(const std::string &room_name) {
   // return a pointer to the unique Room object representing
   // the named chat room, creating a new one if necessary
-  if (m_rooms.count(room_name) <= 0) {
-    Room * new_room = new Room(room_name);
-    Guard g(m_lock);
-    m_rooms[room_name] = new_room;
+  Guard g(m_lock);
+  RoomMap::iterator it = m_rooms.find(room_name);
+  if (it == m_rooms.end()) {
+    Room *new_room = new Room(room_name, m_limits.drr_quantum, m_limits.max_backlog);
+    it = m_rooms.insert(std::make_pair(room_name, new_room)).first;
   }
-  return m_rooms[room_name];
-}
\ No newline at end of file
+  return it->second;
+}
+
+unsigned long Server::add_throttled(unsigned long count) {
+  Guard g(m_lock);
+  m_throttled += count;
+  return m_throttled;
+}
@@ -12,12 +12,40 @@
 #include "message.h"
 #include "connection.h"
 #include "user.h"
+#include "timer_wheel.h"
 
 class Room;
 
+// Timeouts used to reap dead or idle clients, in milliseconds.
+// A value of 0 disables the corresponding timer.
+struct ServerTimeouts {
+  unsigned login_ms;     // time a new client has to log in (and join, for receivers)
+  unsigned idle_ms;      // senders that send nothing for this long are disconnected
+  unsigned keepalive_ms; // interval of heartbeat messages sent to idle receivers
+
+  ServerTimeouts()
+    : login_ms(10000), idle_ms(300000), keepalive_ms(0) { }
+};
+
+// Admission control for broadcasts. Each sender has a token bucket
+// of send_burst messages refilled at send_rate messages per second
+// (0 disables it), and each room schedules its senders' broadcasts
+// with deficit round robin, drr_quantum message bytes per round, with
+// at most max_backlog pending broadcasts per sender.
+struct ServerLimits {
+  double send_rate;
+  unsigned send_burst;
+  unsigned drr_quantum;
+  unsigned max_backlog;
+
+  ServerLimits()
+    : send_rate(0), send_burst(20), drr_quantum(256), max_backlog(1024) { }
+};
+
 class Server {
 public:
-  Server(int port);
+  Server(int port, const ServerTimeouts &timeouts = ServerTimeouts(),
+         const ServerLimits &limits = ServerLimits());
   ~Server();
 
   bool listen();
@@ -26,6 +54,14 @@ public:
 
   Room *find_or_create_room(const std::string &room_name);
 
+  const ServerTimeouts &get_timeouts() const { return m_timeouts; }
+  TimerWheel &get_timers() { return m_timers; }
+
+  const ServerLimits &get_limits() const { return m_limits; }
+
+  // record that a sender had sends throttled, return the server total
+  unsigned long add_throttled(unsigned long count);
+
 private:
   // prohibit value semantics
   Server(const Server &);
@@ -39,6 +75,14 @@ private:
   int m_ssock;
   RoomMap m_rooms;
   pthread_mutex_t m_lock;
+
+  // all connection timers live in one wheel, driven by a single
+  // reaper thread
+  ServerTimeouts m_timeouts;
+  TimerWheel m_timers;
+
+  ServerLimits m_limits;
+  unsigned long m_throttled; // protected by m_lock
 };
 
 #endif // SERVER_H
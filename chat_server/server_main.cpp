@@ -1,25 +1,123 @@
 #include <iostream>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cmath>
 #include <csignal>
+#include <cstdlib>
+#include <unistd.h>
 #include "server.h"
 
 // If you implement the Server class as described by its
 // TODO comments, you should not need to make any changes
 // to this main function.
 
+static void usage() {
+  std::cerr << "Usage: server_main [-l login_secs] [-i idle_secs] [-k keepalive_secs]\n"
+            << "                   [-r rate] [-b burst] [-q quantum] [-Q backlog] <port>\n"
+            << "  -l  seconds a client has to log in (0 = no limit)\n"
+            << "  -i  seconds a sender may stay idle (0 = no limit)\n"
+            << "  -k  send heartbeats to idle receivers this often (0 = off)\n"
+            << "  -r  broadcasts per second allowed per sender (0 = no limit)\n"
+            << "  -b  burst of broadcasts a sender may send at once\n"
+            << "  -q  message bytes each sender may deliver per scheduling round\n"
+            << "  -Q  pending broadcasts per sender and room (0 = no limit)\n";
+}
+
+// parse a non-negative decimal integer no larger than max, return
+// false if the whole text is not one
+static bool parse_unsigned(const char *text, unsigned long max, unsigned &value) {
+  if (!isdigit((unsigned char)text[0])) {
+    return false;
+  }
+  char *end;
+  errno = 0;
+  unsigned long parsed = strtoul(text, &end, 10);
+  if (errno != 0 || *end != '\0' || parsed > max) {
+    return false;
+  }
+  value = (unsigned)parsed;
+  return true;
+}
+
+// parse a timeout given in seconds into milliseconds
+static bool parse_seconds(const char *text, unsigned &ms) {
+  unsigned secs;
+  if (!parse_unsigned(text, UINT_MAX / 1000, secs)) {
+    return false;
+  }
+  ms = secs * 1000;
+  return true;
+}
+
+// parse a non-negative finite rate, return false if the whole text
+// is not one
+static bool parse_rate(const char *text, double &rate) {
+  if (!isdigit((unsigned char)text[0]) && text[0] != '.') {
+    return false;
+  }
+  char *end;
+  errno = 0;
+  double parsed = strtod(text, &end);
+  if (errno != 0 || *end != '\0' || !std::isfinite(parsed)) {
+    return false;
+  }
+  rate = parsed;
+  return true;
+}
+
 int main(int argc, char **argv) {
-  if (argc != 2) {
-    std::cerr << "Usage: server_main <port>\n";
+  // optional timeouts (given in seconds on the command line) and
+  // broadcast limits
+  ServerTimeouts timeouts;
+  ServerLimits limits;
+  int opt;
+  while ((opt = getopt(argc, argv, "l:i:k:r:b:q:Q:")) != -1) {
+    bool valid = true;
+    switch (opt) {
+    case 'l':
+      valid = parse_seconds(optarg, timeouts.login_ms);
+      break;
+    case 'i':
+      valid = parse_seconds(optarg, timeouts.idle_ms);
+      break;
+    case 'k':
+      valid = parse_seconds(optarg, timeouts.keepalive_ms);
+      break;
+    case 'r':
+      valid = parse_rate(optarg, limits.send_rate);
+      break;
+    case 'b':
+      valid = parse_unsigned(optarg, UINT_MAX, limits.send_burst);
+      break;
+    case 'q':
+      valid = parse_unsigned(optarg, UINT_MAX, limits.drr_quantum);
+      break;
+    case 'Q':
+      valid = parse_unsigned(optarg, UINT_MAX, limits.max_backlog);
+      break;
+    default:
+      valid = false;
+    }
+    if (!valid) {
+      usage();
+      return 1;
+    }
+  }
+
+  if (argc - optind != 1) {
+    usage();
     return 1;
   }
 
-  int port = std::stoi(argv[1]);
+  int port = std::stoi(argv[optind]);
 
   // ignore SIGPIPE: when the server sends data to the receive client,
   // it may find that the connection has been terminated (e.g., if the
   // receive client exited)
   signal(SIGPIPE, SIG_IGN);
 
-  Server server(port);
+  Server server(port, timeouts, limits);
   if (!server.listen()) {
     std::cerr << "Could not listen on port " << port << "\n";
     return 1;
@@ -0,0 +1,144 @@
+/*
+ * C++ implementation of timer_wheel.cpp
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include <ctime>
+#include "guard.h"
+#include "timer_wheel.h"
+
+TimerWheel::TimerWheel(unsigned tick_ms)
+  : m_tick_ms(tick_ms > 0 ? tick_ms : 1)
+  , m_base_ms(now_ms())
+  , m_now(0) {
+  // every slot starts out as an empty circular list
+  for (unsigned level = 0; level < LEVELS; level++) {
+    for (unsigned slot = 0; slot < SLOTS; slot++) {
+      Timer *head = &m_slots[level][slot];
+      head->prev = head;
+      head->next = head;
+    }
+  }
+  pthread_mutex_init(&m_lock, nullptr);
+}
+
+TimerWheel::~TimerWheel() {
+  pthread_mutex_destroy(&m_lock);
+}
+
+void TimerWheel::schedule(Timer *timer, unsigned delay_ms, unsigned period_ms,
+                          Callback callback, void *arg) {
+  Guard g(m_lock);
+  if (timer->pending) {
+    unlink(timer);
+  }
+  timer->callback = callback;
+  timer->arg = arg;
+  timer->period = period_ms > 0 ? to_ticks(period_ms) : 0;
+  timer->expires = m_now + to_ticks(delay_ms);
+  link(timer);
+}
+
+void TimerWheel::touch(Timer *timer, unsigned delay_ms) {
+  Guard g(m_lock);
+  if (!timer->pending) {
+    return;
+  }
+  unlink(timer);
+  timer->expires = m_now + to_ticks(delay_ms);
+  link(timer);
+}
+
+void TimerWheel::cancel(Timer *timer) {
+  // callbacks only run while the lock is held, so acquiring it here
+  // also waits out a callback that is currently running
+  Guard g(m_lock);
+  if (timer->pending) {
+    unlink(timer);
+  }
+}
+
+void TimerWheel::advance(uint64_t now_ms) {
+  Guard g(m_lock);
+  if (now_ms < m_base_ms) {
+    return;
+  }
+  uint64_t target = (now_ms - m_base_ms) / m_tick_ms;
+  while (m_now < target) {
+    m_now++;
+    // when a higher level slot boundary is reached, redistribute the
+    // timers in that slot into the lower levels (highest level first,
+    // so that timers can fall through more than one level)
+    for (unsigned level = LEVELS - 1; level > 0; level--) {
+      uint64_t mask = (uint64_t(1) << (LEVEL_BITS * level)) - 1;
+      if ((m_now & mask) == 0) {
+        cascade(level, (m_now >> (LEVEL_BITS * level)) & (SLOTS - 1));
+      }
+    }
+
+    // fire every timer in the current level 0 slot
+    Timer *head = &m_slots[0][m_now & (SLOTS - 1)];
+    while (head->next != head) {
+      Timer *timer = head->next;
+      unlink(timer);
+      if (timer->period > 0) {
+        timer->expires = m_now + timer->period;
+        link(timer);
+      }
+      timer->callback(timer->arg);
+    }
+  }
+}
+
+uint64_t TimerWheel::now_ms() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return uint64_t(ts.tv_sec) * 1000 + uint64_t(ts.tv_nsec) / 1000000;
+}
+
+uint64_t TimerWheel::to_ticks(unsigned ms) const {
+  // round up, and never schedule for the tick that is already running
+  uint64_t ticks = (uint64_t(ms) + m_tick_ms - 1) / m_tick_ms;
+  return ticks > 0 ? ticks : 1;
+}
+
+void TimerWheel::link(Timer *timer) {
+  // clamp to the span the wheel can represent
+  const uint64_t span = uint64_t(1) << (LEVEL_BITS * LEVELS);
+  if (timer->expires - m_now >= span) {
+    timer->expires = m_now + span - 1;
+  }
+
+  // pick the lowest level in which expiry and now share every
+  // higher-order slot index
+  unsigned level = 0;
+  while (level < LEVELS - 1
+         && ((timer->expires ^ m_now) >> (LEVEL_BITS * (level + 1))) != 0) {
+    level++;
+  }
+  unsigned slot = (timer->expires >> (LEVEL_BITS * level)) & (SLOTS - 1);
+
+  Timer *head = &m_slots[level][slot];
+  timer->prev = head->prev;
+  timer->next = head;
+  head->prev->next = timer;
+  head->prev = timer;
+  timer->pending = true;
+}
+
+void TimerWheel::unlink(Timer *timer) {
+  timer->prev->next = timer->next;
+  timer->next->prev = timer->prev;
+  timer->prev = nullptr;
+  timer->next = nullptr;
+  timer->pending = false;
+}
+
+void TimerWheel::cascade(unsigned level, unsigned slot) {
+  Timer *head = &m_slots[level][slot];
+  while (head->next != head) {
+    Timer *timer = head->next;
+    unlink(timer);
+    link(timer);
+  }
+}
@@ -0,0 +1,91 @@
+/*
+ * h file for timer_wheel.cpp
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#include <cstdint>
+#include <pthread.h>
+
+// A hierarchical timing wheel. Timers are intrusive list nodes owned
+// by the caller, so scheduling, rescheduling and cancelling a timer
+// are O(1) and never allocate. One thread drives the wheel by calling
+// advance() periodically; expired timers have their callback invoked
+// from that thread.
+//
+// Each level has 64 slots. Level 0 slots are one tick wide, level 1
+// slots are 64 ticks wide, and so on. A timer lives in the lowest
+// level whose slot range still separates its expiry from the current
+// tick, and is cascaded down a level each time the wheel reaches the
+// start of its slot.
+class TimerWheel {
+public:
+  typedef void (*Callback)(void *arg);
+
+  struct Timer {
+    Timer *prev;
+    Timer *next;
+    uint64_t expires;   // absolute expiry, in ticks
+    uint64_t period;    // re-arm interval in ticks, 0 for one-shot
+    Callback callback;
+    void *arg;
+    bool pending;       // true while linked into the wheel
+
+    Timer()
+      : prev(nullptr), next(nullptr), expires(0), period(0)
+      , callback(nullptr), arg(nullptr), pending(false) { }
+  };
+
+  // tick_ms is the wheel resolution in milliseconds
+  TimerWheel(unsigned tick_ms);
+  ~TimerWheel();
+
+  unsigned get_tick_ms() const { return m_tick_ms; }
+
+  // (Re)arm a timer to fire after delay_ms milliseconds. If period_ms
+  // is nonzero the timer is re-armed with that interval every time it
+  // fires. Scheduling a pending timer moves it.
+  void schedule(Timer *timer, unsigned delay_ms, unsigned period_ms,
+                Callback callback, void *arg);
+
+  // Push a pending timer's expiry back to delay_ms from now, keeping
+  // its callback and period. Does nothing if the timer is not pending.
+  void touch(Timer *timer, unsigned delay_ms);
+
+  // Remove a timer from the wheel. Once cancel returns, the timer's
+  // callback is not running and will not be called again, so the
+  // object owning the timer may be destroyed.
+  void cancel(Timer *timer);
+
+  // Run every timer that is due at or before now_ms (a monotonic
+  // clock reading). Callbacks run with the wheel locked, so they must
+  // not call back into the wheel.
+  void advance(uint64_t now_ms);
+
+  // current monotonic clock reading in milliseconds
+  static uint64_t now_ms();
+
+private:
+  // prohibit value semantics
+  TimerWheel(const TimerWheel &);
+  TimerWheel &operator=(const TimerWheel &);
+
+  static const unsigned LEVEL_BITS = 6;
+  static const unsigned SLOTS = 1U << LEVEL_BITS;
+  static const unsigned LEVELS = 4;
+
+  uint64_t to_ticks(unsigned ms) const;
+  void link(Timer *timer);
+  void unlink(Timer *timer);
+  void cascade(unsigned level, unsigned slot);
+
+  unsigned m_tick_ms;
+  uint64_t m_base_ms;   // clock reading that corresponds to tick 0
+  uint64_t m_now;       // current tick
+  Timer m_slots[LEVELS][SLOTS]; // list heads
+  pthread_mutex_t m_lock;
+};
+
+#endif // TIMER_WHEEL_H
@@ -0,0 +1,34 @@
+/*
+ * C++ implementation of token_bucket.cpp
+ * Jiwon Moon, Hajin Jang
+ */
+
+#include "timer_wheel.h"
+#include "token_bucket.h"
+
+TokenBucket::TokenBucket(double rate, unsigned burst)
+  : m_rate(rate)
+  , m_burst(burst > 0 ? burst : 1)
+  , m_tokens(m_burst)
+  , m_last_ms(TimerWheel::now_ms()) {
+}
+
+bool TokenBucket::try_take() {
+  if (m_rate <= 0) {
+    return true;
+  }
+
+  // refill for the time that passed since the last call
+  uint64_t now = TimerWheel::now_ms();
+  m_tokens += (now - m_last_ms) * m_rate / 1000.0;
+  if (m_tokens > m_burst) {
+    m_tokens = m_burst;
+  }
+  m_last_ms = now;
+
+  if (m_tokens < 1.0) {
+    return false;
+  }
+  m_tokens -= 1.0;
+  return true;
+}
@@ -0,0 +1,30 @@
+/*
+ * h file for token_bucket.cpp
+ * Jiwon Moon, Hajin Jang
+ */
+
+#ifndef TOKEN_BUCKET_H
+#define TOKEN_BUCKET_H
+
+#include <cstdint>
+
+// A token bucket rate limiter. Tokens accumulate at a fixed rate up to
+// a maximum burst, and each admitted operation spends one token.
+// A TokenBucket is owned by a single thread and is not synchronized.
+class TokenBucket {
+public:
+  // rate is in tokens per second; a rate of 0 disables limiting
+  TokenBucket(double rate, unsigned burst);
+
+  // spend a token if one is available, return false if the caller
+  // should be throttled
+  bool try_take();
+
+private:
+  double m_rate;
+  double m_burst;
+  double m_tokens;
+  uint64_t m_last_ms; // time of the last refill
+};
+
+#endif // TOKEN_BUCKET_H
@@ -0,0 +1,154 @@
+// Hajin Jang, Ju Suk Yoon, Jiewan Hong
+
+#include "Attacks.h"
+
+namespace Chess
+{
+	Bitboard knight_table[NUM_SQUARES];
+	Bitboard king_table[NUM_SQUARES];
+	Bitboard pawn_table[2][NUM_SQUARES];
+	Magic rook_magics[NUM_SQUARES];
+	Magic bishop_magics[NUM_SQUARES];
+
+	namespace
+	{
+		// Every subset of every mask gets an entry: 2^10 to 2^12 per square
+		// for rooks, 2^5 to 2^9 for bishops
+		Bitboard rook_attack_table[102400];
+		Bitboard bishop_attack_table[5248];
+
+		const int ROOK_DIRECTIONS[4][2] = {{1, 0}, {-1, 0}, {0, 1}, {0, -1}};
+		const int BISHOP_DIRECTIONS[4][2] = {{1, 1}, {1, -1}, {-1, 1}, {-1, -1}};
+		const int KNIGHT_STEPS[8][2] = {{1, 2}, {2, 1}, {2, -1}, {1, -2}, {-1, -2}, {-2, -1}, {-2, 1}, {-1, 2}};
+		const int KING_STEPS[8][2] = {{1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}, {-1, -1}, {0, -1}, {1, -1}};
+		const int PAWN_CAPTURE_STEPS[2][2][2] = {{{-1, 1}, {1, 1}}, {{-1, -1}, {1, -1}}}; // white, black
+
+		// Returns the square a step of (columns, rows) away, or -1 if it is off the board
+		int step(int square, int columns, int rows) {
+			int column = square % 8 + columns;
+			int row = square / 8 + rows;
+			if (column < 0 || column > 7 || row < 0 || row > 7) {
+				return -1;
+			}
+			return 8 * row + column;
+		}
+
+		// Returns the squares reached by single steps in the given directions
+		Bitboard step_attacks(int square, const int steps[][2], int num_steps) {
+			Bitboard attacks = 0;
+			for (int i = 0; i < num_steps; i++) {
+				int to = step(square, steps[i][0], steps[i][1]);
+				if (to >= 0) {
+					attacks |= square_bit(to);
+				}
+			}
+			return attacks;
+		}
+
+		// Walks the rays from the square, stopping at the first occupied square.
+		// Only used to fill in the tables
+		Bitboard ray_attacks(int square, Bitboard occupied, const int directions[4][2]) {
+			Bitboard attacks = 0;
+			for (int d = 0; d < 4; d++) {
+				for (int to = step(square, directions[d][0], directions[d][1]); to >= 0;
+				     to = step(to, directions[d][0], directions[d][1])) {
+					attacks |= square_bit(to);
+					if (occupied & square_bit(to)) {
+						break;
+					}
+				}
+			}
+			return attacks;
+		}
+
+		// Returns the squares of the rays from the square, without the last
+		// square of each ray: whether it is occupied never changes the attacks
+		Bitboard ray_mask(int square, const int directions[4][2]) {
+			Bitboard mask = 0;
+			for (int d = 0; d < 4; d++) {
+				int to = step(square, directions[d][0], directions[d][1]);
+				while (to >= 0 && step(to, directions[d][0], directions[d][1]) >= 0) {
+					mask |= square_bit(to);
+					to = step(to, directions[d][0], directions[d][1]);
+				}
+			}
+			return mask;
+		}
+
+		// Magics for the multiply-and-shift index of each square, found by
+		// trying sparse random numbers until no two subsets of the mask with
+		// different attacks share an index
+		const Bitboard ROOK_MAGICS[NUM_SQUARES] = {
+			0x008000908064c000ULL, 0x0040200040001000ULL, 0x0180100080a0010aULL, 0x8880041000800800ULL,
+			0x1200100201200804ULL, 0x0200020004011008ULL, 0x2180010000800600ULL, 0x0200005088210204ULL,
+			0x0400800040008021ULL, 0x0400400020005000ULL, 0x8240801000200080ULL, 0x8611001004200900ULL,
+			0x008180800c001800ULL, 0x0100800200800400ULL, 0x0a02000102000408ULL, 0x8020802300104280ULL,
+			0x0080004000402000ULL, 0xe010104000402000ULL, 0x0800808010002000ULL, 0xa280210008100100ULL,
+			0x0001818014000800ULL, 0xa002010100080400ULL, 0x0080240001020870ULL, 0x0001020004048845ULL,
+			0x0081826280004004ULL, 0x2020810900284000ULL, 0x0200100080802000ULL, 0x0200080080100080ULL,
+			0x8083080100100500ULL, 0x4406000901000400ULL, 0x0005020080800100ULL, 0x0090204200008114ULL,
+			0x0010400094800420ULL, 0x0900804000802002ULL, 0x0201001841002000ULL, 0x4100080080801000ULL,
+			0x4540040080800800ULL, 0x0002001004040020ULL, 0x0281195814001002ULL, 0x1240800040800100ULL,
+			0x0880042000524004ULL, 0x02c080410206002cULL, 0x0801200241050010ULL, 0x8400080010008080ULL,
+			0x0008000500090010ULL, 0x0082009084020008ULL, 0x4012000108020004ULL, 0x9000104d08860004ULL,
+			0x2004204114800100ULL, 0x0148802112400300ULL, 0x0202842000100880ULL, 0x001b080080900080ULL,
+			0x001a002008100600ULL, 0x0004008004020080ULL, 0x5181000600040300ULL, 0x0000044401128a00ULL,
+			0x8044110480002441ULL, 0x2008110084402202ULL, 0x90806005090010c1ULL, 0x000420310a004a42ULL,
+			0x0023001004020801ULL, 0x0882001008040102ULL, 0x000230088118020cULL, 0x0000019025040042ULL,
+		};
+
+		const Bitboard BISHOP_MAGICS[NUM_SQUARES] = {
+			0x0045010808008680ULL, 0x2002080204004898ULL, 0x0210009a10400006ULL, 0x0824050200810200ULL,
+			0x0006061105004090ULL, 0x00010108c0000000ULL, 0x0814040282104004ULL, 0x0012012201106800ULL,
+			0x10823014100c1040ULL, 0x0080c2088802808cULL, 0x0281108410404000ULL, 0x0101212041826200ULL,
+			0x0020141028221058ULL, 0x2201020202200202ULL, 0x000082a801482000ULL, 0x0000008401411044ULL,
+			0x0007103014300404ULL, 0x0002091110010100ULL, 0x42140012040c0808ULL, 0x0800808802004020ULL,
+			0x90c4004210140000ULL, 0x0800200900a01000ULL, 0x00d0400201108810ULL, 0x80820183814412a0ULL,
+			0x00a01008202202b4ULL, 0x01c2021a09500402ULL, 0x0084440208042400ULL, 0x800400400c090100ULL,
+			0xba10040010802100ULL, 0xd182009006005000ULL, 0x5011021001009004ULL, 0x0020420200510400ULL,
+			0x0292104000468800ULL, 0x00043009091c0500ULL, 0x0280441000020025ULL, 0x0042820080080080ULL,
+			0x0440101010010040ULL, 0x1000900100808080ULL, 0x0108108120089800ULL, 0x0044010200012682ULL,
+			0xc002500420900400ULL, 0x0040482210710800ULL, 0x0002060024000200ULL, 0x0281020a44000800ULL,
+			0xa0021200a4000200ULL, 0x0001301000840840ULL, 0x2868500108444220ULL, 0x0004111041000200ULL,
+			0x8044020842080200ULL, 0x0000220104210200ULL, 0x0000021201044000ULL, 0x0000280884040028ULL,
+			0x4012114010858003ULL, 0x0000081004082b88ULL, 0x3892700508208002ULL, 0x00220a041b060400ULL,
+			0x0812020284014881ULL, 0x010434a282103100ULL, 0x0490400824020800ULL, 0x4a20002c00208800ULL,
+			0x000000a011020200ULL, 0x4002940a02482202ULL, 0x5100100202140406ULL, 0x02102000840540c1ULL,
+		};
+
+		// Fills in the attack tables of a sliding piece, one entry for every
+		// subset of each square's mask
+		void init_sliders(Magic magics[NUM_SQUARES], Bitboard* table, const int directions[4][2],
+		                  const Bitboard square_magics[NUM_SQUARES]) {
+			for (int square = 0; square < NUM_SQUARES; square++) {
+				Magic& m = magics[square];
+				m.mask = ray_mask(square, directions);
+				m.magic = square_magics[square];
+				m.shift = 64 - popcount(m.mask);
+				m.attacks = table;
+
+				// enumerate the subsets of the mask (Carry-Rippler)
+				Bitboard subset = 0;
+				do {
+					table[m.index(subset)] = ray_attacks(square, subset, directions);
+					subset = (subset - m.mask) & m.mask;
+				} while (subset != 0);
+				table += Bitboard(1) << popcount(m.mask);
+			}
+		}
+
+		// Fills in every table before main runs
+		struct Table_Initializer {
+			Table_Initializer() {
+				for (int square = 0; square < NUM_SQUARES; square++) {
+					knight_table[square] = step_attacks(square, KNIGHT_STEPS, 8);
+					king_table[square] = step_attacks(square, KING_STEPS, 8);
+					pawn_table[0][square] = step_attacks(square, PAWN_CAPTURE_STEPS[0], 2);
+					pawn_table[1][square] = step_attacks(square, PAWN_CAPTURE_STEPS[1], 2);
+				}
+				init_sliders(rook_magics, rook_attack_table, ROOK_DIRECTIONS, ROOK_MAGICS);
+				init_sliders(bishop_magics, bishop_attack_table, BISHOP_DIRECTIONS, BISHOP_MAGICS);
+			}
+		} table_initializer;
+	}
+}
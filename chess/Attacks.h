@@ -0,0 +1,67 @@
+// Hajin Jang, Ju Suk Yoon, Jiewan Hong
+
+#ifndef ATTACKS_H
+#define ATTACKS_H
+
+#ifdef __BMI2__
+#include <immintrin.h>
+#endif // __BMI2__
+#include "Bitboard.h"
+
+namespace Chess
+{
+	// The attack tables of a sliding piece on one square. The squares it
+	// attacks for a given occupancy are looked up by the occupied squares of
+	// its mask (the squares its rays cross, without the board edges): with
+	// PEXT when built for BMI2 (-mbmi2), otherwise with a magic multiply and shift
+	struct Magic {
+		Bitboard mask;
+		Bitboard magic;
+		unsigned shift;
+		const Bitboard* attacks;
+
+		unsigned index(Bitboard occupied) const {
+#ifdef __BMI2__
+			return (unsigned)_pext_u64(occupied, mask);
+#else
+			return (unsigned)(((occupied & mask) * magic) >> shift);
+#endif // __BMI2__
+		}
+	};
+
+	// Tables filled in before main runs, indexed by square (see Bitboard.h)
+	extern Bitboard knight_table[NUM_SQUARES];
+	extern Bitboard king_table[NUM_SQUARES];
+	extern Bitboard pawn_table[2][NUM_SQUARES]; // white, black
+	extern Magic rook_magics[NUM_SQUARES];
+	extern Magic bishop_magics[NUM_SQUARES];
+
+	// Returns the squares a knight on the square attacks
+	inline Bitboard knight_attacks(int square) { return knight_table[square]; }
+
+	// Returns the squares a king on the square attacks
+	inline Bitboard king_attacks(int square) { return king_table[square]; }
+
+	// Returns the squares a white or black pawn on the square can capture on
+	inline Bitboard pawn_attacks(bool white, int square) { return pawn_table[white ? 0 : 1][square]; }
+
+	// Returns the squares a rook on the square attacks, up to and including
+	// the first occupied square in each direction
+	inline Bitboard rook_attacks(int square, Bitboard occupied) {
+		const Magic& m = rook_magics[square];
+		return m.attacks[m.index(occupied)];
+	}
+
+	// Returns the squares a bishop on the square attacks, up to and including
+	// the first occupied square in each direction
+	inline Bitboard bishop_attacks(int square, Bitboard occupied) {
+		const Magic& m = bishop_magics[square];
+		return m.attacks[m.index(occupied)];
+	}
+
+	// Returns the squares a queen on the square attacks
+	inline Bitboard queen_attacks(int square, Bitboard occupied) {
+		return rook_attacks(square, occupied) | bishop_attacks(square, occupied);
+	}
+}
+#endif // ATTACKS_H
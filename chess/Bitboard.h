@@ -0,0 +1,50 @@
+// Hajin Jang, Ju Suk Yoon, Jiewan Hong
+
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <cstdint>
+#include "Piece.h"
+
+namespace Chess
+{
+	// A set of squares, one bit per square. Square 0 is A1, 7 is H1, 8 is A2
+	// and 63 is H8, so a square is 8 * (row - '1') + (column - 'A')
+	typedef uint64_t Bitboard;
+
+	// Number of squares on the board
+	const int NUM_SQUARES = 64;
+
+	// Returns the square of an on-board position
+	inline int square_of(const Position& position) {
+		return 8 * (position.second - '1') + (position.first - 'A');
+	}
+
+	// Returns the position of a square
+	inline Position position_of(int square) {
+		return Position('A' + square % 8, '1' + square / 8);
+	}
+
+	// Returns true if the position is on the board
+	inline bool on_board(const Position& position) {
+		return position.first >= 'A' && position.first <= 'H' && position.second >= '1' && position.second <= '8';
+	}
+
+	// Returns the set holding only the given square
+	inline Bitboard square_bit(int square) {
+		return Bitboard(1) << square;
+	}
+
+	// Returns the number of squares in the set
+	inline int popcount(Bitboard set) {
+		return __builtin_popcountll(set);
+	}
+
+	// Removes the lowest square from a non-empty set and returns it
+	inline int pop_lsb(Bitboard& set) {
+		int square = __builtin_ctzll(set);
+		set &= set - 1;
+		return square;
+	}
+}
+#endif // BITBOARD_H
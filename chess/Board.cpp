@@ -28,12 +28,10 @@ namespace Chess
   const Piece* Board::operator()(const Position& position) const {
     // If piece at "position" exists, return pointer 
     // If not, return nullptr
-    std::map<Position, Piece*>::const_iterator it = occ.find(position);
-
-    if (it == occ.end()) {
+    if (!on_board(position)) {
       return nullptr;
     }
-    return it->second;
+    return mailbox[square_of(position)];
   }
   
   void Board::add_piece(const Position& position, const char& piece_designator) {
@@ -46,7 +44,7 @@ namespace Chess
     }
 
     // // throw invalid position
-    if (position.first < 'A' || position.first > 'H' || position.second < '1' || position.second > '8') {
+    if (!on_board(position)) {
       delete(piece);
       throw Exception("invalid position");
     }
@@ -58,7 +56,9 @@ namespace Chess
     }
 
     // if no errors detected, create new piece using helper function
-    occ[position] = piece;
+    int square = square_of(position);
+    mailbox[square] = piece;
+    toggle_sets(piece, square);
   }
 
   void Board::display() const {
@@ -133,42 +133,70 @@ namespace Chess
   }
 
   void Board::remove_piece(const Position &position) {
-    // find Piece pointer at 'position'
-    std::map<Position, Piece*>::const_iterator it = occ.find(position);
-
     // delete if a piece exists at 'position'
-    if (occ.cend() != it) {
-      delete it->second;
-      occ.erase(position);
+    if (on_board(position) && mailbox[square_of(position)] != nullptr) {
+      int square = square_of(position);
+      toggle_sets(mailbox[square], square);
+      delete mailbox[square];
+      mailbox[square] = nullptr;
     }
   }
 
+  void Board::move_piece(const Position& start, const Position& end) {
+    int from = square_of(start);
+    int to = square_of(end);
+    Piece* piece = mailbox[from];
+
+    // capture whatever stands on the end position
+    remove_piece(end);
+
+    toggle_sets(piece, from);
+    mailbox[from] = nullptr;
+    mailbox[to] = piece;
+    toggle_sets(piece, to);
+  }
+
   void Board::clean() {
-    for (iterator it = this->cbegin(); it != this->cend(); ++it) {	
-      if ((*this)(*it) != nullptr) {
-        delete (*this)(*it);
-      }
+    for (int square = 0; square < NUM_SQUARES; square++) {
+      delete mailbox[square];
+      mailbox[square] = nullptr;
+    }
+    for (int i = 0; i < 12; i++) {
+      piece_sets[i] = 0;
     }
-    occ.clear();
+    color_sets[0] = color_sets[1] = 0;
   }
 
   bool Board::has_valid_kings() const {
-    int white_king_count = 0;
-    int black_king_count = 0;
-    for (std::map<std::pair<char, char>, Piece*>::const_iterator it = occ.begin();
-	    it != occ.end(); it++) {
-      if (it->second) {
-	      switch (it->second->to_ascii()) {
-	        case 'K':
-	          white_king_count++;
-	          break;
-	        case 'k':
-	          black_king_count++;
-	          break;
-	      }
+    return popcount(pieces('K')) == 1 && popcount(pieces('k')) == 1;
+  }
+
+  std::map<Position, Piece*> Board::get_occ() const {
+    std::map<Position, Piece*> occ;
+    for (Bitboard set = occupancy(); set != 0; ) {
+      int square = pop_lsb(set);
+      occ[position_of(square)] = mailbox[square];
+    }
+    return occ;
+  }
+
+  int Board::piece_index(char piece_designator) {
+    static const char designators[] = "KQRBNPkqrbnp";
+    for (int i = 0; i < 12; i++) {
+      if (designators[i] == piece_designator) {
+        return i;
       }
     }
-    return (white_king_count == 1) && (black_king_count == 1);
+    return -1;
+  }
+
+  void Board::toggle_sets(const Piece* piece, int square) {
+    Bitboard bit = square_bit(square);
+    int index = piece_index(piece->to_ascii());
+    if (index >= 0) {
+      piece_sets[index] ^= bit;
+    }
+    color_sets[piece->is_white() ? 0 : 1] ^= bit;
   }
 
   /////////////////////////////////////
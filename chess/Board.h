@@ -5,6 +5,7 @@
 
 #include <iostream>
 #include <map>
+#include "Bitboard.h"
 #include "Piece.h"
 #include "Pawn.h"
 #include "Rook.h"
@@ -53,7 +54,28 @@ namespace Chess
 		// Deallocate all board pieces
 		void clean();
 
-		std::map<Position, Piece*> get_occ() {return occ;}
+		// Moves the piece at start to end, deallocating any piece at end.
+		// Both positions must be on the board and start must be occupied
+		void move_piece(const Position& start, const Position& end);
+
+		// Returns the piece on a square (see Bitboard.h), or nullptr
+		const Piece* at(int square) const { return mailbox[square]; }
+
+		// Returns the squares holding pieces with the specified designator
+		// (always empty for mystery pieces, which only show up in the occupancy)
+		Bitboard pieces(const char& piece_designator) const {
+			int index = piece_index(piece_designator);
+			return index < 0 ? 0 : piece_sets[index];
+		}
+
+		// Returns the squares holding white or black pieces
+		Bitboard occupancy(bool white) const { return color_sets[white ? 0 : 1]; }
+
+		// Returns the occupied squares
+		Bitboard occupancy() const { return color_sets[0] | color_sets[1]; }
+
+		// Returns the pieces keyed off locations, built from the mailbox
+		std::map<Position, Piece*> get_occ() const;
 
 		class iterator {
 			private:
@@ -100,8 +122,21 @@ namespace Chess
 			}
 
 	private:
-		// The sparse map storing the pieces, keyed off locations
-		std::map<Position, Piece*> occ;
+		// The piece on each square, indexed as in Bitboard.h
+		Piece* mailbox[NUM_SQUARES] = {};
+
+		// The squares of each piece type, in the order KQRBNPkqrbnp
+		Bitboard piece_sets[12] = {};
+
+		// The squares of the white and the black pieces
+		Bitboard color_sets[2] = {};
+
+		// Returns the index of a designator into piece_sets, or -1 for
+		// mystery pieces and invalid designators
+		static int piece_index(char piece_designator);
+
+		// Adds or removes a piece on a square in the sets
+		void toggle_sets(const Piece* piece, int square);
 
         // Write the board state to an output stream
         friend std::ostream& operator<< (std::ostream& os, const Board& board);
@@ -2,6 +2,7 @@
 
 #include <cassert>
 #include "Game.h"
+#include "MoveGen.h"
 #include <map>
 
 using std::map;
@@ -90,29 +91,13 @@ namespace Chess
 		}
 
 		// move exposes check
-		Game* copy = copy_game(); // create game replica
-		if (copy->board(end) != NULL) { 
-			copy->board.remove_piece(end);
-		}
-		copy->board.add_piece(end, board(start)->to_ascii());
-		copy->board.remove_piece(start);
-
-		if (copy->in_check(copy->turn_white())) {
-			delete(copy); // free memory allocated to copy before throwing exception
+		if (exposes_check(board, square_of(start), square_of(end))) {
 			throw Exception("move exposes check");
 		}
-		
-		// delete copy when confirmed that move does not expose check
-		delete(copy);
-
-		// if no exceptions thrown and opponent's piece exists at end position, capture
-		if (this->board(end) != NULL) { // already checked that piece at the end is not one's own
-			this->board.remove_piece(end);
-		}
 
-		// update map with changed pointers
-		this->board.add_piece(end, board(start)->to_ascii());
-		board.remove_piece(start);
+		// if no exceptions thrown, move the piece, capturing the opponent's piece
+		// at the end position if any (already checked that it is not one's own)
+		this->board.move_piece(start, end);
 
 		// if pawn reaches the opposite end, promote to Queen
 		if (this->turn_white()) {
@@ -136,81 +121,25 @@ namespace Chess
 	}
 	
 	bool Game::in_check(const bool& white) const {
-		// find white king if white's turn and vice versa using helper function 'find_own_king'
-		Position king_pos = find_own_king(this);
-
-		// iterate over the entire board (from tile A8 to H1)
-		for (Board::iterator it = this->board.cbegin(); it != this->board.cend(); ++it) {
-			if (this->board(*it) != nullptr) {
-				if (white && !(this->board(*it)->is_white())) {
-					if ((clear_path(*it, king_pos, this)) && (legal_capture(*it, king_pos, this))) {
-						return true;
-					}
-				}
-				if (!white && this->board(*it)->is_white()) {
-					if ((clear_path(*it, king_pos, this)) && (legal_capture(*it, king_pos, this))) {
-						return true;
-					}
-				}
-			}
-		} 
-		return false;
+		// look up the attackers of the designated player's king
+		return king_attacked(board, white);
 	}
 
 	bool Game::in_mate(const bool& white) const {
-		// check whether moving any of the player's pieces can escape check
-		if (!this->in_check(this->turn_white())) {
-			return false;
-		}
-
-		for (Board::iterator it = this->board.cbegin(); it != this->board.cend(); ++it) {
-			if (this->board(*it) != nullptr && white == this->board(*it)->is_white()) {
-				for (Board::iterator fit = this->board.cbegin(); fit != this->board.cend(); ++fit) {
-					Game* copy = copy_game();
-					try {
-						copy->make_move(*it, *fit);
-						delete(copy); 
-						return false; 
-					}
-					catch (const std::exception &c) { 
-						delete(copy);
-					}
-				}
-			}
-		} 
-		return true;
+		// in check, and no legal move escapes it
+		return in_check(white) && !has_legal_move(board, white);
 	}
 
 	bool Game::in_stalemate(const bool& white) const {
-		for (Board::iterator it = this->board.cbegin(); it != this->board.cend(); ++it) {
-			if (this->board(*it) != nullptr && white == this->board(*it)->is_white()) {
-				for (Board::iterator fit = this->board.cbegin(); fit != this->board.cend(); ++fit) {
-					Game* copy = copy_game();
-					try {
-						copy->make_move(*it, *fit);
-						delete(copy);
-						return false; 
-					}
-					catch (const std::exception &c) { 
-						delete(copy); 
-					}
-				}
-			}
-		}
-		return true;
+		return !has_legal_move(board, white);
 	}
 
     // Return the total material point value of the designated player
     int Game::point_value(const bool& white) const {
 		int sum = 0;
 
-		for (Board::iterator it = board.cbegin(); it != board.cend(); ++it) {	
-		
-			if (board(*it) != nullptr && white == board(*it)->is_white()) {
-				//char c = board(*it)->to_ascii();
-				sum += board(*it)->point_value();
-			}
-
+		for (Bitboard own = board.occupancy(white); own != 0; ) {
+			sum += board.at(pop_lsb(own))->point_value();
 		}
         return sum;
     }
@@ -435,11 +364,9 @@ namespace Chess
 		new_game->board.clean();
 		new_game->is_white_turn = this->turn_white();
 		
-		for (Board::iterator it = board.cbegin(); it != board.cend(); ++it) {
-			if (board(*it) != nullptr) {
-				char piece_type = board(*it)->to_ascii();
-				(*new_game).board.add_piece(*it, piece_type);
-			}
+		for (Bitboard occupied = board.occupancy(); occupied != 0; ) {
+			int square = pop_lsb(occupied);
+			(*new_game).board.add_piece(position_of(square), board.at(square)->to_ascii());
 		}
 		return new_game;
 	}
@@ -449,18 +376,10 @@ namespace Chess
 	}
 
 	Position Game::find_own_king(const Game* game) const {
-		// iterate over the board to find king
-		for (Board::iterator it = (*game).board.cbegin(); it != (*game).board.cend(); ++it) {
-			if ((*game).board(*it) != nullptr) {
-				// find white king
-				if (game->turn_white() && game->board(*it)->to_ascii() == 'K') {
-					return *it;
-				}
-				// find black king
-				else if (!(game->turn_white()) && game->board(*it)->to_ascii() == 'k') {
-					return *it;
-				}
-			}
+		// look up the white king if white's turn and vice versa
+		Bitboard king = game->board.pieces(game->turn_white() ? 'K' : 'k');
+		if (king != 0) {
+			return position_of(pop_lsb(king));
 		}
 		// return null char (an invalid Position) if there was an error in finding king
 		return std::make_pair('\0', '\0'); // can assume a king always exists as long as not end-of-game
@@ -0,0 +1,123 @@
+// Hajin Jang, Ju Suk Yoon, Jiewan Hong
+
+#include "MoveGen.h"
+#include "Attacks.h"
+
+namespace Chess
+{
+	namespace
+	{
+		// Returns true if a white or black piece attacks the square, given the
+		// occupied squares and the squares whose pieces still stand (a piece
+		// just captured does not attack)
+		bool square_attacked(const Board& board, int square, bool by_white, Bitboard occupied, Bitboard standing) {
+			const char* designators = by_white ? "KQRBNP" : "kqrbnp";
+			Bitboard queens = board.pieces(designators[1]);
+			Bitboard attackers = (king_attacks(square) & board.pieces(designators[0]))
+				| (rook_attacks(square, occupied) & (board.pieces(designators[2]) | queens))
+				| (bishop_attacks(square, occupied) & (board.pieces(designators[3]) | queens))
+				| (knight_attacks(square) & board.pieces(designators[4]))
+				// a pawn attacks the square if a pawn of the other color on the
+				// square would attack the pawn
+				| (pawn_attacks(!by_white, square) & board.pieces(designators[5]));
+			return (attackers & standing) != 0;
+		}
+
+		// Returns the squares the piece on from can move to, ignoring checks
+		Bitboard move_targets(const Board& board, int from) {
+			const Piece* piece = board.at(from);
+			bool white = piece->is_white();
+			Bitboard occupied = board.occupancy();
+			Bitboard targets = 0;
+
+			switch (piece->to_ascii()) {
+				case 'K': case 'k':
+					targets = king_attacks(from);
+					break;
+				case 'Q': case 'q':
+					targets = queen_attacks(from, occupied);
+					break;
+				case 'R': case 'r':
+					targets = rook_attacks(from, occupied);
+					break;
+				case 'B': case 'b':
+					targets = bishop_attacks(from, occupied);
+					break;
+				case 'N': case 'n':
+					targets = knight_attacks(from);
+					break;
+				case 'P': case 'p': {
+					// capture diagonally forward, move straight forward onto empty
+					// squares, two of them from the starting row
+					targets = pawn_attacks(white, from) & board.occupancy(!white);
+					int forward = white ? 8 : -8;
+					int one = from + forward;
+					if (one >= 0 && one < NUM_SQUARES && !(occupied & square_bit(one))) {
+						targets |= square_bit(one);
+						int two = one + forward;
+						if (from / 8 == (white ? 1 : 6) && !(occupied & square_bit(two))) {
+							targets |= square_bit(two);
+						}
+					}
+					break;
+				}
+				default:
+					// mystery pieces never move
+					break;
+			}
+			return targets & ~board.occupancy(white);
+		}
+
+		// Appends the legal moves to moves, or if moves is nullptr stops at the
+		// first one. Returns the number of moves found
+		int generate(const Board& board, bool white, std::vector<Move>* moves) {
+			int count = 0;
+			for (Bitboard own = board.occupancy(white); own != 0; ) {
+				int from = pop_lsb(own);
+				for (Bitboard targets = move_targets(board, from); targets != 0; ) {
+					int to = pop_lsb(targets);
+					if (exposes_check(board, from, to)) {
+						continue;
+					}
+					count++;
+					if (moves == nullptr) {
+						return count;
+					}
+					Move move = {from, to};
+					moves->push_back(move);
+				}
+			}
+			return count;
+		}
+	}
+
+	void legal_moves(const Board& board, bool white, std::vector<Move>& moves) {
+		generate(board, white, &moves);
+	}
+
+	bool has_legal_move(const Board& board, bool white) {
+		return generate(board, white, nullptr) > 0;
+	}
+
+	bool king_attacked(const Board& board, bool white) {
+		Bitboard king = board.pieces(white ? 'K' : 'k');
+		if (king == 0) {
+			return false;
+		}
+		return square_attacked(board, pop_lsb(king), !white, board.occupancy(), ~Bitboard(0));
+	}
+
+	bool exposes_check(const Board& board, int from, int to) {
+		const Piece* piece = board.at(from);
+		bool white = piece->is_white();
+		Bitboard king = board.pieces(white ? 'K' : 'k');
+		if (king == 0) {
+			return false;
+		}
+		int king_square = (king & square_bit(from)) ? to : pop_lsb(king);
+
+		// the board after the move, as far as the attacks on the king go
+		Bitboard occupied = (board.occupancy() & ~square_bit(from)) | square_bit(to);
+		return square_attacked(board, king_square, !white, occupied, ~square_bit(to));
+	}
+}
@@ -0,0 +1,34 @@
+// Hajin Jang, Ju Suk Yoon, Jiewan Hong
+
+#ifndef MOVE_GEN_H
+#define MOVE_GEN_H
+
+#include <vector>
+#include "Bitboard.h"
+#include "Board.h"
+
+namespace Chess
+{
+	// A move of the piece on the from square to the to square (see Bitboard.h)
+	struct Move {
+		int from;
+		int to;
+	};
+
+	// Appends the legal moves of the white or black pieces to moves, as if it
+	// were their turn. These are exactly the moves Game::make_move accepts:
+	// no castling or en passant, and mystery pieces never move
+	void legal_moves(const Board& board, bool white, std::vector<Move>& moves);
+
+	// Returns true if the white or black pieces have a legal move
+	bool has_legal_move(const Board& board, bool white);
+
+	// Returns true if the white or black king is attacked (false if it is
+	// missing from the board)
+	bool king_attacked(const Board& board, bool white);
+
+	// Returns true if moving the piece on from to to, capturing whatever
+	// stands there, would leave the mover's king attacked
+	bool exposes_check(const Board& board, int from, int to);
+}
+#endif // MOVE_GEN_H